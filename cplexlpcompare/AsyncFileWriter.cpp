@@ -0,0 +1,223 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#include "AsyncFileWriter.h"
+
+#include <algorithm>
+#include <iostream>
+
+#ifdef LPCOMPARE_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+/**
+\file AsyncFileWriter.cpp
+Implements AsyncFileWriter class.
+*/
+
+namespace lpcompare {
+
+	/**
+	Checks if this build can compress output.
+
+	\return true if zstd compression is available.
+	*/
+	bool AsyncFileWriter::CompressionAvailable() {
+#ifdef LPCOMPARE_HAVE_ZSTD
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	AsyncFileWriter::~AsyncFileWriter() {
+		Close();
+	}
+
+	/**
+	Creates a file and starts the writer thread.
+
+	\param filename File to create.
+	\param compress Compress the file with zstd.
+	\param bufferSize Size of a buffer handed to the writer thread.
+	\return false if the file cannot be created or compression is not available.
+	*/
+	bool AsyncFileWriter::Open(const std::string &filename, bool compress, std::size_t bufferSize) {
+
+		if (compress && !CompressionAvailable()) {
+			std::cout << "zstd compression is not available in this build." << std::endl;
+			return false;
+		}
+
+		file = std::fopen(filename.c_str(), "wb");
+
+		if (file == nullptr)
+			return false;
+
+#ifdef LPCOMPARE_HAVE_ZSTD
+		if (compress) {
+			auto stream = ZSTD_createCStream();
+			ZSTD_initCStream(stream, 3);
+			compressor = stream;
+		}
+#endif
+
+		this->bufferSize = std::max<std::size_t>(bufferSize, 4096);
+		current.reserve(this->bufferSize);
+		closing = false;
+		failed = false;
+		writer = std::thread(&AsyncFileWriter::WriterLoop, this);
+
+		return true;
+	}
+
+	/**
+	Hands the current buffer to the writer thread, waiting if it is too far behind.
+	*/
+	void AsyncFileWriter::QueueCurrent() {
+
+		std::unique_lock<std::mutex> lock(mutex);
+		bufferWritten.wait(lock, [this] { return queue.size() < MaxQueuedBuffers; });
+
+		queue.push_back(std::move(current));
+
+		if (!spares.empty()) {
+			current = std::move(spares.back());
+			spares.pop_back();
+		}
+		else {
+			current = std::string();
+			current.reserve(bufferSize);
+		}
+
+		bufferQueued.notify_one();
+	}
+
+	/**
+	Writes queued buffers until the writer is closed.
+	*/
+	void AsyncFileWriter::WriterLoop() {
+
+		for (;;) {
+			std::string buffer;
+			bool last;
+
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				bufferQueued.wait(lock, [this] { return closing || !queue.empty(); });
+
+				if (queue.empty())
+					break;
+
+				buffer = std::move(queue.front());
+				queue.pop_front();
+				last = closing && queue.empty();
+			}
+
+			bool ok = WriteBuffer(buffer, last);
+
+			std::lock_guard<std::mutex> lock(mutex);
+			failed = failed || !ok;
+			buffer.clear();
+			spares.push_back(std::move(buffer));
+			bufferWritten.notify_one();
+
+			if (last)
+				break;
+		}
+	}
+
+	/**
+	Writes a buffer to the file, compressing it if requested.
+
+	\param buffer Bytes to write.
+	\param last Finish the compressed frame after this buffer.
+	\return false on a write error.
+	*/
+	bool AsyncFileWriter::WriteBuffer(const std::string &buffer, bool last) {
+
+#ifdef LPCOMPARE_HAVE_ZSTD
+		if (compressor != nullptr) {
+			auto stream = static_cast<ZSTD_CStream*>(compressor);
+			std::vector<char> out(ZSTD_CStreamOutSize());
+			ZSTD_inBuffer input = { buffer.data(), buffer.size(), 0 };
+
+			for (;;) {
+				ZSTD_outBuffer output = { out.data(), out.size(), 0 };
+				auto remaining = ZSTD_compressStream2(stream, &output, &input, last ? ZSTD_e_end : ZSTD_e_continue);
+
+				if (ZSTD_isError(remaining))
+					return false;
+
+				if (output.pos > 0 && std::fwrite(out.data(), 1, output.pos, file) != output.pos)
+					return false;
+
+				if (last ? remaining == 0 : input.pos == input.size)
+					return true;
+			}
+		}
+#else
+		(void) last;
+#endif
+
+		return buffer.empty() || std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+	}
+
+	/**
+	Writes the remaining bytes, stops the writer thread and closes the file.
+
+	\return false if any write failed.
+	*/
+	bool AsyncFileWriter::Close() {
+
+		if (file == nullptr)
+			return !failed;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			// the last buffer is always queued, possibly empty, to finish a compressed frame.
+			queue.push_back(std::move(current));
+			current = std::string();
+			closing = true;
+		}
+		bufferQueued.notify_one();
+
+		writer.join();
+
+#ifdef LPCOMPARE_HAVE_ZSTD
+		if (compressor != nullptr) {
+			ZSTD_freeCStream(static_cast<ZSTD_CStream*>(compressor));
+			compressor = nullptr;
+		}
+#endif
+
+		failed = std::fclose(file) != 0 || failed;
+		file = nullptr;
+		queue.clear();
+		spares.clear();
+
+		return !failed;
+	}
+}
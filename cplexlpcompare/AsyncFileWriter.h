@@ -0,0 +1,132 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef ASYNCFILEWRITER_H
+#define ASYNCFILEWRITER_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lpcompare {
+
+	/**
+	\class AsyncFileWriter
+	Writes a file through large buffers on a dedicated writer thread, optionally compressed with zstd.
+	Writers block only when the writer thread is more than a few buffers behind.
+	*/
+	class AsyncFileWriter {
+
+		std::FILE *file = nullptr;
+		std::thread writer;
+		std::mutex mutex;
+		std::condition_variable bufferQueued;
+		std::condition_variable bufferWritten;
+		std::deque<std::string> queue; /**< Full buffers waiting to be written. */
+		std::vector<std::string> spares; /**< Written buffers kept for reuse. */
+		std::string current; /**< Buffer being filled. */
+		std::size_t bufferSize = 0;
+		bool closing = false;
+		bool failed = false;
+		void *compressor = nullptr; /**< ZSTD_CStream when compressing. */
+
+		static const std::size_t MaxQueuedBuffers = 4;
+
+		void WriterLoop();
+		bool WriteBuffer(const std::string &buffer, bool last);
+		void QueueCurrent();
+
+	public:
+
+		AsyncFileWriter() {}
+		~AsyncFileWriter();
+
+		AsyncFileWriter(const AsyncFileWriter&) = delete;
+		AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+
+		bool Open(const std::string &filename, bool compress, std::size_t bufferSize = 4 * 1024 * 1024);
+		bool Close();
+
+		/**
+		Appends bytes to the current buffer.
+
+		\param data Bytes to write.
+		\param size Number of bytes.
+		*/
+		void Write(const char *data, std::size_t size) {
+			while (size > 0) {
+				auto n = std::min(size, bufferSize - current.size());
+				current.append(data, n);
+				data += n;
+				size -= n;
+
+				if (current.size() == bufferSize)
+					QueueCurrent();
+			}
+		}
+
+		void Write(const std::string &data) {
+			Write(data.data(), data.size());
+		}
+
+		static bool CompressionAvailable();
+	};
+
+	/**
+	\class WriterStreamBuf
+	Stream buffer forwarding to an AsyncFileWriter, so that operator<< can write to it without flushes.
+	*/
+	class WriterStreamBuf : public std::streambuf {
+
+		AsyncFileWriter &writer;
+
+	protected:
+
+		int_type overflow(int_type ch) override {
+			if (ch != traits_type::eof()) {
+				char c = traits_type::to_char_type(ch);
+				writer.Write(&c, 1);
+			}
+			return ch;
+		}
+
+		std::streamsize xsputn(const char *s, std::streamsize n) override {
+			writer.Write(s, static_cast<std::size_t>(n));
+			return n;
+		}
+
+	public:
+
+		explicit WriterStreamBuf(AsyncFileWriter &writer) : writer(writer) {}
+	};
+}
+
+#endif // ASYNCFILEWRITER_H
@@ -0,0 +1,151 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef BINARYIO_H
+#define BINARYIO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+/**
+\file BinaryIO.h
+Defines helpers to append and read little-endian binary fields. Multi-byte values are always
+stored little-endian, regardless of the host.
+*/
+
+namespace lpcompare {
+
+	inline void AppendU8(std::string &out, std::uint8_t value) {
+		out.push_back(static_cast<char>(value));
+	}
+
+	inline void AppendU32(std::string &out, std::uint32_t value) {
+		for (int i = 0; i < 4; i++)
+			out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+	}
+
+	inline void AppendU64(std::string &out, std::uint64_t value) {
+		for (int i = 0; i < 8; i++)
+			out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+	}
+
+	inline void AppendF32(std::string &out, float value) {
+		std::uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		AppendU32(out, bits);
+	}
+
+	inline void AppendF64(std::string &out, double value) {
+		std::uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		AppendU64(out, bits);
+	}
+
+	/**
+	Appends a string as a 32-bit length followed by its bytes.
+	*/
+	inline void AppendString(std::string &out, const std::string &value) {
+		AppendU32(out, static_cast<std::uint32_t>(value.size()));
+		out.append(value);
+	}
+
+	/**
+	\class BinaryReader
+	Reads little-endian binary fields from a buffer. Reads past the end of the buffer
+	return zeros and clear Good.
+	*/
+	class BinaryReader {
+
+		const std::string &data;
+		std::size_t position = 0;
+
+		bool Take(std::size_t size) {
+			if (!Good || data.size() - position < size) {
+				Good = false;
+				return false;
+			}
+			return true;
+		}
+
+	public:
+
+		bool Good = true;
+
+		explicit BinaryReader(const std::string &data) : data(data) {}
+
+		bool AtEnd() const { return position == data.size(); }
+
+		std::uint8_t ReadU8() {
+			if (!Take(1))
+				return 0;
+			return static_cast<std::uint8_t>(data[position++]);
+		}
+
+		std::uint32_t ReadU32() {
+			if (!Take(4))
+				return 0;
+			std::uint32_t value = 0;
+			for (int i = 0; i < 4; i++)
+				value |= static_cast<std::uint32_t>(static_cast<unsigned char>(data[position++])) << (8 * i);
+			return value;
+		}
+
+		std::uint64_t ReadU64() {
+			if (!Take(8))
+				return 0;
+			std::uint64_t value = 0;
+			for (int i = 0; i < 8; i++)
+				value |= static_cast<std::uint64_t>(static_cast<unsigned char>(data[position++])) << (8 * i);
+			return value;
+		}
+
+		float ReadF32() {
+			auto bits = ReadU32();
+			float value;
+			std::memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+		double ReadF64() {
+			auto bits = ReadU64();
+			double value;
+			std::memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+		std::string ReadString() {
+			auto size = ReadU32();
+			if (!Take(size))
+				return std::string();
+			auto value = data.substr(position, size);
+			position += size;
+			return value;
+		}
+	};
+}
+
+#endif // BINARYIO_H
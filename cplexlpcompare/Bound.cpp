@@ -29,6 +29,9 @@
 #include <boost/regex.hpp>
 #include <boost/algorithm/string.hpp>
 
+#include <cstdio>
+#include <limits>
+
 /**
 \file Bound.cpp
 Implements Bound class.
@@ -166,22 +169,30 @@ namespace lpcompare {
 	}
 
 	/**
-	 Parses a line of the LP file representing a Bound.
+	 Parses a line of the LP file representing a Bound. A free variable gets a lower bound of -infinity,
+	 the same as <tt>-inf <= x</tt>.
 
 	 \param line Single line of an LP file.
 	 \return A Bound instance representing line.
 	 */
 	Bound *Bound::Parse(std::string line){
 
-		Bound *ret = new Bound();
-
 		std::vector<std::string> parts;
 		trim(line);
 		::split(line, ' ', parts, [](const std::string& s) -> bool { return s.length() > 0; });
 
-		if (parts.size() == 0)
+		if (parts.size() < 2)
+			return nullptr;
+
+		cmatch what;
+		bool isVarName = regex_match(parts[0].c_str(), what, re_varname);
+
+		// only a free variable has no value, e.g. x free.
+		if (parts.size() < 3 && !(isVarName && get_boundop(parts[1]) == BoundOp::Free))
 			return nullptr;
 
+		Bound *ret = new Bound();
+
 		// clean this setBounds mess.
 		auto setBounds = [&ret](BoundOp op, std::string s, bool inverted) {
 			auto check_op = inverted ? invert(op) : op;
@@ -202,15 +213,14 @@ namespace lpcompare {
 			}
 		};
 
-		cmatch what;
-		bool isVarName = regex_match(parts[0].c_str(), what, re_varname);
-
 		if (isVarName){
 			ret->VarName = parts[0];
 
 			auto op = get_boundop(parts[1]);
-			if (op != BoundOp::Free)
-				setBounds(invert(op), parts[2], false);
+			if (op == BoundOp::Free)
+				ret->LB = -std::numeric_limits<float>::infinity();
+			else
+				setBounds(op == BoundOp::EQ ? op : invert(op), parts[2], false);
 		}
 		else{
 			auto op = get_boundop(parts[1]);
@@ -233,16 +243,48 @@ namespace lpcompare {
 	}
 
 	/**
-	 Dumps a Bound instance to an ostream in a text format.
+	 Dumps a Bound instance to an ostream in a text format, followed by its location and
+	 original text if known.
 	 \param bound Bound to dump.
 	 \param out
+	 \param source Original text of the bound, Source.Length bytes, nullptr to leave it out.
 	 */
-	void Bound::dump(const Bound &bound, std::ostream &out) {
+	void Bound::dump(const Bound &bound, std::ostream &out, const char *source) {
 
 		out << bound.LB << " " << get_boundop(bound.LB_Op) << " ";
 		out << bound.VarName;
 
 		if (bound.UB != INFTY)
 			out << " " << get_boundop(invert(bound.UB_Op)) << " " << bound.UB;
+
+		WriteLocation(bound.Source, out);
+
+		if (source != nullptr)
+			WriteSourceText(source, bound.Source.Length, " ", out);
+	}
+
+	/**
+	 Writes a Bound instance to an ostream as a line of an LP file, which parses back to the same Bound.
+	 \param bound Bound to write.
+	 \param out
+	 */
+	void Bound::writeLP(const Bound &bound, std::ostream &out) {
+
+		if (bound.LB == -std::numeric_limits<float>::infinity() && bound.LB_Op == BoundOp::LTE && bound.UB == INFTY) {
+			out << " " << bound.VarName << " free\n";
+			return;
+		}
+
+		char number[32];
+
+		std::snprintf(number, sizeof(number), "%.9g", bound.LB);
+		out << " " << number << " " << get_boundop(bound.LB_Op) << " " << bound.VarName;
+
+		if (bound.LB_Op != BoundOp::EQ && bound.UB != INFTY) {
+			std::snprintf(number, sizeof(number), "%.9g", bound.UB);
+			out << " " << get_boundop(invert(bound.UB_Op)) << " " << number;
+		}
+
+		out << '\n';
 	}
 }
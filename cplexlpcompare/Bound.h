@@ -28,6 +28,8 @@
 
 #include <string>
 
+#include "SourceLocation.h"
+
 namespace lpcompare {
 
 	/**
@@ -60,13 +62,16 @@ namespace lpcompare {
 
 		std::string VarName;
 
+		SourceLocation Source; /**< Where the bound was read from, not compared. */
+
 		Bound() : UB_Op(BoundOp::LTE), LB_Op(BoundOp::LTE), LB(0), UB(INFTY) {}
 		static Bound *Parse(std::string line);
 		bool operator==(const Bound &other) const;
 		bool operator<(const Bound &other) const;
 		bool operator!=(const Bound &other) const;
 
-		static void dump(const Bound &cons, std::ostream &out);
+		static void dump(const Bound &cons, std::ostream &out, const char *source = nullptr);
+		static void writeLP(const Bound &bound, std::ostream &out);
 
 		Bound& operator=(const Bound& element) {
 			LB = element.LB;
@@ -74,6 +79,7 @@ namespace lpcompare {
 			UB_Op = element.UB_Op;
 			LB_Op = element.LB_Op;
 			VarName = element.VarName;
+			Source = element.Source;
 
 			return *this;
 		}
@@ -84,6 +90,10 @@ namespace lpcompare {
 			return output;
 		}
 	};
+
+	BoundOp invert(BoundOp op);
+	BoundOp get_boundop(std::string op);
+	std::string get_boundop(BoundOp op);
 }
 
 #endif // BOUND_H
\ No newline at end of file
@@ -0,0 +1,452 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#include "CanonicalWriter.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <sstream>
+#include <boost/filesystem.hpp>
+
+#include "AsyncFileWriter.h"
+
+/**
+\file CanonicalWriter.cpp
+Implements CanonicalWriter class.
+*/
+
+using std::cout;
+
+namespace lpcompare {
+
+	/**
+	First byte of a sort record, orders the sections as they are written.
+	*/
+	const char RECORD_CONSTRAINT = '1';
+	const char RECORD_BOUND = '2';
+	const char RECORD_GENERAL = '3';
+	const char RECORD_BINARY = '4';
+	const char RECORD_SOS = '5';
+
+	const std::size_t RUN_BUFFER_SIZE = 1 << 20; /**< Read buffer of a run file during the merge. */
+
+	/**
+	Estimates the heap and inline bytes of a string.
+
+	\param s String.
+	\return Estimated bytes.
+	*/
+	static std::size_t string_size(const std::string &s) {
+		return sizeof(std::string) + (s.capacity() > 15 ? s.capacity() : 0);
+	}
+
+	/**
+	Creates a writer.
+
+	\param memoryCap Estimated bytes of buffered elements and their sort records before a run is spilled.
+	\param threads Threads formatting and sorting runs, 0 for one per hardware thread.
+	\param spillDirectory Directory of run files, the temporary directory if empty.
+	*/
+	CanonicalWriter::CanonicalWriter(std::size_t memoryCap, unsigned threads, const std::string &spillDirectory)
+		: memoryCap(memoryCap), spillDirectory(spillDirectory), pool(threads)
+	{
+		if (this->spillDirectory.empty())
+			this->spillDirectory = boost::filesystem::temp_directory_path().string();
+	}
+
+	/**
+	Removes run files left by a failed or unfinished write.
+	*/
+	CanonicalWriter::~CanonicalWriter() {
+		boost::system::error_code ec;
+		for (const auto &run : runFiles)
+			boost::filesystem::remove(run, ec);
+	}
+
+	void CanonicalWriter::AddGeneral(std::string name) {
+		Buffered(string_size(name));
+		generals.push_back(std::move(name));
+	}
+
+	void CanonicalWriter::AddBinary(std::string name) {
+		Buffered(string_size(name));
+		binaries.push_back(std::move(name));
+	}
+
+	void CanonicalWriter::AddSosVar(std::string name) {
+		Buffered(string_size(name));
+		sosVars.push_back(std::move(name));
+	}
+
+	void CanonicalWriter::AddBound(Bound bound) {
+		Buffered(sizeof(Bound) + sizeof(std::uint64_t) + string_size(bound.VarName));
+		bounds.push_back(std::move(bound));
+		boundSequences.push_back(boundCount++);
+	}
+
+	void CanonicalWriter::AddConstraint(Constraint cons) {
+		auto size = sizeof(Constraint) + string_size(cons.Name);
+		for (const auto &term : cons.GetTerms())
+			size += sizeof(Term) + string_size(term.varName);
+
+		Buffered(size);
+		constraints.push_back(std::move(cons));
+	}
+
+	/**
+	Accounts for a buffered element, spills a run when the buffers take half of the memory cap,
+	leaving the other half to the sort records.
+
+	\param bytes Estimated bytes of the element.
+	*/
+	void CanonicalWriter::Buffered(std::size_t bytes) {
+		bufferedBytes += bytes;
+
+		if (bufferedBytes > memoryCap / 2 && !failed)
+			failed = !Spill();
+	}
+
+	/**
+	Formats the buffered elements into sort records on the pool and clears the buffers. A record
+	starts with its section byte, a bound record continues with the variable name and the sequence
+	number of the bound, separated by tabs, before the line to write.
+
+	\param records Receives the records, unsorted.
+	*/
+	void CanonicalWriter::FormatRecords(std::vector<std::string> &records) {
+
+		std::size_t boundsAt = constraints.size();
+		std::size_t generalsAt = boundsAt + bounds.size();
+		std::size_t binariesAt = generalsAt + generals.size();
+		std::size_t sosAt = binariesAt + binaries.size();
+
+		records.clear();
+		records.resize(sosAt + sosVars.size());
+
+		pool.ParallelFor(records.size(), 4096, [&](std::size_t begin, std::size_t end) {
+
+			std::ostringstream out;
+			char sequence[24];
+
+			for (auto i = begin; i < end; i++) {
+				auto &record = records[i];
+
+				if (i < boundsAt) {
+					out.str("");
+					Constraint::writeLP(constraints[i], out);
+					record = RECORD_CONSTRAINT + out.str();
+					record.pop_back();
+				}
+				else if (i < generalsAt) {
+					const auto &bound = bounds[i - boundsAt];
+					out.str("");
+					Bound::writeLP(bound, out);
+					std::snprintf(sequence, sizeof(sequence), "\t%016" PRIx64 "\t", boundSequences[i - boundsAt]);
+					record = RECORD_BOUND + bound.VarName + sequence + out.str();
+					record.pop_back();
+				}
+				else if (i < binariesAt)
+					record = RECORD_GENERAL + generals[i - generalsAt];
+				else if (i < sosAt)
+					record = RECORD_BINARY + binaries[i - binariesAt];
+				else
+					record = RECORD_SOS + sosVars[i - sosAt];
+			}
+		});
+
+		std::vector<Constraint>().swap(constraints);
+		std::vector<Bound>().swap(bounds);
+		std::vector<std::uint64_t>().swap(boundSequences);
+		std::vector<std::string>().swap(generals);
+		std::vector<std::string>().swap(binaries);
+		std::vector<std::string>().swap(sosVars);
+		bufferedBytes = 0;
+	}
+
+	/**
+	Sorts records on the pool: slices are sorted in parallel, then merged pairwise.
+
+	\param records Records to sort.
+	*/
+	void CanonicalWriter::SortRecords(std::vector<std::string> &records) {
+
+		std::size_t slices = std::max<std::size_t>(pool.Size(), 1);
+		std::size_t slice = (records.size() + slices - 1) / slices;
+
+		if (slice == 0)
+			return;
+
+		pool.ParallelFor(records.size(), slice, [&records](std::size_t begin, std::size_t end) {
+			std::sort(records.begin() + begin, records.begin() + end);
+		});
+
+		for (; slice < records.size(); slice *= 2) {
+			pool.ParallelFor(records.size(), 2 * slice, [&records, slice](std::size_t begin, std::size_t end) {
+				if (begin + slice < end)
+					std::inplace_merge(records.begin() + begin, records.begin() + begin + slice, records.begin() + end);
+			});
+		}
+	}
+
+	/**
+	Formats, sorts and writes the buffered elements to a new run file.
+
+	\return false if the run file cannot be written.
+	*/
+	bool CanonicalWriter::Spill() {
+
+		std::vector<std::string> records;
+		FormatRecords(records);
+		SortRecords(records);
+
+		auto filename = (boost::filesystem::path(spillDirectory)
+			/ boost::filesystem::unique_path("lpcompare-run-%%%%-%%%%-%%%%.txt")).string();
+
+		AsyncFileWriter writer;
+
+		if (!writer.Open(filename, false)) {
+			cout << "Cannot open or create file for writing: " << filename << std::endl;
+			return false;
+		}
+
+		runFiles.push_back(filename);
+
+		for (const auto &record : records) {
+			writer.Write(record);
+			writer.Write("\n", 1);
+		}
+
+		if (!writer.Close()) {
+			cout << "Cannot write file: " << filename << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	/**
+	Sorted records of a run file or of the last buffer, read in order during the merge.
+	*/
+	class RunSource {
+		std::unique_ptr<char[]> buffer;
+		std::ifstream file;
+		std::vector<std::string> *records = nullptr;
+		std::size_t next = 0;
+
+	public:
+		std::string Current;
+
+		bool Open(const std::string &filename) {
+			buffer.reset(new char[RUN_BUFFER_SIZE]);
+			file.rdbuf()->pubsetbuf(buffer.get(), RUN_BUFFER_SIZE);
+			file.open(filename, std::ios::binary);
+			return file.is_open();
+		}
+
+		void Open(std::vector<std::string> &memory) {
+			records = &memory;
+		}
+
+		bool Next() {
+			if (records != nullptr) {
+				if (next == records->size())
+					return false;
+				Current = std::move((*records)[next++]);
+				return true;
+			}
+
+			return static_cast<bool>(std::getline(file, Current));
+		}
+	};
+
+	/**
+	Sets the bounds of a variable that a later bound of the same variable gives.
+
+	\param merged Bound merged so far.
+	\param bound Later bound.
+	*/
+	static void merge_bound(Bound &merged, const Bound &bound) {
+
+		if (bound.LB_Op == BoundOp::EQ) {
+			merged = bound;
+			return;
+		}
+
+		Bound unset;
+
+		// a fixed variable keeps the side that the later bound does not set.
+		if (merged.LB_Op == BoundOp::EQ) {
+			merged.LB_Op = unset.LB_Op;
+			merged.UB_Op = BoundOp::GTE;
+		}
+
+		if (bound.LB != unset.LB || bound.LB_Op != unset.LB_Op) {
+			merged.LB = bound.LB;
+			merged.LB_Op = bound.LB_Op;
+		}
+
+		if (bound.UB != unset.UB) {
+			merged.UB = bound.UB;
+			merged.UB_Op = bound.UB_Op;
+		}
+	}
+
+	/**
+	Formats the remaining buffered elements and merges them with the spilled runs into a canonical
+	LP file. Bound records of a variable are adjacent in the merge and are merged into one bound.
+	Run files are removed afterwards.
+
+	\param filename Path of the LP file to write.
+	\return false if a run or the output cannot be read or written.
+	*/
+	bool CanonicalWriter::Finish(const std::string &filename) {
+
+		if (failed)
+			return false;
+
+		std::vector<std::string> last;
+		FormatRecords(last);
+		SortRecords(last);
+
+		std::vector<std::unique_ptr<RunSource>> sources;
+
+		for (const auto &run : runFiles) {
+			sources.emplace_back(new RunSource());
+			if (!sources.back()->Open(run)) {
+				cout << "Cannot open file: " << run << std::endl;
+				return false;
+			}
+		}
+
+		sources.emplace_back(new RunSource());
+		sources.back()->Open(last);
+
+		auto greater = [&sources](std::size_t a, std::size_t b) { return sources[b]->Current < sources[a]->Current; };
+		std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(greater)> heap(greater);
+
+		for (std::size_t i = 0; i < sources.size(); i++)
+			if (sources[i]->Next())
+				heap.push(i);
+
+		AsyncFileWriter writer;
+
+		if (!writer.Open(filename, false)) {
+			cout << "Cannot open or create file for writing: " << filename << std::endl;
+			return false;
+		}
+
+		writer.Write("\\ Canonical form written by lpcompare\n");
+		writer.Write(Objective.empty() ? std::string("Minimize\n obj:\n") : Objective);
+
+		char section = 0;
+		std::string boundName;
+		std::unique_ptr<Bound> merged;
+		std::ostringstream out;
+
+		auto write_bound = [&]() {
+			if (merged) {
+				out.str("");
+				Bound::writeLP(*merged, out);
+				writer.Write(out.str());
+				merged.reset();
+			}
+		};
+
+		while (!heap.empty()) {
+			auto source = heap.top();
+			heap.pop();
+
+			const auto &record = sources[source]->Current;
+
+			if (record[0] != RECORD_BOUND)
+				write_bound();
+
+			if (record[0] != section) {
+				section = record[0];
+
+				switch (section) {
+				case RECORD_CONSTRAINT: writer.Write("Subject To\n"); break;
+				case RECORD_BOUND: writer.Write("Bounds\n"); break;
+				case RECORD_GENERAL: writer.Write("Generals\n"); break;
+				case RECORD_BINARY: writer.Write("Binaries\n"); break;
+				case RECORD_SOS: writer.Write("SOS\n"); break;
+				default: break;
+				}
+			}
+
+			if (section == RECORD_BOUND) {
+				auto nameEnd = record.find('\t');
+				auto lineAt = record.find('\t', nameEnd + 1) + 1;
+
+				if (!merged || record.compare(1, nameEnd - 1, boundName) != 0) {
+					write_bound();
+					boundName.assign(record, 1, nameEnd - 1);
+				}
+
+				std::unique_ptr<Bound> bound(Bound::Parse(record.substr(lineAt)));
+
+				if (bound) {
+					if (merged)
+						merge_bound(*merged, *bound);
+					else
+						merged = std::move(bound);
+				}
+			}
+			else if (section == RECORD_CONSTRAINT) {
+				writer.Write(record.data() + 1, record.size() - 1);
+				writer.Write("\n", 1);
+			}
+			else {
+				writer.Write(" ", 1);
+				writer.Write(record.data() + 1, record.size() - 1);
+				writer.Write("\n", 1);
+			}
+
+			if (sources[source]->Next())
+				heap.push(source);
+		}
+
+		write_bound();
+		writer.Write("End\n");
+
+		sources.clear();
+
+		boost::system::error_code ec;
+		for (const auto &run : runFiles)
+			boost::filesystem::remove(run, ec);
+
+		if (!writer.Close()) {
+			cout << "Cannot write file: " << filename << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,97 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef CANONICALWRITER_H
+#define CANONICALWRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "LPModel.h"
+#include "ThreadPool.h"
+
+namespace lpcompare {
+
+	/**
+	\class CanonicalWriter
+	Writes a model as a canonical LP file: constraints sorted by their text, terms sorted within
+	each row, bounds merged into one per variable and sorted by variable, variables sorted by name,
+	numbers printed as by Constraint::writeLP and Bound::writeLP. Two models with the same elements
+	give the same file whatever their order, hence canonical files can be compared with line tools.
+	The objective is not parsed, it is written as the text set in Objective.
+
+	Elements are sorted externally so that models larger than memory can be written. Received
+	elements are buffered up to a memory cap, then formatted in parallel into sort records, sorted
+	and spilled to a run file. Finish merges the runs and the last buffer k ways into the output,
+	which is written through an AsyncFileWriter.
+	*/
+	class CanonicalWriter : public ModelSink {
+
+		std::size_t memoryCap;
+		std::string spillDirectory;
+		ThreadPool pool;
+
+		std::vector<Constraint> constraints;
+		std::vector<Bound> bounds;
+		std::vector<std::uint64_t> boundSequences; /**< Position of each bound in the model, later bounds override earlier ones. */
+		std::vector<std::string> generals;
+		std::vector<std::string> binaries;
+		std::vector<std::string> sosVars;
+		std::size_t bufferedBytes = 0;
+		std::uint64_t boundCount = 0;
+
+		std::vector<std::string> runFiles;
+		bool failed = false;
+
+		void Buffered(std::size_t bytes);
+		void FormatRecords(std::vector<std::string> &records);
+		void SortRecords(std::vector<std::string> &records);
+		bool Spill();
+
+	public:
+
+		std::string Objective; /**< Objective section written as it is, with its Minimize or Maximize line. An empty objective is minimized if not set. */
+
+		CanonicalWriter(std::size_t memoryCap, unsigned threads = 0, const std::string &spillDirectory = "");
+		~CanonicalWriter();
+
+		CanonicalWriter(const CanonicalWriter&) = delete;
+		CanonicalWriter& operator=(const CanonicalWriter&) = delete;
+
+		void AddGeneral(std::string name) override;
+		void AddBinary(std::string name) override;
+		void AddSosVar(std::string name) override;
+		void AddBound(Bound bound) override;
+		void AddConstraint(Constraint cons) override;
+
+		bool Finish(const std::string &filename);
+
+		std::size_t RunCount() const { return runFiles.size(); } /**< Runs spilled to disk so far. */
+	};
+}
+
+#endif // CANONICALWRITER_H
@@ -0,0 +1,261 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#include "ColumnReport.h"
+
+#include <algorithm>
+#include <fstream>
+#include <utility>
+
+/**
+\file ColumnReport.cpp
+Implements ColumnReport class.
+*/
+
+namespace lpcompare {
+
+	const std::size_t ReportGrain = 1024; /**< Columns compared per task. */
+
+	/**
+	Attributes of the columns of a model that are not in its constraint matrix.
+	*/
+	struct ColumnAttributes {
+		std::vector<std::vector<const Bound*>> Bounds;
+		std::vector<ColumnKind> Kinds;
+
+		ColumnAttributes(const LPModel &model, const SparseMatrix &matrix)
+			: Bounds(matrix.Columns()), Kinds(matrix.Columns(), ColumnKind::Continuous)
+		{
+			for (const auto &bound : model.Bounds)
+				Bounds[matrix.ColumnIds.at(bound.VarName)].push_back(&bound);
+
+			for (auto &bounds : Bounds) {
+				std::sort(bounds.begin(), bounds.end(), [](const Bound *a, const Bound *b) { return *a < *b; });
+			}
+
+			for (const auto &name : model.Generals)
+				Kinds[matrix.ColumnIds.at(name)] = ColumnKind::General;
+			for (const auto &name : model.Binaries)
+				Kinds[matrix.ColumnIds.at(name)] = ColumnKind::Binary;
+		}
+	};
+
+	/**
+	Finds the entries of a column as row names and coefficients, sorted by row name.
+
+	\param matrix Constraint matrix.
+	\param column Column index.
+	\param entries Entries found.
+	*/
+	static void column_entries(const SparseMatrix &matrix, std::uint32_t column, std::vector<std::pair<const std::string*, double>> &entries) {
+		entries.clear();
+
+		for (auto k = matrix.ColumnStart[column]; k < matrix.ColumnStart[column + 1]; k++)
+			entries.emplace_back(&matrix.RowNames[matrix.ColumnRows[k]], matrix.ColumnValues[k]);
+
+		std::sort(entries.begin(), entries.end(), [](const std::pair<const std::string*, double> &a, const std::pair<const std::string*, double> &b) {
+			return *a.first < *b.first || (*a.first == *b.first && a.second < b.second);
+		});
+	}
+
+	/**
+	Compares a variable that exists in both models.
+
+	\param matrix1 Constraint matrix of the first model.
+	\param column1 Column of the variable in the first model.
+	\param attributes1 Column attributes of the first model.
+	\param matrix2 Constraint matrix of the second model.
+	\param column2 Column of the variable in the second model.
+	\param attributes2 Column attributes of the second model.
+	\param change Change to fill.
+	*/
+	static void compare_column(
+		const SparseMatrix &matrix1, std::uint32_t column1, const ColumnAttributes &attributes1,
+		const SparseMatrix &matrix2, std::uint32_t column2, const ColumnAttributes &attributes2,
+		ColumnChange &change) {
+
+		std::vector<std::pair<const std::string*, double>> entries1, entries2;
+		column_entries(matrix1, column1, entries1);
+		column_entries(matrix2, column2, entries2);
+
+		std::size_t i = 0, j = 0;
+		while (i < entries1.size() || j < entries2.size()) {
+			if (j == entries2.size() || (i < entries1.size() && *entries1[i].first < *entries2[j].first)) {
+				change.RowsRemoved++;
+				i++;
+			}
+			else if (i == entries1.size() || *entries2[j].first < *entries1[i].first) {
+				change.RowsAdded++;
+				j++;
+			}
+			else {
+				if (entries1[i].second != entries2[j].second)
+					change.CoefficientsChanged++;
+				i++;
+				j++;
+			}
+		}
+
+		const auto &bounds1 = attributes1.Bounds[column1];
+		const auto &bounds2 = attributes2.Bounds[column2];
+		change.BoundsChanged = !std::equal(bounds1.begin(), bounds1.end(), bounds2.begin(), bounds2.end(),
+			[](const Bound *a, const Bound *b) { return *a == *b; });
+
+		change.FirstKind = attributes1.Kinds[column1];
+		change.SecondKind = attributes2.Kinds[column2];
+
+		if (change.RowsRemoved > 0 || change.RowsAdded > 0 || change.CoefficientsChanged > 0
+			|| change.BoundsChanged || change.FirstKind != change.SecondKind)
+			change.Status = ColumnStatus::Changed;
+	}
+
+	/**
+	Compares two models variable by variable. The column forms of both constraint matrices are built
+	with a parallel transpose, then columns are compared in parallel.
+
+	\param first First model.
+	\param second Second model.
+	*/
+	void ColumnReport::Build(const LPModel &first, const LPModel &second) {
+
+		SparseMatrix matrix1, matrix2;
+		matrix1.Build(first, &pool);
+		matrix2.Build(second, &pool);
+
+		ColumnAttributes attributes1(first, matrix1), attributes2(second, matrix2);
+
+		std::vector<ColumnChange> changes(matrix1.Columns());
+
+		pool.ParallelFor(matrix1.Columns(), ReportGrain, [&](std::size_t begin, std::size_t end) {
+			for (auto c = begin; c < end; c++) {
+				auto &change = changes[c];
+				change.Name = matrix1.ColumnNames[c];
+
+				auto it = matrix2.ColumnIds.find(change.Name);
+
+				if (it == matrix2.ColumnIds.end()) {
+					change.Status = ColumnStatus::Removed;
+					change.RowsRemoved = matrix1.ColumnStart[c + 1] - matrix1.ColumnStart[c];
+					change.FirstKind = attributes1.Kinds[c];
+					change.BoundsChanged = !attributes1.Bounds[c].empty();
+					continue;
+				}
+
+				compare_column(matrix1, static_cast<std::uint32_t>(c), attributes1, matrix2, it->second, attributes2, change);
+			}
+		});
+
+		Changes.clear();
+		Changed = Added = Removed = 0;
+
+		for (auto &change : changes) {
+			if (change.Status == ColumnStatus::Unchanged)
+				continue;
+
+			if (change.Status == ColumnStatus::Changed)
+				Changed++;
+			else
+				Removed++;
+
+			Changes.push_back(std::move(change));
+		}
+
+		for (std::size_t c = 0; c < matrix2.Columns(); c++) {
+			if (matrix1.ColumnIds.count(matrix2.ColumnNames[c]) > 0)
+				continue;
+
+			ColumnChange change;
+			change.Name = matrix2.ColumnNames[c];
+			change.Status = ColumnStatus::Added;
+			change.RowsAdded = matrix2.ColumnStart[c + 1] - matrix2.ColumnStart[c];
+			change.SecondKind = attributes2.Kinds[c];
+			change.BoundsChanged = !attributes2.Bounds[c].empty();
+
+			Added++;
+			Changes.push_back(std::move(change));
+		}
+	}
+
+	static const char *status_name(ColumnStatus status) {
+		switch (status) {
+		case ColumnStatus::Changed: return "changed";
+		case ColumnStatus::Added: return "added";
+		case ColumnStatus::Removed: return "removed";
+		default: return "unchanged";
+		}
+	}
+
+	static const char *kind_name(ColumnKind kind) {
+		switch (kind) {
+		case ColumnKind::General: return "general";
+		case ColumnKind::Binary: return "binary";
+		default: return "continuous";
+		}
+	}
+
+	/**
+	Writes the report as tab separated values, one variable per line.
+
+	\param filename Name of the report file.
+	\return false if the file cannot be written.
+	*/
+	bool ColumnReport::Write(const std::string &filename) const {
+
+		std::ofstream out(filename, std::ios::binary);
+
+		out << "variable\tstatus\tcoefficients_changed\trows_added\trows_removed\tbounds_changed\tkind_first\tkind_second\n";
+
+		for (const auto &change : Changes) {
+			out << change.Name << '\t' << status_name(change.Status)
+				<< '\t' << change.CoefficientsChanged
+				<< '\t' << change.RowsAdded
+				<< '\t' << change.RowsRemoved
+				<< '\t' << (change.BoundsChanged ? "yes" : "no")
+				<< '\t' << (change.Status == ColumnStatus::Added ? "-" : kind_name(change.FirstKind))
+				<< '\t' << (change.Status == ColumnStatus::Removed ? "-" : kind_name(change.SecondKind))
+				<< '\n';
+		}
+
+		out.flush();
+
+		if (!out) {
+			std::cout << "Cannot write column report: " << filename << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	/**
+	Writes the number of changed, added and removed variables.
+
+	\param out Stream to write to.
+	*/
+	void ColumnReport::WriteSummary(std::ostream &out) const {
+		out << "Variables changed: " << Changed << std::endl;
+		out << "Variables added: " << Added << std::endl;
+		out << "Variables removed: " << Removed << std::endl;
+	}
+}
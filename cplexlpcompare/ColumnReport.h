@@ -0,0 +1,107 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef COLUMNREPORT_H
+#define COLUMNREPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "LPModel.h"
+#include "SparseMatrix.h"
+#include "ThreadPool.h"
+
+/**
+\file ColumnReport.h
+Defines the per-variable comparison of two models.
+*/
+
+namespace lpcompare {
+
+	/**
+	Kinds of a variable.
+	*/
+	enum class ColumnKind
+	{
+		Continuous = 0,
+		General,
+		Binary,
+	};
+
+	/**
+	Changes of a variable between two models.
+	*/
+	enum class ColumnStatus
+	{
+		Unchanged = 0,
+		Changed,
+		Added,
+		Removed,
+	};
+
+	/**
+	\class ColumnChange
+	Change of a single variable: its coefficients per row name, its bounds and its kind.
+	*/
+	class ColumnChange {
+	public:
+		std::string Name;
+		ColumnStatus Status = ColumnStatus::Unchanged;
+		std::size_t CoefficientsChanged = 0; /**< Rows in both models with a different coefficient. */
+		std::size_t RowsAdded = 0; /**< Rows the variable occurs in only in the second model. */
+		std::size_t RowsRemoved = 0; /**< Rows the variable occurs in only in the first model. */
+		bool BoundsChanged = false;
+		ColumnKind FirstKind = ColumnKind::Continuous;
+		ColumnKind SecondKind = ColumnKind::Continuous;
+	};
+
+	/**
+	\class ColumnReport
+	Compares two models variable by variable over the column form of their constraint matrices.
+	*/
+	class ColumnReport {
+
+		ThreadPool &pool;
+
+	public:
+
+		std::vector<ColumnChange> Changes; /**< Changed, added and removed variables. */
+		std::size_t Changed = 0;
+		std::size_t Added = 0;
+		std::size_t Removed = 0;
+
+		explicit ColumnReport(ThreadPool &pool) : pool(pool) {}
+
+		void Build(const LPModel &first, const LPModel &second);
+
+		bool Write(const std::string &filename) const;
+		void WriteSummary(std::ostream &out) const;
+	};
+}
+
+#endif // COLUMNREPORT_H
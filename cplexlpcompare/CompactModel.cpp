@@ -0,0 +1,343 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#include "CompactModel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <boost/function_output_iterator.hpp>
+
+#include "Fingerprint.h"
+#include "Hash.h"
+
+/**
+\file CompactModel.cpp
+Implements CompactDictionary and CompactModel classes.
+*/
+
+namespace lpcompare {
+
+	/**
+	Appends an unsigned integer in 7 bit groups, low group first.
+
+	\param out Buffer to append to.
+	\param value Value to append.
+	*/
+	static void append_varint(std::vector<std::uint8_t> &out, std::uint64_t value) {
+		while (value >= 0x80) {
+			out.push_back(static_cast<std::uint8_t>(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back(static_cast<std::uint8_t>(value));
+	}
+
+	/**
+	Reads an unsigned integer written by append_varint.
+
+	\param p Position to read from, moved past the value.
+	\return Value read.
+	*/
+	static std::uint64_t read_varint(const std::uint8_t *&p) {
+		std::uint64_t value = 0;
+		int shift = 0;
+
+		while (*p & 0x80) {
+			value |= static_cast<std::uint64_t>(*p++ & 0x7f) << shift;
+			shift += 7;
+		}
+		value |= static_cast<std::uint64_t>(*p++) << shift;
+
+		return value;
+	}
+
+	/**
+	Gets the id of a column, adding the column if it is new.
+
+	\param name Column name.
+	\return Column id.
+	*/
+	std::uint32_t CompactDictionary::ColumnId(const std::string &name) {
+
+		auto inserted = columnIds.emplace(name, static_cast<std::uint32_t>(columnNames.size()));
+
+		if (inserted.second)
+			columnNames.push_back(&inserted.first->first);
+
+		return inserted.first->second;
+	}
+
+	/**
+	Gets the code of a coefficient value, adding the value while codes are left.
+
+	\param value Coefficient or right-hand side.
+	\return Code of the value starting from 1, 0 if the value is stored in full.
+	*/
+	std::uint32_t CompactDictionary::CoefficientCode(double value) {
+
+		auto bits = NumberBits(value);
+		auto found = coefficientCodes.find(bits);
+
+		if (found != coefficientCodes.end())
+			return found->second;
+
+		if (coefficients.size() >= MaxCoefficients)
+			return 0;
+
+		coefficients.push_back(value == 0 ? 0.0 : value);
+		auto code = static_cast<std::uint32_t>(coefficients.size());
+		coefficientCodes.emplace(bits, code);
+
+		return code;
+	}
+
+	/**
+	Estimates heap memory held by the dictionary.
+
+	\return approximate size in bytes.
+	*/
+	std::size_t CompactDictionary::EstimateMemory() const {
+
+		std::size_t size = columnNames.capacity() * sizeof(const std::string*) + coefficients.capacity() * sizeof(double);
+
+		// hash nodes hold the key, the value and a next pointer, buckets hold a pointer.
+		for (const auto &column : columnIds)
+			size += sizeof(column) + sizeof(void*) + (column.first.capacity() > 15 ? column.first.capacity() : 0);
+		size += columnIds.bucket_count() * sizeof(void*);
+		size += coefficientCodes.size() * (sizeof(std::pair<std::uint64_t, std::uint32_t>) + sizeof(void*));
+		size += coefficientCodes.bucket_count() * sizeof(void*);
+
+		return size;
+	}
+
+	/**
+	Appends a coefficient or right-hand side, by its code or in full.
+
+	\param out Buffer to append to.
+	\param value Value to append.
+	*/
+	void CompactModel::AppendNumber(std::vector<std::uint8_t> &out, double value) {
+
+		auto code = dictionary.CoefficientCode(value);
+
+		if (code != 0) {
+			append_varint(out, code);
+			return;
+		}
+
+		out.push_back(0);
+		auto bits = NumberBits(value);
+		for (int i = 0; i < 8; i++)
+			out.push_back(static_cast<std::uint8_t>(bits >> (8 * i)));
+	}
+
+	/**
+	Reads a value written by AppendNumber.
+
+	\param p Position to read from, moved past the value.
+	\param dictionary Dictionary of the coded values.
+	\return Value read.
+	*/
+	static double read_number(const std::uint8_t *&p, const CompactDictionary &dictionary) {
+
+		auto code = read_varint(p);
+
+		if (code != 0)
+			return dictionary.Coefficient(static_cast<std::uint32_t>(code));
+
+		std::uint64_t bits = 0;
+		for (int i = 0; i < 8; i++)
+			bits |= static_cast<std::uint64_t>(*p++) << (8 * i);
+
+		double value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	/**
+	Encodes a constraint and appends it to the rows.
+
+	\param cons Constraint to add.
+	*/
+	void CompactModel::AddConstraint(Constraint cons) {
+
+		terms.clear();
+		for (const auto &term : cons.GetTerms())
+			terms.emplace_back(dictionary.ColumnId(term.varName), term.coeff);
+
+		std::sort(terms.begin(), terms.end());
+
+		key.clear();
+		key.push_back(static_cast<std::uint8_t>(NormalizeOp(cons.GetSign())));
+		AppendNumber(key, cons.GetRHS());
+		append_varint(key, terms.size());
+
+		std::uint32_t previous = 0;
+		for (const auto &term : terms) {
+			append_varint(key, term.first - previous);
+			previous = term.first;
+		}
+
+		for (const auto &term : terms)
+			AppendNumber(key, term.second);
+
+		append_varint(rowBytes, key.size());
+		rowBytes.insert(rowBytes.end(), key.begin(), key.end());
+		rowBytes.insert(rowBytes.end(), cons.Name.begin(), cons.Name.end());
+		rowOffsets.push_back(rowBytes.size());
+
+		nonzeros += terms.size();
+	}
+
+	/**
+	Decodes a row.
+
+	\param row Index of the row.
+	\return Constraint of the row, its sense normalized to <=, >= or =.
+	*/
+	Constraint CompactModel::DecodeRow(std::size_t row) const {
+
+		auto p = rowBytes.data() + rowOffsets[row];
+		auto end = rowBytes.data() + rowOffsets[row + 1];
+
+		auto keyLength = read_varint(p);
+		auto name = p + keyLength;
+
+		auto sign = static_cast<ConstraintOp>(*p++);
+		auto rhs = read_number(p, dictionary);
+		auto count = read_varint(p);
+
+		std::vector<Term> decoded(count);
+		std::uint32_t column = 0;
+
+		for (auto &term : decoded) {
+			column += static_cast<std::uint32_t>(read_varint(p));
+			term.varName = dictionary.ColumnName(column);
+		}
+
+		for (auto &term : decoded)
+			term.coeff = read_number(p, dictionary);
+
+		return Constraint(std::string(name, end), std::move(decoded), sign, rhs);
+	}
+
+	/**
+	Estimates heap memory held by the model, without the shared dictionary.
+
+	\return approximate size of the model in bytes.
+	*/
+	std::size_t CompactModel::EstimateMemory() const {
+
+		auto string_size = [](const std::string &s) {
+			return sizeof(std::string) + (s.capacity() > 15 ? s.capacity() : 0);
+		};
+
+		std::size_t size = sizeof(CompactModel) + rowBytes.capacity() + rowOffsets.capacity() * sizeof(std::uint64_t);
+
+		for (const auto *vars : { &Generals, &Binaries, &SosVars }) {
+			for (const auto &var : *vars)
+				size += string_size(var);
+		}
+
+		for (const auto &bound : Bounds)
+			size += sizeof(Bound) + string_size(bound.VarName) - sizeof(std::string);
+
+		return size;
+	}
+
+	/**
+	Key bytes of a row with their hash, ordered by hash first.
+	*/
+	struct RowKey {
+		std::uint64_t Hash;
+		const std::uint8_t *Key;
+		std::size_t Length;
+		std::size_t Row;
+
+		bool operator<(const RowKey &other) const {
+			if (Hash != other.Hash)
+				return Hash < other.Hash;
+			if (Length != other.Length)
+				return Length < other.Length;
+			return std::memcmp(Key, other.Key, Length) < 0;
+		}
+	};
+
+	/**
+	Compares the constraints of two models on their encoded keys. Only differing rows are decoded,
+	and only if they are passed to a sink. Both models must share their dictionary.
+
+	\param other Second model.
+	\param sink Sink to receive differing constraints, nullptr to only count them.
+	\return Counts of differences between the constraints of the two models.
+	*/
+	SectionDiff<Constraint> CompactModel::CompareConstraints(const CompactModel &other, DiffSink<Constraint> *sink) const {
+
+		auto row_keys = [](const CompactModel &model) {
+			std::vector<RowKey> keys(model.RowCount());
+
+			for (std::size_t row = 0; row < keys.size(); row++) {
+				auto p = model.rowBytes.data() + model.rowOffsets[row];
+				auto length = read_varint(p);
+				keys[row] = { HashBytes(p, length), p, length, row };
+			}
+
+			std::sort(keys.begin(), keys.end());
+			return keys;
+		};
+
+		auto row_name = [](const CompactModel &model) {
+			return [&model](const RowKey &key) {
+				auto end = model.rowBytes.data() + model.rowOffsets[key.Row + 1];
+				return std::string(reinterpret_cast<const char*>(key.Key + key.Length), reinterpret_cast<const char*>(end));
+			};
+		};
+
+		auto keys = row_keys(*this);
+		auto otherKeys = row_keys(other);
+
+		SectionDiff<Constraint> diff;
+		diff.Compared = true;
+		diff.FirstCount = keys.size();
+		diff.SecondCount = otherKeys.size();
+
+		auto &count1e2 = diff.FirstExceptSecondCount;
+		auto &count2e1 = diff.SecondExceptFirstCount;
+
+		SetDifferenceByName(keys.begin(), keys.end(), otherKeys.begin(), otherKeys.end(),
+			boost::make_function_output_iterator([this, &count1e2, sink](const RowKey &key) {
+				count1e2++;
+				if (sink != nullptr)
+					sink->FirstExceptSecond(DecodeRow(key.Row));
+			}), row_name(*this), row_name(other));
+		SetDifferenceByName(otherKeys.begin(), otherKeys.end(), keys.begin(), keys.end(),
+			boost::make_function_output_iterator([&other, &count2e1, sink](const RowKey &key) {
+				count2e1++;
+				if (sink != nullptr)
+					sink->SecondExceptFirst(other.DecodeRow(key.Row));
+			}), row_name(other), row_name(*this));
+
+		return diff;
+	}
+}
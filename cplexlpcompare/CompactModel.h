@@ -0,0 +1,115 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef COMPACTMODEL_H
+#define COMPACTMODEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "LPCompare.h"
+#include "LPModel.h"
+
+namespace lpcompare {
+
+	/**
+	\class CompactDictionary
+	Column names and coefficient values shared by the CompactModel instances that are compared, so
+	that equal rows of different models are encoded to equal bytes. Columns get ids in order of
+	appearance. Coefficients get codes in order of appearance until MaxCoefficients codes are taken,
+	later values are stored in full; a value never changes its encoding once seen.
+	*/
+	class CompactDictionary {
+
+		std::unordered_map<std::string, std::uint32_t> columnIds;
+		std::vector<const std::string*> columnNames;
+		std::unordered_map<std::uint64_t, std::uint32_t> coefficientCodes;
+		std::vector<double> coefficients;
+
+	public:
+
+		static const std::uint32_t MaxCoefficients = 1 << 16; /**< Coded coefficient values, codes take at most 3 bytes. */
+
+		std::uint32_t ColumnId(const std::string &name);
+		const std::string &ColumnName(std::uint32_t id) const { return *columnNames[id]; }
+		std::uint32_t CoefficientCode(double value);
+		double Coefficient(std::uint32_t code) const { return coefficients[code - 1]; }
+
+		std::size_t ColumnCount() const { return columnNames.size(); }
+		std::size_t CoefficientCount() const { return coefficients.size(); }
+		std::size_t EstimateMemory() const;
+	};
+
+	/**
+	\class CompactModel
+	Model whose constraints are held encoded in one byte buffer, for comparing models with very large
+	nonzero counts. Other sections are held as in LPModel.
+
+	Every row starts with the varint length of its key, followed by the key and the row name. The key
+	is the normalized sense, the right-hand side, the varint term count, the varint deltas of the sorted
+	column ids and the coefficients. Numbers are the varint of their dictionary code, or 0 followed by
+	the 8 bytes of the value. Rows that are equal by Constraint::operator< have equal keys, so rows are
+	hashed and compared on their keys without decoding them. Only differing rows are decoded.
+	*/
+	class CompactModel : public ModelSink {
+
+		CompactDictionary &dictionary;
+		std::vector<std::uint8_t> rowBytes;
+		std::vector<std::uint64_t> rowOffsets; /**< Start of every row and the end of the last one. */
+		std::size_t nonzeros = 0;
+		std::vector<std::pair<std::uint32_t, double>> terms;
+		std::vector<std::uint8_t> key;
+
+		void AppendNumber(std::vector<std::uint8_t> &out, double value);
+
+	public:
+
+		std::vector<std::string> Generals;
+		std::vector<std::string> Binaries;
+		std::vector<std::string> SosVars;
+		std::vector<Bound> Bounds;
+
+		explicit CompactModel(CompactDictionary &dictionary) : dictionary(dictionary), rowOffsets(1, 0) {}
+
+		void AddGeneral(std::string name) override { Generals.push_back(std::move(name)); }
+		void AddBinary(std::string name) override { Binaries.push_back(std::move(name)); }
+		void AddSosVar(std::string name) override { SosVars.push_back(std::move(name)); }
+		void AddBound(Bound bound) override { Bounds.push_back(std::move(bound)); }
+		void AddConstraint(Constraint cons) override;
+
+		std::size_t RowCount() const { return rowOffsets.size() - 1; }
+		std::size_t NonzeroCount() const { return nonzeros; }
+		std::size_t EstimateMemory() const;
+
+		Constraint DecodeRow(std::size_t row) const;
+
+		SectionDiff<Constraint> CompareConstraints(const CompactModel &other, DiffSink<Constraint> *sink) const;
+	};
+}
+
+#endif // COMPACTMODEL_H
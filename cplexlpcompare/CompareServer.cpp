@@ -0,0 +1,518 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#include "CompareServer.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+
+#include "LPCompare.h"
+
+#ifdef LPCOMPARE_HAVE_UNIX_SOCKETS
+#include <csignal>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+/**
+\file CompareServer.cpp
+Implements CompareServer class.
+*/
+
+namespace lpcompare {
+
+	const std::size_t MAX_REQUEST_LENGTH = 1 << 16; /**< Longest request line, longer ones close the connection. */
+
+	/**
+	Creates a server.
+
+	\param cache Cache of parsed models.
+	\param threads Requests served at once, 0 for one per hardware thread.
+	\param root Directory that requested models and dumps must be in.
+	*/
+	CompareServer::CompareServer(ModelCache &cache, unsigned threads, const std::string &root)
+		: cache(cache), pool(threads)
+	{
+		boost::system::error_code ec;
+		auto canonical = boost::filesystem::canonical(root, ec);
+
+		if (!ec && boost::filesystem::is_directory(canonical))
+			this->root = canonical.string();
+	}
+
+	CompareServer::~CompareServer() {
+		// queued requests still report to the wake pipe.
+		pool.Wait();
+
+#ifdef LPCOMPARE_HAVE_UNIX_SOCKETS
+		for (auto fd : wakeFds) {
+			if (fd >= 0)
+				::close(fd);
+		}
+#endif
+	}
+
+	/**
+	Resolves a requested path and checks that it is under the root directory. Relative paths are
+	resolved against the root directory.
+
+	\param path Requested path.
+	\param parentOnly Only the parent directory must exist, as for a dump prefix.
+	\param resolved Set to the resolved path.
+	\param error Set to the reason if the path is refused.
+	\return false if the path cannot be resolved or is outside the root directory.
+	*/
+	bool CompareServer::ConfinePath(const std::string &path, bool parentOnly, std::string &resolved, std::string &error) const {
+
+		auto absolute = boost::filesystem::absolute(path, root);
+		auto existing = parentOnly ? absolute.parent_path() : absolute;
+
+		boost::system::error_code ec;
+		auto canonical = boost::filesystem::canonical(existing, ec);
+
+		if (ec) {
+			error = "cannot resolve path: " + path;
+			return false;
+		}
+
+		auto part = canonical.begin();
+		for (const auto &rootPart : boost::filesystem::path(root)) {
+			if (part == canonical.end() || *part != rootPart) {
+				error = "path is outside the served directory: " + path;
+				return false;
+			}
+			++part;
+		}
+
+		resolved = parentOnly ? (canonical / absolute.filename()).string() : canonical.string();
+		return true;
+	}
+
+#ifdef LPCOMPARE_HAVE_UNIX_SOCKETS
+
+	/**
+	Writes a whole string to a socket.
+
+	\param fd Socket.
+	\param data String to write.
+	\return false if the peer is gone.
+	*/
+	bool write_all(int fd, const std::string &data) {
+
+		std::size_t written = 0;
+
+		while (written < data.size()) {
+			auto n = ::write(fd, data.data() + written, data.size() - written);
+
+			if (n <= 0)
+				return false;
+
+			written += n;
+		}
+
+		return true;
+	}
+
+	/**
+	Reads a line from a socket.
+
+	\param fd Socket.
+	\param buffer Bytes read past the previous line.
+	\param line Line read, without the line feed.
+	\return false on end of stream.
+	*/
+	bool read_line(int fd, std::string &buffer, std::string &line) {
+
+		for (;;) {
+			auto pos = buffer.find('\n');
+
+			if (pos != std::string::npos) {
+				line = buffer.substr(0, pos);
+				buffer.erase(0, pos + 1);
+				return true;
+			}
+
+			char chunk[4096];
+			auto n = ::read(fd, chunk, sizeof(chunk));
+
+			if (n <= 0)
+				return false;
+
+			buffer.append(chunk, n);
+		}
+	}
+
+	/**
+	Fills a Unix domain socket address.
+
+	\param socketPath Filesystem path of the socket.
+	\param address Address to fill.
+	\return false if the path does not fit.
+	*/
+	bool make_address(const std::string &socketPath, sockaddr_un &address) {
+
+		if (socketPath.size() >= sizeof(address.sun_path)) {
+			std::cout << "Socket path is too long: " << socketPath << std::endl;
+			return false;
+		}
+
+		std::memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+		return true;
+	}
+
+	/**
+	Compares a section and writes its counts to a socket.
+
+	\param fd Connected socket.
+	\param detail_name Given name of the detail.
+	\param vec Section of the first model.
+	\param vecother Section of the second model.
+	\param dump_prefix Filename prefix for difference dumps, empty for no dumps.
+	\return true if the sections are equivalent.
+	*/
+	template <typename T>
+	bool stream_section(int fd, const std::string &detail_name, std::vector<T> &vec, std::vector<T> &vecother, const std::string &dump_prefix) {
+
+		auto diff = CompareSection(vec, vecother, !dump_prefix.empty());
+
+		std::ostringstream out;
+		WriteSectionCounts(detail_name, diff, out);
+
+		if (!dump_prefix.empty())
+			DumpSectionDiff(detail_name, diff, dump_prefix, out);
+
+		write_all(fd, out.str());
+
+		return diff.AreEquivalent();
+	}
+
+	/**
+	Listens on a Unix domain socket and serves requests until the process is stopped.
+	A stale socket file at the same path is replaced. The socket is created accessible by its owner only.
+
+	Connections waiting for a request are polled here. A complete request line is handed to the pool
+	and its connection is polled again once the request is served.
+
+	\param socketPath Filesystem path of the socket.
+	\return false if the socket cannot be set up or connections can no longer be accepted.
+	*/
+	bool CompareServer::Serve(const std::string &socketPath) {
+
+		sockaddr_un address;
+
+		if (!make_address(socketPath, address))
+			return false;
+
+		if (root.empty()) {
+			std::cout << "Root directory does not exist." << std::endl;
+			return false;
+		}
+
+		std::signal(SIGPIPE, SIG_IGN);
+
+		struct stat st;
+		if (::stat(socketPath.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+			::unlink(socketPath.c_str());
+
+		int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+		auto mask = ::umask(0177);
+		bool bound = listener >= 0 && ::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+		::umask(mask);
+
+		if (!bound
+			|| ::chmod(socketPath.c_str(), 0600) != 0
+			|| ::listen(listener, 64) != 0
+			|| ::pipe(wakeFds) != 0) {
+			std::cout << "Cannot listen on socket: " << socketPath << std::endl;
+			return false;
+		}
+
+		std::cout << "Listening on " << socketPath << ", serving files under " << root << std::endl;
+
+		struct Connection {
+			std::string Buffer; /**< Bytes read past the last request. */
+			bool Busy = false; /**< A request of the connection is being served. */
+		};
+
+		std::unordered_map<int, Connection> connections;
+
+		// hands the next complete request of a connection to the pool.
+		auto dispatch = [this](int fd, Connection &connection) {
+			auto pos = connection.Buffer.find('\n');
+
+			if (pos == std::string::npos)
+				return;
+
+			auto request = connection.Buffer.substr(0, pos);
+			connection.Buffer.erase(0, pos + 1);
+			boost::trim_right_if(request, boost::is_any_of("\r"));
+
+			connection.Busy = true;
+			pool.Enqueue([this, fd, request]() { ServeRequest(fd, request); });
+		};
+
+		auto close_connection = [&connections](int fd) {
+			::close(fd);
+			connections.erase(fd);
+		};
+
+		std::vector<pollfd> fds;
+
+		for (;;) {
+			fds.clear();
+			fds.push_back({ listener, POLLIN, 0 });
+			fds.push_back({ wakeFds[0], POLLIN, 0 });
+
+			for (const auto &connection : connections) {
+				if (!connection.second.Busy)
+					fds.push_back({ connection.first, POLLIN, 0 });
+			}
+
+			if (::poll(fds.data(), fds.size(), -1) < 0) {
+				if (errno == EINTR)
+					continue;
+
+				std::cout << "Cannot poll connections: " << std::strerror(errno) << std::endl;
+				return false;
+			}
+
+			if (fds[1].revents != 0) {
+				char drain[256];
+				if (::read(wakeFds[0], drain, sizeof(drain)) < 0 && errno != EINTR)
+					return false;
+
+				std::vector<std::pair<int, bool>> served;
+				{
+					std::lock_guard<std::mutex> lock(doneMutex);
+					served.swap(done);
+				}
+
+				for (const auto &entry : served) {
+					if (!entry.second) {
+						close_connection(entry.first);
+						continue;
+					}
+
+					auto &connection = connections[entry.first];
+					connection.Busy = false;
+					dispatch(entry.first, connection);
+				}
+			}
+
+			for (std::size_t i = 2; i < fds.size(); i++) {
+				if (fds[i].revents == 0)
+					continue;
+
+				auto fd = fds[i].fd;
+				auto &connection = connections[fd];
+
+				char chunk[4096];
+				auto n = ::read(fd, chunk, sizeof(chunk));
+
+				if (n < 0 && errno == EINTR)
+					continue;
+
+				if (n <= 0) {
+					close_connection(fd);
+					continue;
+				}
+
+				connection.Buffer.append(chunk, n);
+				dispatch(fd, connection);
+
+				if (!connection.Busy && connection.Buffer.size() > MAX_REQUEST_LENGTH)
+					close_connection(fd);
+			}
+
+			if (fds[0].revents != 0) {
+				int fd = ::accept(listener, nullptr, nullptr);
+
+				if (fd >= 0) {
+					connections[fd];
+				}
+				else if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+					// out of descriptors or memory, wait for requests to finish and connections to close.
+					std::this_thread::sleep_for(std::chrono::milliseconds(100));
+				}
+				else if (errno != EINTR && errno != EAGAIN && errno != ECONNABORTED && errno != EPROTO) {
+					std::cout << "Cannot accept connections: " << std::strerror(errno) << std::endl;
+					return false;
+				}
+			}
+		}
+	}
+
+	/**
+	Serves a single request of a connection on the pool, then hands the connection back to the
+	serving thread.
+
+	\param fd Connected socket.
+	\param request Request line.
+	*/
+	void CompareServer::ServeRequest(int fd, const std::string &request) {
+
+		std::string status;
+
+		try {
+			status = HandleRequest(request, fd);
+		}
+		catch (std::exception &e) {
+			status = std::string("error ") + e.what();
+		}
+
+		bool open = write_all(fd, status + "\n");
+
+		{
+			std::lock_guard<std::mutex> lock(doneMutex);
+			done.emplace_back(fd, open);
+		}
+
+		// a full pipe already has a wake-up pending.
+		char wake = 0;
+		while (::write(wakeFds[1], &wake, 1) < 0 && errno == EINTR) {
+		}
+	}
+
+	/**
+	Serves a single request, streaming section results to the client.
+
+	\param request Request line.
+	\param fd Connected socket.
+	\return Final status line.
+	*/
+	std::string CompareServer::HandleRequest(const std::string &request, int fd) {
+
+		std::vector<std::string> fields;
+		boost::split(fields, request, boost::is_any_of("\t"));
+
+		if (fields[0] == "stats")
+			return "ok " + cache.Stats();
+
+		if (fields[0] != "compare" || fields.size() < 3 || fields.size() > 4)
+			return "error unknown request: " + request;
+
+		std::string error;
+		std::string firstPath;
+		std::string secondPath;
+		std::string dump_prefix;
+
+		if (!ConfinePath(fields[1], false, firstPath, error)
+			|| !ConfinePath(fields[2], false, secondPath, error)
+			|| (fields.size() == 4 && !ConfinePath(fields[3], true, dump_prefix, error)))
+			return "error " + error;
+
+		auto first = cache.Get(firstPath, error);
+		if (!first)
+			return "error " + error;
+
+		auto second = cache.Get(secondPath, error);
+		if (!second)
+			return "error " + error;
+		bool equivalent = true;
+
+		// cached models are sorted, comparing them does not modify them.
+		equivalent &= stream_section(fd, "Generals", first->Generals, second->Generals, dump_prefix);
+		equivalent &= stream_section(fd, "Binaries", first->Binaries, second->Binaries, dump_prefix);
+		equivalent &= stream_section(fd, "SosVars", first->SosVars, second->SosVars, dump_prefix);
+		equivalent &= stream_section(fd, "Bounds", first->Bounds, second->Bounds, dump_prefix);
+		equivalent &= stream_section(fd, "Constraints", first->Constraints, second->Constraints, dump_prefix);
+
+		return equivalent ? "ok equivalent" : "ok different";
+	}
+
+	/**
+	Sends a request to a server and copies the response to a stream.
+
+	\param socketPath Filesystem path of the server socket.
+	\param request Request line.
+	\param out Stream to copy the response to.
+	\return true if the server answered with ok.
+	*/
+	bool CompareServer::Request(const std::string &socketPath, const std::string &request, std::ostream &out) {
+
+		sockaddr_un address;
+
+		if (!make_address(socketPath, address))
+			return false;
+
+		int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+		if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+			std::cout << "Cannot connect to socket: " << socketPath << std::endl;
+			if (fd >= 0)
+				::close(fd);
+			return false;
+		}
+
+		std::string buffer;
+		std::string line;
+		bool ok = false;
+
+		if (write_all(fd, request + "\n")) {
+			while (read_line(fd, buffer, line)) {
+				out << line << std::endl;
+
+				if (boost::starts_with(line, "ok")) {
+					ok = true;
+					break;
+				}
+
+				if (boost::starts_with(line, "error"))
+					break;
+			}
+		}
+
+		::close(fd);
+		return ok;
+	}
+
+#else
+
+	bool CompareServer::Serve(const std::string &socketPath) {
+		std::cout << "Serve mode requires Unix domain sockets." << std::endl;
+		return false;
+	}
+
+	bool CompareServer::Request(const std::string &socketPath, const std::string &request, std::ostream &out) {
+		std::cout << "Serve mode requires Unix domain sockets." << std::endl;
+		return false;
+	}
+
+#endif
+}
@@ -0,0 +1,85 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef COMPARESERVER_H
+#define COMPARESERVER_H
+
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ModelCache.h"
+#include "ThreadPool.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define LPCOMPARE_HAVE_UNIX_SOCKETS
+#endif
+
+namespace lpcompare {
+
+	/**
+	\class CompareServer
+	Long-running comparison service listening on a Unix domain socket. Models are kept in a ModelCache
+	between requests.
+
+	Requests and responses are lines of text. A request is
+	<tt>compare\\t<first>\\t<second>[\\t<dump-prefix>]</tt> or <tt>stats</tt>. Section counts are streamed
+	back as each section is compared and a response ends with a line starting with <tt>ok</tt> or <tt>error</tt>.
+
+	Idle connections are polled by the serving thread, each request is handled by a task on the pool,
+	so idle clients do not hold workers. The socket is accessible by its owner only, and models are
+	read and dumps written under a root directory only.
+	*/
+	class CompareServer {
+
+		ModelCache &cache;
+		ThreadPool pool;
+		std::string root; /**< Canonical directory that requested paths must be in. */
+
+		std::mutex doneMutex;
+		std::vector<std::pair<int, bool>> done; /**< Connections whose request is served, and whether they are still open. */
+		int wakeFds[2] = { -1, -1 }; /**< Pipe waking the serving thread when a request is served. */
+
+		void ServeRequest(int fd, const std::string &request);
+		std::string HandleRequest(const std::string &request, int fd);
+		bool ConfinePath(const std::string &path, bool parentOnly, std::string &resolved, std::string &error) const;
+
+	public:
+
+		CompareServer(ModelCache &cache, unsigned threads, const std::string &root);
+		~CompareServer();
+
+		CompareServer(const CompareServer&) = delete;
+		CompareServer& operator=(const CompareServer&) = delete;
+
+		bool Serve(const std::string &socketPath);
+
+		static bool Request(const std::string &socketPath, const std::string &request, std::ostream &out);
+	};
+}
+
+#endif // COMPARESERVER_H
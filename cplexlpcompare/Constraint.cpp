@@ -29,7 +29,10 @@
 #include <boost/regex.hpp>
 #include <boost/algorithm/string.hpp>
 
+#include <algorithm>
 #include <bitset>
+#include <cmath>
+#include <cstdio>
 #include <string>
 
 /**
@@ -129,23 +132,38 @@ namespace lpcompare {
 		output.swap(ret);
 	}
 
+	/**
+	Creates a Constraint programmatically. Terms are sorted as they are by Parse.
+
+	\param name Name of the constraint.
+	\param terms Terms of the left-hand side.
+	\param sign Sign (operator) of the constraint.
+	\param rhs Right-hand side.
+	*/
+	Constraint::Constraint(std::string name, std::vector<Term> terms, ConstraintOp sign, double rhs)
+		: Sign(sign), RHS(rhs), Terms(std::move(terms)), Name(std::move(name))
+	{
+		std::sort(Terms.begin(), Terms.end());
+	}
+
 	/**
 	Parses a line of the LP file representing a Constraint.
 
 	\param line Single line of an LP file.
+	\param canonical Bring the constraint to its canonical form, see Canonicalize.
 	\return A Constraint instance representing line.
 	*/
-	Constraint *Constraint::Parse(std::string& line){
-
-		Constraint *ret = new Constraint();
+	Constraint *Constraint::Parse(std::string& line, bool canonical){
 
 		std::vector<std::string> parts;
 
 		custom_split(line, " \t\r\n", parts);
 
-		if (parts.size() == 0)
+		if (parts.size() < 3)
 			return nullptr;
 
+		Constraint *ret = new Constraint();
+
 		if (contains(parts[0], ":"))
 			ret->Name = parts[0].substr(0, parts[0].length() - 1);
 
@@ -160,10 +178,10 @@ namespace lpcompare {
 			if (name.length() > 0)
 			{
 				// add CoeffVar.
-				auto term = new Term();
-				term->varName = name;
-				term->coeff = opChar == '+' ? coeff : -coeff;
-				ret->Terms->push_back(*term);
+				Term term;
+				term.varName = name;
+				term.coeff = opChar == '+' ? coeff : -coeff;
+				ret->Terms.push_back(term);
 
 				name = "";
 				opChar = '+';
@@ -189,17 +207,17 @@ namespace lpcompare {
 		if (name.length() > 0)
 		{
 			// add CoeffVar.
-			auto term = new Term();
-			term->varName = name;
-			term->coeff = opChar == '+' ? coeff : -coeff;
-			ret->Terms->push_back(*term);
+			Term term;
+			term.varName = name;
+			term.coeff = opChar == '+' ? coeff : -coeff;
+			ret->Terms.push_back(term);
 
 			name = "";
 			opChar = '+';
 			coeff = 1;
 		}
 
-		std::sort(ret->Terms->begin(), ret->Terms->end());
+		std::sort(ret->Terms.begin(), ret->Terms.end());
 
 		auto opstr = parts[parts.size() - 2];
 		auto rhsstr = parts[parts.size() - 1];
@@ -207,9 +225,55 @@ namespace lpcompare {
 		ret->Sign = get_constraintop(opstr);
 		ret->RHS = boost::lexical_cast<double>(rhsstr);
 
+		if (canonical)
+			ret->Canonicalize();
+
 		return ret;
 	}
 
+	/**
+	Brings the constraint to a form shared by all its positive and negative multiples, so that
+	<tt>2 x + 4 y <= 10</tt> and <tt>-x - 2 y >= -5</tt> compare equal. The leading term, the term
+	of the smallest variable name, gets a coefficient of 1: all coefficients and the right-hand side
+	are divided by its absolute value and negated with the sense flipped if it is negative.
+	Terms with a coefficient of 0 are dropped, < and > are read as <= and >=. Dividing is correctly rounded, hence multiples of rows with integer
+	coefficients get exactly the same canonical form.
+	*/
+	void Constraint::Canonicalize() {
+
+		if (Sign == ConstraintOp::LT)
+			Sign = ConstraintOp::LTE;
+		else if (Sign == ConstraintOp::GT)
+			Sign = ConstraintOp::GTE;
+
+		Terms.erase(std::remove_if(Terms.begin(), Terms.end(), [](const Term &term) { return term.coeff == 0; }), Terms.end());
+
+		auto lead = std::min_element(Terms.begin(), Terms.end(), [](const Term &a, const Term &b) {
+			return a.varName < b.varName;
+		});
+
+		if (lead == Terms.end())
+			return;
+
+		auto scale = lead->coeff;
+
+		for (auto &term : Terms)
+			term.coeff /= scale;
+
+		RHS /= scale;
+		if (RHS == 0)
+			RHS = 0;
+
+		if (scale < 0) {
+			if (Sign == ConstraintOp::LTE)
+				Sign = ConstraintOp::GTE;
+			else if (Sign == ConstraintOp::GTE)
+				Sign = ConstraintOp::LTE;
+		}
+
+		std::sort(Terms.begin(), Terms.end());
+	}
+
 	/**
 	Compares two Constraint instances for equality.
 
@@ -219,8 +283,8 @@ namespace lpcompare {
 	bool Constraint::operator==(const Constraint &other) const {
 		bool eq = other.Sign == Sign;
 		eq = eq && other.RHS == RHS;
-		eq = eq && other.Terms->size() == Terms->size();
-		eq = eq && std::equal(other.Terms->begin(), other.Terms->end(), Terms->begin());
+		eq = eq && other.Terms.size() == Terms.size();
+		eq = eq && std::equal(other.Terms.begin(), other.Terms.end(), Terms.begin());
 		return eq;
 	}
 
@@ -273,17 +337,17 @@ namespace lpcompare {
 		else if (RHS < other.RHS)
 			return true;
 
-		if (sign_other == sign && other.RHS == RHS && Terms->size() > other.Terms->size())
+		if (sign_other == sign && other.RHS == RHS && Terms.size() > other.Terms.size())
 			return false;
-		else if (Terms->size() < other.Terms->size())
+		else if (Terms.size() < other.Terms.size())
 			return true;
 
 		/* Terms assumed sorted. */
-		if (sign_other == sign && RHS == other.RHS && Terms->size() == other.Terms->size()) {
+		if (sign_other == sign && RHS == other.RHS && Terms.size() == other.Terms.size()) {
 
 			bool is_equal_sofar = true;
-			for (auto it = Terms->begin(), it2 = other.Terms->begin();
-				is_equal_sofar && it != Terms->end() && it2 != other.Terms->end(); ++it, ++it2) {
+			for (auto it = Terms.begin(), it2 = other.Terms.begin();
+				is_equal_sofar && it != Terms.end() && it2 != other.Terms.end(); ++it, ++it2) {
 
 				if (*it2 != *it)
 					is_equal_sofar = false;
@@ -306,19 +370,60 @@ namespace lpcompare {
 	}
 
 	/**
-	Dumps a Constraint instance to an ostream in a text format.
+	Dumps a Constraint instance to an ostream in a text format, with its location and original
+	text if known.
 	\param cons Constraint to dump.
 	\param out
+	\param source Original text of the constraint, Source.Length bytes, nullptr to leave it out.
+	*/
+	void Constraint::dump(const Constraint &cons, std::ostream &out, const char *source) {
+
+		out << " Name: " << cons.Name;
+		WriteLocation(cons.Source, out);
+
+		if (source != nullptr)
+			WriteSourceText(source, cons.Source.Length, "  ", out);
+
+		out << '\n';
+		out << "  " << cons.RHS << " " << get_constraintop(cons.Sign) << '\n';
+
+		for (const auto &term : cons.Terms) {
+			out << "  " << term.coeff << " * " << term.varName << '\n';
+		}
+
+		out << '\n';
+	}
+
+	/**
+	Writes a Constraint instance to an ostream as a line of an LP file. Numbers are written
+	with enough digits to parse back to the same values.
+	\param cons Constraint to write.
+	\param out
 	*/
-	void Constraint::dump(const Constraint &cons, std::ostream &out) {
+	void Constraint::writeLP(const Constraint &cons, std::ostream &out) {
+
+		char number[32];
+
+		out << " ";
+		if (!cons.Name.empty())
+			out << cons.Name << ":";
+
+		for (std::size_t i = 0; i < cons.Terms.size(); i++) {
+			const auto &term = cons.Terms[i];
+
+			std::snprintf(number, sizeof(number), "%.17g", std::fabs(term.coeff));
 
-		out << " Name: " << cons.Name << std::endl;
-		out << "  " << cons.RHS << " " << get_constraintop(cons.Sign) << std::endl;
+			if (term.coeff < 0)
+				out << " - ";
+			else if (i > 0)
+				out << " + ";
+			else
+				out << " ";
 
-		for (auto term : *cons.Terms) {
-			out << "  " << term.coeff << " * " << term.varName << std::endl;
+			out << number << " " << term.varName;
 		}
 
-		out << std::endl;
+		std::snprintf(number, sizeof(number), "%.17g", cons.RHS);
+		out << " " << get_constraintop(cons.Sign) << " " << number << '\n';
 	}
 }
@@ -29,6 +29,7 @@
 #include <string>
 #include <vector>
 #include "Term.h"
+#include "SourceLocation.h"
 
 namespace lpcompare {
 
@@ -52,42 +53,26 @@ namespace lpcompare {
 	class Constraint{
 		ConstraintOp Sign; /**< Sign (operator) of the constraint. */
 		double RHS;
-		std::vector<Term> *Terms;
+		std::vector<Term> Terms;
 	public:
 		std::string Name;
+		SourceLocation Source; /**< Where the constraint was read from, not compared. */
 
-		Constraint() 
-		{
-			Terms = new std::vector<Term>();
-		}
+		Constraint() : Sign(ConstraintOp::EQ), RHS(0) {}
 
-		Constraint(Constraint&& other)
-			: Terms(nullptr)
-		{
-			Sign = other.Sign;
-			RHS = other.RHS;
-			Terms = other.Terms;
-		}
+		Constraint(std::string name, std::vector<Term> terms, ConstraintOp sign, double rhs);
 
-		Constraint& operator=(Constraint&& other)
-		{
-			if (this != &other)
-			{
-				Sign = other.Sign;
-				RHS = other.RHS;
-				Terms = other.Terms;
+		ConstraintOp GetSign() const { return Sign; }
+		double GetRHS() const { return RHS; }
+		const std::vector<Term> &GetTerms() const { return Terms; }
 
-				other.Terms = nullptr;
-			}
-
-			return *this;
-		}
-
-		static Constraint *Parse(std::string& line);
+		static Constraint *Parse(std::string& line, bool canonical = false);
+		void Canonicalize();
 		bool operator==(const Constraint &other) const;
 		bool operator!=(const Constraint &other) const;
 		bool operator<(const Constraint &other) const;
-		static void dump(const Constraint &cons, std::ostream &out);
+		static void dump(const Constraint &cons, std::ostream &out, const char *source = nullptr);
+		static void writeLP(const Constraint &cons, std::ostream &out);
 
 		friend std::ostream &operator<<(std::ostream &output, const Constraint &cons)
 		{
@@ -95,6 +80,10 @@ namespace lpcompare {
 			return output;
 		}
 	};
+
+	ConstraintOp get_constraintop(std::string op);
+	std::string get_constraintop(ConstraintOp op);
+	int get_constraintop_val(ConstraintOp op);
 }
 
 #endif // CONSTRAINT_H
\ No newline at end of file
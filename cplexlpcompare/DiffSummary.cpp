@@ -0,0 +1,223 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#include "DiffSummary.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include <boost/algorithm/string.hpp>
+
+#include "Hash.h"
+
+/**
+\file DiffSummary.cpp
+Implements aggregation of differences into groups.
+*/
+
+namespace lpcompare {
+
+	/**
+	Creates a grouper using a regex. The first capture of the regex is the group, the whole match
+	if it has no captures, names it does not match are grouped together.
+
+	\param regex Regex searched in names, empty for the default grouping.
+	*/
+	NameGrouper::NameGrouper(const std::string &regex) {
+		if (!regex.empty())
+			pattern.reset(new boost::regex(regex));
+	}
+
+	/**
+	Finds the group of a name.
+
+	\param name Element name.
+	\return Group of the name.
+	*/
+	std::string NameGrouper::Group(const std::string &name) const {
+
+		if (!pattern) {
+			auto end = name.find_first_of("0123456789[(");
+			return end == std::string::npos ? name : name.substr(0, end);
+		}
+
+		boost::smatch match;
+		if (!boost::regex_search(name, match, *pattern))
+			return "(other)";
+
+		return match.size() > 1 ? match[1].str() : match[0].str();
+	}
+
+	static const std::string &name_of(const std::string &var) { return var; }
+	static const std::string &name_of(const Bound &bound) { return bound.VarName; }
+	static const std::string &name_of(const Constraint &cons) { return cons.Name; }
+
+	static std::string text_of(const std::string &var) { return var; }
+
+	static std::string text_of(const Bound &bound) {
+		std::ostringstream out;
+		Bound::writeLP(bound, out);
+		return boost::trim_copy(out.str());
+	}
+
+	static std::string text_of(const Constraint &cons) {
+		std::ostringstream out;
+		Constraint::writeLP(cons, out);
+		return boost::trim_copy(out.str());
+	}
+
+	/**
+	Finds the term count bucket of an element, powers of two for constraints.
+
+	\return Bucket label, empty for elements without terms.
+	*/
+	static std::string terms_of(const std::string&) { return std::string(); }
+	static std::string terms_of(const Bound&) { return std::string(); }
+
+	static std::string terms_of(const Constraint &cons) {
+		auto terms = cons.GetTerms().size();
+		if (terms <= 2)
+			return "terms " + std::to_string(terms);
+
+		std::size_t upper = 4;
+		while (upper < terms)
+			upper *= 2;
+
+		return "terms " + std::to_string(upper / 2 + 1) + "-" + std::to_string(upper);
+	}
+
+	/**
+	Counts an element in its group.
+
+	\param element Differing element.
+	\param kind Change kind.
+	\param nameHash Hash of the element name, 0 for unnamed elements.
+	\return Group of the element.
+	*/
+	template <typename T>
+	typename SectionSummary<T>::Group &SectionSummary<T>::Add(const T &element, const char *kind, std::uint64_t nameHash) {
+
+		auto key = grouper.Group(name_of(element)) + '\t' + kind;
+		auto terms = terms_of(element);
+		if (!terms.empty())
+			key += '\t' + terms;
+
+		auto &group = groups[key];
+		group.Count++;
+
+		if (group.Examples.size() < maxExamples)
+			group.Examples.emplace_back(nameHash, text_of(element));
+
+		return group;
+	}
+
+	/**
+	Counts an element only in the first model as removed.
+
+	\param element Differing element.
+	*/
+	template <typename T>
+	void SectionSummary<T>::FirstExceptSecond(const T &element) {
+
+		const auto &name = name_of(element);
+		auto nameHash = name.empty() ? 0 : HashBytes(name.data(), name.size());
+		auto &group = Add(element, "removed", nameHash);
+
+		if (!name.empty())
+			removed.emplace(nameHash, &group);
+	}
+
+	/**
+	Counts an element only in the second model as changed if an element of the same name was
+	removed, as added otherwise.
+
+	\param element Differing element.
+	*/
+	template <typename T>
+	void SectionSummary<T>::SecondExceptFirst(const T &element) {
+
+		const auto &name = name_of(element);
+		auto nameHash = name.empty() ? 0 : HashBytes(name.data(), name.size());
+		auto it = name.empty() ? removed.end() : removed.find(nameHash);
+
+		if (it == removed.end()) {
+			Add(element, "added", nameHash);
+			return;
+		}
+
+		it->second->Count--;
+		removed.erase(it);
+		Add(element, "changed", nameHash);
+	}
+
+	/**
+	Writes the groups, largest first, with their examples.
+
+	\param detail_name Given name of the detail.
+	\param out Stream to write to.
+	*/
+	template <typename T>
+	void SectionSummary<T>::Write(const std::string &detail_name, std::ostream &out) const {
+
+		std::vector<std::pair<std::size_t, const std::string*>> order;
+		for (const auto &entry : groups) {
+			if (entry.second.Count > 0)
+				order.emplace_back(entry.second.Count, &entry.first);
+		}
+
+		if (order.empty())
+			return;
+
+		std::stable_sort(order.begin(), order.end(), [](const std::pair<std::size_t, const std::string*> &a, const std::pair<std::size_t, const std::string*> &b) {
+			return a.first > b.first;
+		});
+
+		out << detail_name << " differences by group:" << std::endl;
+
+		// removed examples written per name, at most as many as are still removed.
+		std::unordered_map<std::uint64_t, std::size_t> shown;
+
+		for (const auto &entry : order) {
+			const auto &group = groups.at(*entry.second);
+			bool isRemoved = entry.second->find("\tremoved") != std::string::npos;
+
+			auto key = *entry.second;
+			std::replace(key.begin(), key.end(), '\t', ' ');
+			out << "  " << entry.first << "\t" << key << std::endl;
+
+			for (const auto &example : group.Examples) {
+				// removed elements whose name reappeared are counted as changed.
+				if (isRemoved && example.first != 0 && shown[example.first]++ >= removed.count(example.first))
+					continue;
+
+				out << "    " << example.second << std::endl;
+			}
+		}
+	}
+
+	template class SectionSummary<std::string>;
+	template class SectionSummary<Bound>;
+	template class SectionSummary<Constraint>;
+}
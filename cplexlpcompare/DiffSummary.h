@@ -0,0 +1,101 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef DIFFSUMMARY_H
+#define DIFFSUMMARY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/regex.hpp>
+
+#include "LPCompare.h"
+
+/**
+\file DiffSummary.h
+Defines aggregation of differences into groups instead of dumps.
+*/
+
+namespace lpcompare {
+
+	/**
+	\class NameGrouper
+	Finds the group of an element name: the prefix before the first index by default, e.g. <tt>cap_</tt>
+	for <tt>cap_12</tt> and <tt>flow</tt> for <tt>flow(3,4)</tt>, or the first capture of a regex.
+	*/
+	class NameGrouper {
+
+		std::unique_ptr<boost::regex> pattern;
+
+	public:
+
+		NameGrouper() {}
+		explicit NameGrouper(const std::string &regex);
+
+		std::string Group(const std::string &name) const;
+	};
+
+	/**
+	\class SectionSummary
+	Aggregates the differences of a section by name group, change kind and, for constraints, number of
+	terms, keeping a few examples per group. An element only in the second model is a change if an
+	element of the same name is only in the first model, which costs a hash entry per differing named
+	element of the first model; all other memory is proportional to the number of groups.
+	*/
+	template <typename T>
+	class SectionSummary : public DiffSink<T> {
+
+		struct Group {
+			std::size_t Count = 0;
+			std::vector<std::pair<std::uint64_t, std::string>> Examples; /**< Name hashes and texts of elements. */
+		};
+
+		const NameGrouper &grouper;
+		std::size_t maxExamples;
+		std::map<std::string, Group> groups;
+		std::unordered_multimap<std::uint64_t, Group*> removed; /**< Groups of named elements only in the first model, one entry per element. */
+
+		Group &Add(const T &element, const char *kind, std::uint64_t nameHash);
+
+	public:
+
+		SectionSummary(const NameGrouper &grouper, std::size_t maxExamples = 3)
+			: grouper(grouper), maxExamples(maxExamples) {}
+
+		void FirstExceptSecond(const T &element) override;
+		void SecondExceptFirst(const T &element) override;
+
+		void Write(const std::string &detail_name, std::ostream &out) const;
+	};
+}
+
+#endif // DIFFSUMMARY_H
@@ -0,0 +1,368 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#include "DiffWriter.h"
+
+#include <cmath>
+#include <cstdio>
+#include <boost/filesystem.hpp>
+
+#include "BinaryIO.h"
+
+/**
+\file DiffWriter.cpp
+Implements DiffWriter class.
+*/
+
+namespace lpcompare {
+
+	/**
+	Finds a DumpFormat for its name.
+
+	\param name One of text, jsonl or binary.
+	\param format Format found.
+	\return false if the name is unknown.
+	*/
+	bool ParseDumpFormat(const std::string &name, DumpFormat &format) {
+		if (name == "text")
+			format = DumpFormat::Text;
+		else if (name == "jsonl")
+			format = DumpFormat::Jsonl;
+		else if (name == "binary")
+			format = DumpFormat::Binary;
+		else
+			return false;
+
+		return true;
+	}
+
+	/**
+	Finds the filename extension of dumps written with these options.
+
+	\return extension including the leading dot.
+	*/
+	std::string DumpOptions::Extension() const {
+		std::string extension = Format == DumpFormat::Jsonl ? ".jsonl" : Format == DumpFormat::Binary ? ".bin" : ".log";
+		return Compress ? extension + ".zst" : extension;
+	}
+
+	/**
+	Appends a JSON string literal.
+
+	\param out String to append to.
+	\param value Value to quote.
+	*/
+	void append_json_string(std::string &out, const std::string &value) {
+
+		out.push_back('"');
+
+		for (char c : value) {
+			switch (c) {
+			case '"': out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\n': out += "\\n"; break;
+			case '\r': out += "\\r"; break;
+			case '\t': out += "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20) {
+					char escaped[8];
+					std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+					out += escaped;
+				}
+				else {
+					out.push_back(c);
+				}
+			}
+		}
+
+		out.push_back('"');
+	}
+
+	/**
+	Appends a number that reads back to the same double. JSON has no infinities and NaN, they
+	are written as the strings "inf", "-inf" and "nan" as in LP files.
+
+	\param out String to append to.
+	\param value Value to format.
+	*/
+	void append_json_number(std::string &out, double value) {
+		if (std::isnan(value)) {
+			out += "\"nan\"";
+			return;
+		}
+
+		if (std::isinf(value)) {
+			out += value < 0 ? "\"-inf\"" : "\"inf\"";
+			return;
+		}
+
+		char number[32];
+		std::snprintf(number, sizeof(number), "%.17g", value);
+		out += number;
+	}
+
+	/**
+	Creates a dump file and writes its header.
+
+	\param filename File to create.
+	\param options Format and compression of the dump.
+	\param side firstEXCEPTsecond or secondEXCEPTfirst.
+	\param section Section name.
+	\return false if the file cannot be created.
+	*/
+	bool DiffWriter::Open(const std::string &filename, const DumpOptions &options, const std::string &side, const std::string &section) {
+
+		if (!writer.Open(filename, options.Compress))
+			return false;
+
+		this->options = options;
+		this->side = side;
+		this->section = section;
+
+		// elements of firstEXCEPTsecond come from the first model.
+		const auto &sourceFilename = side == "firstEXCEPTsecond" ? options.FirstSource : options.SecondSource;
+
+		if (!sourceFilename.empty() && boost::filesystem::exists(sourceFilename) && boost::filesystem::file_size(sourceFilename) > 0) {
+			try {
+				source.open(sourceFilename);
+			}
+			catch (const std::exception &) {
+				// the dump is written without original text.
+			}
+		}
+
+		if (options.Format == DumpFormat::Text) {
+			stream << side << " " << section << '\n';
+		}
+		else if (options.Format == DumpFormat::Binary) {
+			record.assign("LPCD");
+			AppendU32(record, BinaryVersion);
+			AppendString(record, side);
+			AppendString(record, section);
+			writer.Write(record);
+		}
+
+		return true;
+	}
+
+	/**
+	Writes the remaining output and closes the dump.
+
+	\return false if any write failed.
+	*/
+	bool DiffWriter::Close() {
+		stream.flush();
+
+		if (source.is_open())
+			source.close();
+
+		return writer.Close();
+	}
+
+	/**
+	Finds the original text of an element in the source file of the dump.
+
+	\param location Location of the element.
+	\return Location.Length bytes of text, nullptr if there is no source file or the location is unknown.
+	*/
+	const char *DiffWriter::SourceText(const SourceLocation &location) const {
+
+		if (!source.is_open() || !location.IsKnown() || location.Offset + location.Length > source.size())
+			return nullptr;
+
+		return source.data() + location.Offset;
+	}
+
+	/**
+	Appends the location and the original text of an element to a JSON object, nothing if its
+	location is unknown.
+
+	\param location Location of the element.
+	*/
+	void DiffWriter::AppendJsonSource(const SourceLocation &location) {
+
+		if (!location.IsKnown())
+			return;
+
+		record += ",\"line\":" + std::to_string(location.Line);
+		record += ",\"offset\":" + std::to_string(location.Offset);
+		record += ",\"length\":" + std::to_string(location.Length);
+
+		auto text = SourceText(location);
+
+		if (text != nullptr) {
+			record += ",\"text\":";
+			append_json_string(record, std::string(text, location.Length));
+		}
+	}
+
+	/**
+	Appends the location of an element to a binary record.
+
+	\param record Record to append to.
+	\param location Location of the element.
+	*/
+	void append_location(std::string &record, const SourceLocation &location) {
+		AppendU64(record, location.Line);
+		AppendU64(record, location.Offset);
+		AppendU32(record, location.Length);
+	}
+
+	/**
+	Starts a JSON object with the side and section of the dump.
+	*/
+	void DiffWriter::BeginJson() {
+		record.assign("{\"side\":");
+		append_json_string(record, side);
+		record += ",\"section\":";
+		append_json_string(record, section);
+	}
+
+	/**
+	Writes a variable name.
+
+	\param var Variable name.
+	*/
+	void DiffWriter::Write(const std::string &var) {
+
+		switch (options.Format) {
+		case DumpFormat::Text:
+			stream << var << '\n';
+			break;
+
+		case DumpFormat::Jsonl:
+			BeginJson();
+			record += ",\"name\":";
+			append_json_string(record, var);
+			record += "}\n";
+			writer.Write(record);
+			break;
+
+		case DumpFormat::Binary:
+			record.clear();
+			AppendU8(record, 1);
+			AppendString(record, var);
+			writer.Write(record);
+			break;
+		}
+	}
+
+	/**
+	Writes a bound.
+
+	\param bound Bound to write.
+	*/
+	void DiffWriter::Write(const Bound &bound) {
+
+		switch (options.Format) {
+		case DumpFormat::Text:
+			Bound::dump(bound, stream, SourceText(bound.Source));
+			stream << '\n';
+			break;
+
+		case DumpFormat::Jsonl:
+			BeginJson();
+			record += ",\"name\":";
+			append_json_string(record, bound.VarName);
+			record += ",\"lb_op\":";
+			append_json_string(record, get_boundop(bound.LB_Op));
+			record += ",\"lb\":";
+			append_json_number(record, bound.LB);
+			record += ",\"ub_op\":";
+			append_json_string(record, get_boundop(invert(bound.UB_Op)));
+			record += ",\"ub\":";
+			append_json_number(record, bound.UB);
+			AppendJsonSource(bound.Source);
+			record += "}\n";
+			writer.Write(record);
+			break;
+
+		case DumpFormat::Binary:
+			record.clear();
+			AppendU8(record, 2);
+			AppendString(record, bound.VarName);
+			AppendU8(record, static_cast<std::uint8_t>(bound.LB_Op));
+			AppendF32(record, bound.LB);
+			AppendU8(record, static_cast<std::uint8_t>(bound.UB_Op));
+			AppendF32(record, bound.UB);
+			append_location(record, bound.Source);
+			writer.Write(record);
+			break;
+		}
+	}
+
+	/**
+	Writes a constraint.
+
+	\param cons Constraint to write.
+	*/
+	void DiffWriter::Write(const Constraint &cons) {
+
+		switch (options.Format) {
+		case DumpFormat::Text:
+			Constraint::dump(cons, stream, SourceText(cons.Source));
+			stream << '\n';
+			break;
+
+		case DumpFormat::Jsonl:
+			BeginJson();
+			record += ",\"name\":";
+			append_json_string(record, cons.Name);
+			record += ",\"sign\":";
+			append_json_string(record, get_constraintop(cons.GetSign()));
+			record += ",\"rhs\":";
+			append_json_number(record, cons.GetRHS());
+			record += ",\"terms\":[";
+			for (std::size_t i = 0; i < cons.GetTerms().size(); i++) {
+				const auto &term = cons.GetTerms()[i];
+				record += i == 0 ? "[" : ",[";
+				append_json_number(record, term.coeff);
+				record += ",";
+				append_json_string(record, term.varName);
+				record += "]";
+			}
+			record += "]";
+			AppendJsonSource(cons.Source);
+			record += "}\n";
+			writer.Write(record);
+			break;
+
+		case DumpFormat::Binary:
+			record.clear();
+			AppendU8(record, 3);
+			AppendString(record, cons.Name);
+			AppendU8(record, static_cast<std::uint8_t>(cons.GetSign()));
+			AppendF64(record, cons.GetRHS());
+			AppendU32(record, static_cast<std::uint32_t>(cons.GetTerms().size()));
+			for (const auto &term : cons.GetTerms()) {
+				AppendF64(record, term.coeff);
+				AppendString(record, term.varName);
+			}
+			append_location(record, cons.Source);
+			writer.Write(record);
+			break;
+		}
+	}
+}
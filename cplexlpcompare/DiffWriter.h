@@ -0,0 +1,109 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef DIFFWRITER_H
+#define DIFFWRITER_H
+
+#include <ostream>
+#include <string>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include "AsyncFileWriter.h"
+#include "Bound.h"
+#include "Constraint.h"
+
+namespace lpcompare {
+
+	/**
+	Formats of difference dumps.
+	*/
+	enum class DumpFormat
+	{
+		Text = 0, /**< Human-readable text, as written by Constraint::dump and Bound::dump. */
+		Jsonl,    /**< One JSON object per element. */
+		Binary,   /**< Compact little-endian records, see DiffWriter. */
+	};
+
+	bool ParseDumpFormat(const std::string &name, DumpFormat &format);
+
+	/**
+	\class DumpOptions
+	Selects how difference dumps are written.
+	*/
+	struct DumpOptions {
+		DumpFormat Format = DumpFormat::Text;
+		bool Compress = false; /**< Compress dumps with zstd. */
+		std::string FirstSource;  /**< File the first model was read from, empty to leave the original text of elements out. */
+		std::string SecondSource; /**< File the second model was read from, empty to leave the original text of elements out. */
+
+		std::string Extension() const;
+	};
+
+	/**
+	\class DiffWriter
+	Writes the elements of one difference dump through an AsyncFileWriter.
+
+	The binary format starts with the magic <tt>LPCD</tt>, a u32 version, and the side and section
+	names. Every record starts with a u8 type: 1 for a variable name, 2 for a bound, 3 for a constraint.
+	Strings are a u32 length followed by bytes, numbers are little-endian.
+	- variable: name
+	- bound: name, u8 LB_Op, f32 LB, u8 UB_Op, f32 UB, location
+	- constraint: name, u8 sign, f64 RHS, u32 term count, then f64 coefficient and name per term, location
+	- location: u64 line, u64 byte offset, u32 length of the element in the file it was read from, all 0 if unknown
+
+	Text and JSON dumps have the location as well and, when the source file of the side is given
+	in DumpOptions, the original text of bounds and constraints.
+	*/
+	class DiffWriter {
+
+		AsyncFileWriter writer;
+		WriterStreamBuf streamBuf;
+		std::ostream stream;
+		DumpOptions options;
+		std::string side;
+		std::string section;
+		std::string record;
+		boost::iostreams::mapped_file_source source;
+
+		void BeginJson();
+		void AppendJsonSource(const SourceLocation &location);
+		const char *SourceText(const SourceLocation &location) const;
+
+	public:
+
+		static const std::uint32_t BinaryVersion = 2;
+
+		DiffWriter() : streamBuf(writer), stream(&streamBuf) {}
+
+		bool Open(const std::string &filename, const DumpOptions &options, const std::string &side, const std::string &section);
+		bool Close();
+
+		void Write(const std::string &var);
+		void Write(const Bound &bound);
+		void Write(const Constraint &cons);
+	};
+}
+
+#endif // DIFFWRITER_H
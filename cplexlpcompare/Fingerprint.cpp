@@ -0,0 +1,326 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#include "Fingerprint.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include <boost/function_output_iterator.hpp>
+
+#include "BinaryIO.h"
+
+/**
+\file Fingerprint.cpp
+Implements element hashes and fingerprints of model sections.
+*/
+
+namespace lpcompare {
+
+	/**
+	Finds the bits of a number, treating -0 as 0.
+
+	\param value Number.
+	\return Bits of the number.
+	*/
+	std::uint64_t NumberBits(double value) {
+		if (value == 0)
+			value = 0;
+
+		std::uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	/**
+	Normalizes a ConstraintOp, LP files read < as <= and > as >=.
+
+	\param op Operation to normalize.
+	\return Normalized operation.
+	*/
+	ConstraintOp NormalizeOp(ConstraintOp op) {
+		if (op == ConstraintOp::LT)
+			return ConstraintOp::LTE;
+		if (op == ConstraintOp::GT)
+			return ConstraintOp::GTE;
+		return op;
+	}
+
+	/**
+	Normalizes a BoundOp, LP files read < as <= and > as >=.
+
+	\param op Operation to normalize.
+	\return Normalized operation.
+	*/
+	BoundOp NormalizeOp(BoundOp op) {
+		if (op == BoundOp::LT)
+			return BoundOp::LTE;
+		if (op == BoundOp::GT)
+			return BoundOp::GTE;
+		return op;
+	}
+
+	/**
+	Hashes a variable name.
+
+	\param name Variable name.
+	\return 64-bit hash of the name.
+	*/
+	std::uint64_t HashElement(const std::string &name) {
+		return HashBytes(name.data(), name.size());
+	}
+
+	/**
+	Hashes a Bound. Operations are hashed as they are, since bounds compare them exactly.
+
+	\param bound Bound to hash.
+	\return 64-bit hash of the bound.
+	*/
+	std::uint64_t HashElement(const Bound &bound) {
+		auto h = HashElement(bound.VarName);
+		h = HashCombine(h, NumberBits(bound.LB));
+		h = HashCombine(h, static_cast<std::uint64_t>(bound.LB_Op));
+		h = HashCombine(h, NumberBits(bound.UB));
+		h = HashCombine(h, static_cast<std::uint64_t>(bound.UB_Op));
+		return h;
+	}
+
+	/**
+	Hashes a Constraint. Names are not hashed as they are not compared, terms are hashed in
+	their sorted order.
+
+	\param cons Constraint to hash.
+	\return 64-bit hash of the constraint.
+	*/
+	std::uint64_t HashElement(const Constraint &cons) {
+		std::uint64_t h = cons.GetTerms().size();
+
+		for (const auto &term : cons.GetTerms()) {
+			h = HashCombine(h, HashElement(term.varName));
+			h = HashCombine(h, NumberBits(term.coeff));
+		}
+
+		h = HashCombine(h, static_cast<std::uint64_t>(NormalizeOp(cons.GetSign())));
+		h = HashCombine(h, NumberBits(cons.GetRHS()));
+		return h;
+	}
+
+	const char FINGERPRINT_MAGIC [] = "LPFP";
+	const std::uint32_t FingerprintVersion = 2;
+
+	/**
+	Creates an empty fingerprint.
+
+	\param buckets Number of buckets per section.
+	\param rows Keep the hash of every element.
+	*/
+	ModelFingerprint::ModelFingerprint(std::uint32_t buckets, bool rows)
+		: bucketCount(buckets > 0 ? buckets : 1), keepRows(rows)
+	{
+		for (auto section : { &Generals, &Binaries, &SosVars, &Bounds, &Constraints })
+			section->Buckets.resize(bucketCount);
+	}
+
+	/**
+	Adds an element hash to a section.
+
+	\param section Section of the element.
+	\param hash Hash of the element.
+	*/
+	void ModelFingerprint::Add(SectionFingerprint &section, std::uint64_t hash) {
+		section.Total.Add(hash);
+		section.Buckets[Bucket(hash)].Add(hash);
+
+		if (keepRows)
+			section.Rows.push_back(hash);
+	}
+
+	/**
+	Sorts row hashes once the model is read.
+	*/
+	void ModelFingerprint::Finish() {
+		for (auto section : { &Generals, &Binaries, &SosVars, &Bounds, &Constraints })
+			std::sort(section->Rows.begin(), section->Rows.end());
+	}
+
+	static void append_hash(std::string &out, const MultisetHash &hash) {
+		AppendU64(out, hash.Count);
+		AppendU64(out, hash.Sum);
+		AppendU64(out, hash.MixedSum);
+	}
+
+	static MultisetHash read_hash(BinaryReader &in) {
+		MultisetHash hash;
+		hash.Count = in.ReadU64();
+		hash.Sum = in.ReadU64();
+		hash.MixedSum = in.ReadU64();
+		return hash;
+	}
+
+	/**
+	Writes the fingerprint to a file: magic, version, bucket count, row flag, then for every section
+	its total, its buckets and, with rows, the sorted row hashes.
+
+	\param filename Name of the fingerprint file.
+	\return false if the file cannot be written.
+	*/
+	bool ModelFingerprint::Write(const std::string &filename) const {
+
+		std::string data(FINGERPRINT_MAGIC, 4);
+		AppendU32(data, FingerprintVersion);
+		AppendU32(data, bucketCount);
+		AppendU8(data, keepRows ? 1 : 0);
+
+		for (auto section : { &Generals, &Binaries, &SosVars, &Bounds, &Constraints }) {
+			append_hash(data, section->Total);
+
+			for (const auto &bucket : section->Buckets)
+				append_hash(data, bucket);
+
+			if (keepRows) {
+				AppendU64(data, section->Rows.size());
+				for (auto row : section->Rows)
+					AppendU64(data, row);
+			}
+		}
+
+		std::ofstream out(filename, std::ios::binary);
+		out.write(data.data(), data.size());
+		out.flush();
+
+		if (!out) {
+			std::cout << "Cannot write fingerprint: " << filename << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	/**
+	Reads a fingerprint written by Write.
+
+	\param filename Name of the fingerprint file.
+	\return false if the file cannot be read or is malformed.
+	*/
+	bool ModelFingerprint::Read(const std::string &filename) {
+
+		std::ifstream in(filename, std::ios::binary);
+		if (!in) {
+			std::cout << "Cannot read fingerprint: " << filename << std::endl;
+			return false;
+		}
+
+		std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		BinaryReader reader(data);
+
+		if (data.compare(0, 4, FINGERPRINT_MAGIC, 4) != 0) {
+			std::cout << "Not a fingerprint file: " << filename << std::endl;
+			return false;
+		}
+
+		reader.ReadU32();
+		if (reader.ReadU32() != FingerprintVersion) {
+			std::cout << "Unsupported fingerprint version: " << filename << std::endl;
+			return false;
+		}
+
+		bucketCount = reader.ReadU32();
+		keepRows = reader.ReadU8() != 0;
+
+		if (bucketCount == 0 || bucketCount > data.size()) {
+			std::cout << "Malformed fingerprint: " << filename << std::endl;
+			return false;
+		}
+
+		for (auto section : { &Generals, &Binaries, &SosVars, &Bounds, &Constraints }) {
+			section->Total = read_hash(reader);
+
+			section->Buckets.resize(bucketCount);
+			for (auto &bucket : section->Buckets)
+				bucket = read_hash(reader);
+
+			section->Rows.clear();
+			if (keepRows) {
+				auto rows = reader.ReadU64();
+				if (!reader.Good || rows > data.size() / 8) {
+					reader.Good = false;
+					break;
+				}
+
+				section->Rows.resize(static_cast<std::size_t>(rows));
+				for (auto &row : section->Rows)
+					row = reader.ReadU64();
+			}
+		}
+
+		if (!reader.Good || !reader.AtEnd()) {
+			std::cout << "Malformed fingerprint: " << filename << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	/**
+	Compares a section of two fingerprints with the same bucket count. Only buckets are compared
+	when the totals differ, row hashes are compared when both fingerprints have them.
+
+	\param first Section of the first fingerprint.
+	\param second Section of the second fingerprint.
+	\return Differences of the section.
+	*/
+	SectionFingerprintDiff ModelFingerprint::CompareSection(const SectionFingerprint &first, const SectionFingerprint &second) {
+
+		SectionFingerprintDiff diff;
+
+		if (first.Total == second.Total)
+			return diff;
+
+		diff.Equal = false;
+
+		for (std::size_t i = 0; i < first.Buckets.size() && i < second.Buckets.size(); i++) {
+			if (first.Buckets[i] != second.Buckets[i])
+				diff.Buckets.push_back(static_cast<std::uint32_t>(i));
+		}
+
+		if (first.Rows.size() == first.Total.Count && second.Rows.size() == second.Total.Count) {
+			diff.RowsCompared = true;
+
+			std::size_t count = 0;
+			auto counter = boost::make_function_output_iterator([&count](std::uint64_t) { count++; });
+
+			std::set_difference(first.Rows.begin(), first.Rows.end(), second.Rows.begin(), second.Rows.end(), counter);
+			diff.FirstExceptSecondCount = count;
+
+			count = 0;
+			std::set_difference(second.Rows.begin(), second.Rows.end(), first.Rows.begin(), first.Rows.end(), counter);
+			diff.SecondExceptFirstCount = count;
+		}
+
+		return diff;
+	}
+}
@@ -0,0 +1,176 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Hash.h"
+#include "LPModel.h"
+
+/**
+\file Fingerprint.h
+Defines order-independent fingerprints of model sections.
+*/
+
+namespace lpcompare {
+
+	std::uint64_t NumberBits(double value);
+	ConstraintOp NormalizeOp(ConstraintOp op);
+	BoundOp NormalizeOp(BoundOp op);
+
+	std::uint64_t HashElement(const std::string &name);
+	std::uint64_t HashElement(const Bound &bound);
+	std::uint64_t HashElement(const Constraint &cons);
+
+	/**
+	\class MultisetHash
+	Order-independent hash of a multiset of element hashes. Two sums of differently mixed hashes
+	are kept instead of a XOR, so that duplicate elements do not cancel each other.
+	*/
+	class MultisetHash {
+	public:
+		std::uint64_t Count = 0;
+		std::uint64_t Sum = 0;
+		std::uint64_t MixedSum = 0;
+
+		/**
+		Adds an element hash to the multiset.
+
+		\param hash Hash of the element.
+		*/
+		void Add(std::uint64_t hash) {
+			Count++;
+			Sum += hash;
+			MixedSum += Mix64(hash ^ 0x5851f42d4c957f2dULL);
+		}
+
+		bool operator==(const MultisetHash &other) const {
+			return Count == other.Count && Sum == other.Sum && MixedSum == other.MixedSum;
+		}
+
+		bool operator!=(const MultisetHash &other) const {
+			return !(*this == other);
+		}
+	};
+
+	/**
+	\class FingerprintSink
+	Fingerprints every section of a model while it is parsed, holding no elements in memory.
+	*/
+	class FingerprintSink : public ModelSink {
+	public:
+		MultisetHash Generals;
+		MultisetHash Binaries;
+		MultisetHash SosVars;
+		MultisetHash Bounds;
+		MultisetHash Constraints;
+
+		void AddGeneral(std::string name) override { Generals.Add(HashElement(name)); }
+		void AddBinary(std::string name) override { Binaries.Add(HashElement(name)); }
+		void AddSosVar(std::string name) override { SosVars.Add(HashElement(name)); }
+		void AddBound(Bound bound) override { Bounds.Add(HashElement(bound)); }
+		void AddConstraint(Constraint cons) override { Constraints.Add(HashElement(cons)); }
+	};
+
+	/**
+	\class SectionFingerprint
+	Fingerprint of a section as a two-level tree: the total over the section and one multiset hash
+	per bucket of element hashes. Buckets that differ show which part of a section changed.
+	*/
+	class SectionFingerprint {
+	public:
+		MultisetHash Total;
+		std::vector<MultisetHash> Buckets;
+		std::vector<std::uint64_t> Rows; /**< Element hashes, sorted once the model is read. */
+	};
+
+	/**
+	\class SectionFingerprintDiff
+	Differences of a section found from fingerprints alone.
+	*/
+	class SectionFingerprintDiff {
+	public:
+		bool Equal = true;
+		std::vector<std::uint32_t> Buckets; /**< Buckets that differ. */
+		bool RowsCompared = false; /**< Row counts below are known, both fingerprints have row hashes. */
+		std::size_t FirstExceptSecondCount = 0;
+		std::size_t SecondExceptFirstCount = 0;
+	};
+
+	/**
+	\class ModelFingerprint
+	Bucketed fingerprints of every section of a model, optionally with the hash of every element,
+	written to a small file so that models can be compared without their LP files.
+	*/
+	class ModelFingerprint : public ModelSink {
+
+		std::uint32_t bucketCount;
+		bool keepRows;
+
+		void Add(SectionFingerprint &section, std::uint64_t hash);
+
+	public:
+
+		SectionFingerprint Generals;
+		SectionFingerprint Binaries;
+		SectionFingerprint SosVars;
+		SectionFingerprint Bounds;
+		SectionFingerprint Constraints;
+
+		explicit ModelFingerprint(std::uint32_t buckets = 256, bool rows = false);
+
+		std::uint32_t BucketCount() const { return bucketCount; }
+		bool HasRows() const { return keepRows; }
+
+		/**
+		Finds the bucket of an element hash.
+
+		\param hash Hash of the element.
+		\return Bucket index.
+		*/
+		std::uint32_t Bucket(std::uint64_t hash) const {
+			return static_cast<std::uint32_t>(Mix64(hash ^ 0x2545f4914f6cdd1dULL) % bucketCount);
+		}
+
+		void AddGeneral(std::string name) override { Add(Generals, HashElement(name)); }
+		void AddBinary(std::string name) override { Add(Binaries, HashElement(name)); }
+		void AddSosVar(std::string name) override { Add(SosVars, HashElement(name)); }
+		void AddBound(Bound bound) override { Add(Bounds, HashElement(bound)); }
+		void AddConstraint(Constraint cons) override { Add(Constraints, HashElement(cons)); }
+
+		void Finish();
+
+		bool Write(const std::string &filename) const;
+		bool Read(const std::string &filename);
+
+		static SectionFingerprintDiff CompareSection(const SectionFingerprint &first, const SectionFingerprint &second);
+	};
+}
+
+#endif // FINGERPRINT_H
@@ -0,0 +1,98 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+\file Hash.h
+Defines 64-bit hash functions used to key models and entities.
+*/
+
+namespace lpcompare {
+
+	/**
+	Finalizes a 64-bit value so that every input bit affects every output bit (splitmix64).
+
+	\param x Value to mix.
+	\return Mixed value.
+	*/
+	inline std::uint64_t Mix64(std::uint64_t x) {
+		x ^= x >> 30;
+		x *= 0xbf58476d1ce4e5b9ULL;
+		x ^= x >> 27;
+		x *= 0x94d049bb133111ebULL;
+		x ^= x >> 31;
+		return x;
+	}
+
+	/**
+	Combines a hash with another value, order dependent.
+
+	\param seed Hash so far.
+	\param value Value to add.
+	\return Combined hash.
+	*/
+	inline std::uint64_t HashCombine(std::uint64_t seed, std::uint64_t value) {
+		return Mix64(seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+	}
+
+	/**
+	Hashes a byte range eight bytes at a time.
+
+	\param data Bytes to hash.
+	\param length Number of bytes.
+	\param seed Initial value, different seeds give independent hashes.
+	\return 64-bit hash of the bytes.
+	*/
+	inline std::uint64_t HashBytes(const void *data, std::size_t length, std::uint64_t seed = 0) {
+
+		auto p = static_cast<const unsigned char*>(data);
+		std::uint64_t h = seed ^ (length * 0x9e3779b97f4a7c15ULL);
+		std::uint64_t word;
+
+		while (length >= 8) {
+			std::memcpy(&word, p, 8);
+			h = (h ^ Mix64(word)) * 0x9fb21c651e98df25ULL;
+			h = (h << 29) | (h >> 35);
+			p += 8;
+			length -= 8;
+		}
+
+		if (length > 0) {
+			word = 0;
+			std::memcpy(&word, p, length);
+			h = (h ^ Mix64(word ^ 0xff)) * 0x9fb21c651e98df25ULL;
+		}
+
+		return Mix64(h);
+	}
+}
+
+#endif // HASH_H
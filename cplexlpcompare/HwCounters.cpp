@@ -0,0 +1,356 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#include "HwCounters.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+\file HwCounters.cpp
+Implements HwCounters and HwScope classes.
+*/
+
+namespace lpcompare {
+
+	static std::atomic<bool> enabled(false);
+	static std::mutex phases_mutex;
+	static std::string current_phase;
+	static std::vector<std::pair<std::string, HwCounterValues>> phases; /**< Totals in the order phases began. */
+
+	/**
+	Counters of the calling thread, opened on first use and closed when the thread exits.
+	*/
+	struct ThreadCounters {
+		int Fds[HW_EVENTS];
+		bool Opened = false;
+
+		ThreadCounters() {
+			for (auto &fd : Fds)
+				fd = -1;
+		}
+
+		~ThreadCounters() {
+#ifdef __linux__
+			for (auto fd : Fds)
+				if (fd >= 0)
+					close(fd);
+#endif
+		}
+
+		/**
+		Opens a counter for every event, events that cannot be counted are left out.
+
+		\return errno of the first counter that cannot be opened, 0 if all are.
+		*/
+		int Open() {
+
+			Opened = true;
+			int error = 0;
+
+#ifdef __linux__
+			const std::pair<std::uint32_t, std::uint64_t> events[HW_EVENTS] = {
+				{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+				{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+				{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+				{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+				{ PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+			};
+
+			for (std::size_t i = 0; i < HW_EVENTS; i++) {
+				perf_event_attr attr;
+				std::memset(&attr, 0, sizeof(attr));
+				attr.size = sizeof(attr);
+				attr.type = events[i].first;
+				attr.config = events[i].second;
+				attr.exclude_kernel = 1;
+				attr.exclude_hv = 1;
+				attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+				Fds[i] = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+
+				if (Fds[i] < 0 && error == 0)
+					error = errno;
+			}
+#else
+			error = ENOSYS;
+#endif
+
+			return error;
+		}
+
+		/**
+		Reads the counters of the thread.
+
+		\param counts Receives the counts of one thread.
+		*/
+		void Read(HwCounterValues &counts) {
+
+			if (!Opened)
+				Open();
+
+			counts.Threads = 1;
+
+			for (std::size_t i = 0; i < HW_EVENTS; i++) {
+				counts.Values[i] = 0;
+				counts.Available[i] = false;
+
+#ifdef __linux__
+				std::uint64_t values[3];
+
+				if (Fds[i] < 0 || read(Fds[i], values, sizeof(values)) != sizeof(values))
+					continue;
+
+				// scale up for the time the counter shared the hardware with others.
+				counts.Values[i] = values[2] == 0 ? 0
+					: static_cast<std::uint64_t>(static_cast<double>(values[0]) * values[1] / values[2]);
+				counts.Available[i] = true;
+#endif
+			}
+		}
+	};
+
+	static thread_local ThreadCounters thread_counters;
+	static thread_local HwCounterValues phase_start;
+
+	/**
+	Finds the counts between two readings of the same thread.
+
+	\param start Earlier reading.
+	\param end Later reading.
+	\return Counts of one thread.
+	*/
+	static HwCounterValues difference(const HwCounterValues &start, const HwCounterValues &end) {
+
+		HwCounterValues counts;
+		counts.Threads = 1;
+
+		for (std::size_t i = 0; i < HW_EVENTS; i++) {
+			counts.Available[i] = start.Available[i] && end.Available[i];
+			counts.Values[i] = counts.Available[i] && end.Values[i] > start.Values[i] ? end.Values[i] - start.Values[i] : 0;
+		}
+
+		return counts;
+	}
+
+	/**
+	Enables counting, opening the counters of the calling thread to check that they are available.
+
+	\param error Receives the reason if no counter can be opened.
+	\return false if no counter can be opened.
+	*/
+	bool HwCounters::Enable(std::string &error) {
+
+		auto code = thread_counters.Open();
+
+		bool any = false;
+		for (auto fd : thread_counters.Fds)
+			any = any || fd >= 0;
+
+		if (!any) {
+			error = std::strerror(code);
+			return false;
+		}
+
+		enabled = true;
+		return true;
+	}
+
+	/**
+	\return true if counting is enabled.
+	*/
+	bool HwCounters::IsEnabled() {
+		return enabled.load(std::memory_order_relaxed);
+	}
+
+	/**
+	Begins a phase, counted on the calling thread until EndPhase and on worker threads by HwScope.
+
+	\param phase Name of the phase.
+	*/
+	void HwCounters::BeginPhase(const std::string &phase) {
+
+		if (!IsEnabled())
+			return;
+
+		{
+			std::lock_guard<std::mutex> lock(phases_mutex);
+			current_phase = phase;
+		}
+
+		thread_counters.Read(phase_start);
+	}
+
+	/**
+	Ends the current phase and writes its counts.
+
+	\param out Stream to write the counts of all threads of the phase to.
+	*/
+	void HwCounters::EndPhase(std::ostream &out) {
+
+		if (!IsEnabled())
+			return;
+
+		HwCounterValues now;
+		thread_counters.Read(now);
+
+		std::string phase;
+		{
+			std::lock_guard<std::mutex> lock(phases_mutex);
+			phase.swap(current_phase);
+		}
+
+		Add(phase, difference(phase_start, now));
+
+		HwCounterValues counts;
+		if (Get(phase, counts)) {
+			out << " Hardware counters: ";
+			Write(counts, out);
+			out << std::endl;
+		}
+	}
+
+	/**
+	\return Name of the current phase, empty outside of phases.
+	*/
+	std::string HwCounters::CurrentPhase() {
+		std::lock_guard<std::mutex> lock(phases_mutex);
+		return current_phase;
+	}
+
+	/**
+	Adds counts to the totals of a phase.
+
+	\param phase Name of the phase.
+	\param counts Counts of one or more threads.
+	*/
+	void HwCounters::Add(const std::string &phase, const HwCounterValues &counts) {
+
+		std::lock_guard<std::mutex> lock(phases_mutex);
+
+		for (auto &entry : phases) {
+			if (entry.first != phase)
+				continue;
+
+			auto &total = entry.second;
+			for (std::size_t i = 0; i < HW_EVENTS; i++) {
+				total.Values[i] += counts.Values[i];
+				total.Available[i] = total.Available[i] && counts.Available[i];
+			}
+			total.Threads += counts.Threads;
+			return;
+		}
+
+		phases.emplace_back(phase, counts);
+	}
+
+	/**
+	Finds the totals of a phase.
+
+	\param phase Name of the phase.
+	\param counts Receives the totals.
+	\return false if nothing was counted for the phase.
+	*/
+	bool HwCounters::Get(const std::string &phase, HwCounterValues &counts) {
+
+		std::lock_guard<std::mutex> lock(phases_mutex);
+
+		for (const auto &entry : phases) {
+			if (entry.first == phase) {
+				counts = entry.second;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	Writes counts in a single line, n/a for events that could not be counted.
+
+	\param counts Counts to write.
+	\param out Stream to write to.
+	*/
+	void HwCounters::Write(const HwCounterValues &counts, std::ostream &out) {
+
+		const char *names[HW_EVENTS] = { "cycles", "instructions", "cache misses", "branch misses", "page faults" };
+
+		for (std::size_t i = 0; i < HW_EVENTS; i++) {
+			if (i > 0)
+				out << ", ";
+
+			if (counts.Available[i])
+				out << counts.Values[i] << " " << names[i];
+			else
+				out << "n/a " << names[i];
+
+			auto cycles = static_cast<std::size_t>(HwEvent::Cycles);
+			if (i == static_cast<std::size_t>(HwEvent::Instructions) && counts.Available[i] && counts.Available[cycles] && counts.Values[cycles] > 0)
+				out << " (" << static_cast<double>(counts.Values[i]) / counts.Values[cycles] << " IPC)";
+		}
+
+		out << " (counted on " << counts.Threads << " threads and tasks)";
+	}
+
+	/**
+	Starts counting the calling thread if counting is enabled and a phase is current.
+	*/
+	HwScope::HwScope() {
+
+		if (!HwCounters::IsEnabled())
+			return;
+
+		phase = HwCounters::CurrentPhase();
+		if (phase.empty())
+			return;
+
+		thread_counters.Read(start);
+		active = true;
+	}
+
+	/**
+	Adds the counts of the calling thread to the phase.
+	*/
+	HwScope::~HwScope() {
+
+		if (!active)
+			return;
+
+		HwCounterValues now;
+		thread_counters.Read(now);
+
+		HwCounters::Add(phase, difference(start, now));
+	}
+}
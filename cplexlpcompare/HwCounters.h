@@ -0,0 +1,100 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef HWCOUNTERS_H
+#define HWCOUNTERS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+namespace lpcompare {
+
+	/**
+	Hardware and software events counted per thread by HwCounters.
+	*/
+	enum class HwEvent
+	{
+		Cycles = 0,
+		Instructions,
+		CacheMisses,
+		BranchMisses,
+		PageFaults,
+	};
+
+	const std::size_t HW_EVENTS = 5; /**< Number of HwEvent values. */
+
+	/**
+	\class HwCounterValues
+	Counts of the events of HwEvent, scaled up for the time a counter was not scheduled.
+	*/
+	struct HwCounterValues {
+		std::uint64_t Values[HW_EVENTS] = {};
+		bool Available[HW_EVENTS] = {}; /**< The counter could be opened on every thread counted. */
+		std::size_t Threads = 0; /**< Threads or tasks that contributed counts. */
+	};
+
+	/**
+	\class HwCounters
+	Counts cycles, instructions, cache misses, branch misses and page faults per phase of a run with
+	perf_event_open on Linux. Every thread opens its own counters on first use; the calling thread
+	of a phase and HwScope instances on worker threads add the counts of their thread to the current
+	phase. While not enabled, phases and scopes only test a flag.
+	*/
+	class HwCounters {
+	public:
+		static bool Enable(std::string &error);
+		static bool IsEnabled();
+
+		static void BeginPhase(const std::string &phase);
+		static void EndPhase(std::ostream &out);
+
+		static std::string CurrentPhase();
+		static void Add(const std::string &phase, const HwCounterValues &counts);
+		static bool Get(const std::string &phase, HwCounterValues &counts);
+		static void Write(const HwCounterValues &counts, std::ostream &out);
+	};
+
+	/**
+	\class HwScope
+	Adds the events of the calling thread during its lifetime to the phase current at its creation.
+	Used on worker threads, the thread beginning a phase is counted by the phase itself.
+	*/
+	class HwScope {
+		std::string phase;
+		HwCounterValues start;
+		bool active = false;
+
+	public:
+		HwScope();
+		~HwScope();
+
+		HwScope(const HwScope&) = delete;
+		HwScope& operator=(const HwScope&) = delete;
+	};
+}
+
+#endif // HWCOUNTERS_H
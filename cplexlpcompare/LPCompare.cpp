@@ -0,0 +1,331 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#include "LPCompare.h"
+
+#include <iterator>
+#include <boost/function_output_iterator.hpp>
+
+/**
+\file LPCompare.cpp
+Implements the in-process comparison API of liblpcompare.
+*/
+
+namespace lpcompare {
+
+	/**
+	Writes the elements of a sorted section that are not in a second sorted section.
+
+	\param first Section of the first model.
+	\param second Section of the second model.
+	\param out Output iterator to write the elements only in the first section to.
+	*/
+	template <typename T, typename Out>
+	static void section_difference(const std::vector<T> &first, const std::vector<T> &second, Out out) {
+		std::set_difference(first.begin(), first.end(), second.begin(), second.end(), out);
+	}
+
+	/**
+	Writes the constraints of a sorted section that are not in a second sorted section. Of equivalent
+	constraints, those whose names are not in the other section are written, which keeps a patch from
+	removing a row by the name of an equivalent row that the second model keeps.
+
+	\param first Section of the first model.
+	\param second Section of the second model.
+	\param out Output iterator to write the constraints only in the first section to.
+	*/
+	template <typename Out>
+	static void section_difference(const std::vector<Constraint> &first, const std::vector<Constraint> &second, Out out) {
+		auto name = [](const Constraint &cons) -> const std::string& { return cons.Name; };
+		SetDifferenceByName(first.begin(), first.end(), second.begin(), second.end(), out, name, name);
+	}
+
+	/**
+	Compares a section of two models. Both sections are sorted first.
+
+	\param first Section of the first model.
+	\param second Section of the second model.
+	\param collect Keep differing elements, otherwise only count them.
+	\return Differences between the two sections.
+	*/
+	template <typename T>
+	SectionDiff<T> CompareSection(std::vector<T> &first, std::vector<T> &second, bool collect) {
+
+		SectionDiff<T> diff;
+		diff.Compared = true;
+		diff.FirstCount = first.size();
+		diff.SecondCount = second.size();
+
+		SortSection(first);
+		SortSection(second);
+
+		TraceSpan span("set difference", "diff");
+		span.SetCount("elements", first.size() + second.size());
+
+		if (collect) {
+			section_difference(first, second, std::back_inserter(diff.FirstExceptSecond));
+			section_difference(second, first, std::back_inserter(diff.SecondExceptFirst));
+
+			diff.FirstExceptSecondCount = diff.FirstExceptSecond.size();
+			diff.SecondExceptFirstCount = diff.SecondExceptFirst.size();
+		}
+		else {
+			auto &count1e2 = diff.FirstExceptSecondCount;
+			auto &count2e1 = diff.SecondExceptFirstCount;
+
+			section_difference(first, second,
+				boost::make_function_output_iterator([&count1e2](const T&) { count1e2++; }));
+			section_difference(second, first,
+				boost::make_function_output_iterator([&count2e1](const T&) { count2e1++; }));
+		}
+
+		return diff;
+	}
+
+	/**
+	Compares a section of two models, passing differing elements to a sink. Both sections are sorted first.
+
+	\param first Section of the first model.
+	\param second Section of the second model.
+	\param sink Sink to receive differing elements.
+	\return Counts of differences between the two sections, no elements are collected.
+	*/
+	template <typename T>
+	SectionDiff<T> CompareSection(std::vector<T> &first, std::vector<T> &second, DiffSink<T> &sink) {
+
+		SectionDiff<T> diff;
+		diff.Compared = true;
+		diff.FirstCount = first.size();
+		diff.SecondCount = second.size();
+
+		SortSection(first);
+		SortSection(second);
+
+		TraceSpan span("set difference", "diff");
+		span.SetCount("elements", first.size() + second.size());
+
+		auto &count1e2 = diff.FirstExceptSecondCount;
+		auto &count2e1 = diff.SecondExceptFirstCount;
+
+		section_difference(first, second,
+			boost::make_function_output_iterator([&count1e2, &sink](const T &element) { count1e2++; sink.FirstExceptSecond(element); }));
+		section_difference(second, first,
+			boost::make_function_output_iterator([&count2e1, &sink](const T &element) { count2e1++; sink.SecondExceptFirst(element); }));
+
+		return diff;
+	}
+
+	/**
+	Compares a section of two models, collecting a limited number of differing elements per side.
+	Both sections are sorted first, collected elements are sorted as well.
+
+	\param first Section of the first model.
+	\param second Section of the second model.
+	\param limit Number of elements to collect per side and how to choose them, MaxDiffs of 0 collects all.
+	\return Differences between the two sections.
+	*/
+	template <typename T>
+	SectionDiff<T> CompareSection(std::vector<T> &first, std::vector<T> &second, const DiffLimit &limit) {
+
+		if (limit.MaxDiffs == 0)
+			return CompareSection(first, second, true);
+
+		SectionDiff<T> collected;
+		LimitedCollector<T> collector(collected, limit);
+
+		auto diff = CompareSection(first, second, collector);
+		diff.FirstExceptSecond.swap(collected.FirstExceptSecond);
+		diff.SecondExceptFirst.swap(collected.SecondExceptFirst);
+
+		SortSection(diff.FirstExceptSecond);
+		SortSection(diff.SecondExceptFirst);
+
+		return diff;
+	}
+
+	/**
+	Compares two models section by section. Sections of both models are sorted in place.
+
+	\param first First model.
+	\param second Second model.
+	\param options Sections to compare and whether to keep differing elements.
+	\return Differences between the two models.
+	*/
+	CompareResult Compare(LPModel &first, LPModel &second, const CompareOptions &options) {
+
+		CompareResult result;
+
+		if (options.CompareGenerals)
+			result.Generals = options.CollectDiffs
+				? CompareSection(first.Generals, second.Generals, options.Limit)
+				: CompareSection(first.Generals, second.Generals, false);
+
+		if (options.CompareBinaries)
+			result.Binaries = options.CollectDiffs
+				? CompareSection(first.Binaries, second.Binaries, options.Limit)
+				: CompareSection(first.Binaries, second.Binaries, false);
+
+		if (options.CompareSosVars)
+			result.SosVars = options.CollectDiffs
+				? CompareSection(first.SosVars, second.SosVars, options.Limit)
+				: CompareSection(first.SosVars, second.SosVars, false);
+
+		if (options.CompareBounds)
+			result.Bounds = options.CollectDiffs
+				? CompareSection(first.Bounds, second.Bounds, options.Limit)
+				: CompareSection(first.Bounds, second.Bounds, false);
+
+		if (options.CompareConstraints)
+			result.Constraints = options.CollectDiffs
+				? CompareSection(first.Constraints, second.Constraints, options.Limit)
+				: CompareSection(first.Constraints, second.Constraints, false);
+
+		return result;
+	}
+
+	/**
+	Writes count of a given detail for both models, including differences.
+
+	\param detail_name Given name of the detail.
+	\param diff Differences of the detail.
+	\param out Stream to write counts to.
+	*/
+	template <typename T>
+	void WriteSectionCounts(const std::string &detail_name, const SectionDiff<T> &diff, std::ostream &out) {
+
+		out << detail_name << " First Model: " << diff.FirstCount << std::endl;
+		out << detail_name << " Second Model: " << diff.SecondCount << std::endl;
+
+		if (diff.AreEquivalent()) {
+			out << detail_name << " are equivalent." << std::endl;
+		}
+		else {
+			out << detail_name << " First except Second: " << diff.FirstExceptSecondCount << std::endl;
+			out << detail_name << " Second except First: " << diff.SecondExceptFirstCount << std::endl;
+		}
+	}
+
+	/**
+	Creates a filename to dump differences into.
+
+	\param prefix Filename prefix.
+	\param model Model name.
+	\param detail Model detail.
+	\param extension Filename extension including the leading dot.
+	\return dump filename.
+	*/
+	std::string GetDumpFilename(const std::string &prefix, const std::string &model, const std::string &detail, const std::string &extension) {
+		return prefix + "-" + model + "-" + detail + extension;
+	}
+
+	/**
+	Writes a list of differing elements to a file.
+
+	\param model Model name, used in the header and the filename.
+	\param detail_name Given name of the detail.
+	\param items Elements to write.
+	\param total Number of differing elements, more than written when collection was limited.
+	\param prefix Filename prefix.
+	\param log Stream to report written files to.
+	\param options Format and compression of the dump.
+	\return false if the file cannot be written.
+	*/
+	template <typename T>
+	bool dump_items(const std::string &model, const std::string &detail_name, const std::vector<T> &items, std::size_t total,
+		const std::string &prefix, std::ostream &log, const DumpOptions &options) {
+
+		TraceSpan span("write dump", "dump");
+		span.SetCount("elements", items.size());
+
+		auto filename = GetDumpFilename(prefix, model, detail_name, options.Extension());
+		DiffWriter writer;
+
+		if (!writer.Open(filename, options, model, detail_name)) {
+			log << "Cannot open or create file for writing: " << filename << std::endl;
+			return false;
+		}
+
+		for (const auto &item : items) {
+			writer.Write(item);
+		}
+
+		if (!writer.Close()) {
+			log << "Cannot write file: " << filename << std::endl;
+			return false;
+		}
+
+		log << model << " diff written for " << detail_name << " to " << filename;
+		if (items.size() < total)
+			log << " (" << items.size() << " of " << total << ")";
+		log << std::endl;
+
+		return true;
+	}
+
+	/**
+	Dumps collected differences of a section to files.
+
+	\param detail_name Given name of the detail.
+	\param diff Differences of the section.
+	\param prefix Filename prefix for the dumps.
+	\param log Stream to report written files to.
+	\param options Format and compression of the dumps.
+	\return false if a dump file cannot be written.
+	*/
+	template <typename T>
+	bool DumpSectionDiff(const std::string &detail_name, const SectionDiff<T> &diff, const std::string &prefix,
+		std::ostream &log, const DumpOptions &options) {
+
+		if (diff.FirstExceptSecond.size() > 0
+			&& !dump_items("firstEXCEPTsecond", detail_name, diff.FirstExceptSecond, diff.FirstExceptSecondCount, prefix, log, options))
+			return false;
+
+		if (diff.SecondExceptFirst.size() > 0
+			&& !dump_items("secondEXCEPTfirst", detail_name, diff.SecondExceptFirst, diff.SecondExceptFirstCount, prefix, log, options))
+			return false;
+
+		return true;
+	}
+
+	template SectionDiff<std::string> CompareSection(std::vector<std::string>&, std::vector<std::string>&, bool);
+	template SectionDiff<Bound> CompareSection(std::vector<Bound>&, std::vector<Bound>&, bool);
+	template SectionDiff<Constraint> CompareSection(std::vector<Constraint>&, std::vector<Constraint>&, bool);
+
+	template SectionDiff<std::string> CompareSection(std::vector<std::string>&, std::vector<std::string>&, DiffSink<std::string>&);
+	template SectionDiff<Bound> CompareSection(std::vector<Bound>&, std::vector<Bound>&, DiffSink<Bound>&);
+	template SectionDiff<Constraint> CompareSection(std::vector<Constraint>&, std::vector<Constraint>&, DiffSink<Constraint>&);
+
+	template SectionDiff<std::string> CompareSection(std::vector<std::string>&, std::vector<std::string>&, const DiffLimit&);
+	template SectionDiff<Bound> CompareSection(std::vector<Bound>&, std::vector<Bound>&, const DiffLimit&);
+	template SectionDiff<Constraint> CompareSection(std::vector<Constraint>&, std::vector<Constraint>&, const DiffLimit&);
+
+	template void WriteSectionCounts(const std::string&, const SectionDiff<std::string>&, std::ostream&);
+	template void WriteSectionCounts(const std::string&, const SectionDiff<Bound>&, std::ostream&);
+	template void WriteSectionCounts(const std::string&, const SectionDiff<Constraint>&, std::ostream&);
+
+	template bool DumpSectionDiff(const std::string&, const SectionDiff<std::string>&, const std::string&, std::ostream&, const DumpOptions&);
+	template bool DumpSectionDiff(const std::string&, const SectionDiff<Bound>&, const std::string&, std::ostream&, const DumpOptions&);
+	template bool DumpSectionDiff(const std::string&, const SectionDiff<Constraint>&, const std::string&, std::ostream&, const DumpOptions&);
+}
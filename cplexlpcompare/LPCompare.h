@@ -0,0 +1,287 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef LPCOMPARE_H
+#define LPCOMPARE_H
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "DiffWriter.h"
+#include "LPModel.h"
+#include "Trace.h"
+
+/**
+\file LPCompare.h
+Declares the in-process comparison API of liblpcompare.
+*/
+
+namespace lpcompare {
+
+	/**
+	\class DiffLimit
+	Bounds the number of differing elements collected per side of a section. Differences are
+	still counted in full.
+	*/
+	struct DiffLimit {
+		std::size_t MaxDiffs = 0; /**< Elements collected per side of a section, 0 for all. */
+		bool Sample = false; /**< Collect a uniform random sample of MaxDiffs elements instead of the first ones. */
+	};
+
+	/**
+	\class CompareOptions
+	Selects the sections of two models to compare and whether differing entities are kept.
+	*/
+	struct CompareOptions {
+		bool CompareGenerals = true;
+		bool CompareBinaries = true;
+		bool CompareSosVars = true;
+		bool CompareBounds = true;
+		bool CompareConstraints = true;
+		bool CollectDiffs = true; /**< Keep differing entities, otherwise only count them. */
+		DiffLimit Limit; /**< Bounds the differing entities kept. */
+	};
+
+	/**
+	\class SectionDiff
+	Result of comparing a single section of two models.
+	*/
+	template <typename T>
+	struct SectionDiff {
+		bool Compared = false; /**< false if the section was skipped. */
+		std::size_t FirstCount = 0; /**< Number of elements in the first model. */
+		std::size_t SecondCount = 0; /**< Number of elements in the second model. */
+		std::size_t FirstExceptSecondCount = 0;
+		std::size_t SecondExceptFirstCount = 0;
+		std::vector<T> FirstExceptSecond; /**< Elements only in the first model, if collected. */
+		std::vector<T> SecondExceptFirst; /**< Elements only in the second model, if collected. */
+
+		bool AreEquivalent() const {
+			return FirstExceptSecondCount == 0 && SecondExceptFirstCount == 0;
+		}
+
+		/**
+		Checks whether fewer elements were collected than counted.
+		*/
+		bool IsTruncated() const {
+			return FirstExceptSecond.size() < FirstExceptSecondCount || SecondExceptFirst.size() < SecondExceptFirstCount;
+		}
+
+		/**
+		Frees collected elements, keeping the counts.
+		*/
+		void ReleaseItems() {
+			std::vector<T>().swap(FirstExceptSecond);
+			std::vector<T>().swap(SecondExceptFirst);
+		}
+	};
+
+	/**
+	\class CompareResult
+	Structured result of comparing two models, one SectionDiff per section.
+	*/
+	struct CompareResult {
+		SectionDiff<std::string> Generals;
+		SectionDiff<std::string> Binaries;
+		SectionDiff<std::string> SosVars;
+		SectionDiff<Bound> Bounds;
+		SectionDiff<Constraint> Constraints;
+
+		bool AreEquivalent() const {
+			return Generals.AreEquivalent()
+				&& Binaries.AreEquivalent()
+				&& SosVars.AreEquivalent()
+				&& Bounds.AreEquivalent()
+				&& Constraints.AreEquivalent();
+		}
+
+		void ReleaseItems() {
+			Generals.ReleaseItems();
+			Binaries.ReleaseItems();
+			SosVars.ReleaseItems();
+			Bounds.ReleaseItems();
+			Constraints.ReleaseItems();
+		}
+	};
+
+	/**
+	\class DiffSink
+	Receives differing elements of a section as they stream out of a comparison, instead of
+	collecting them. All elements only in the first model are passed before those only in the second.
+	*/
+	template <typename T>
+	class DiffSink {
+	public:
+		virtual ~DiffSink() {}
+
+		virtual void FirstExceptSecond(const T &element) = 0;
+		virtual void SecondExceptFirst(const T &element) = 0;
+	};
+
+	/**
+	\class LimitedCollector
+	Collects at most a given number of elements per side of a section, either the first ones or a
+	uniform sample kept by reservoir sampling, or all of them with a MaxDiffs of 0. The sample is
+	seeded, so runs are repeatable.
+	*/
+	template <typename T>
+	class LimitedCollector : public DiffSink<T> {
+
+		SectionDiff<T> &diff;
+		DiffLimit limit;
+		std::mt19937_64 random;
+		std::size_t firstSeen = 0;
+		std::size_t secondSeen = 0;
+
+		void Add(std::vector<T> &items, std::size_t &seen, const T &element) {
+			seen++;
+
+			if (limit.MaxDiffs == 0 || items.size() < limit.MaxDiffs) {
+				items.push_back(element);
+				return;
+			}
+
+			if (!limit.Sample)
+				return;
+
+			auto slot = std::uniform_int_distribution<std::size_t>(0, seen - 1)(random);
+			if (slot < limit.MaxDiffs)
+				items[slot] = element;
+		}
+
+	public:
+
+		LimitedCollector(SectionDiff<T> &diff, const DiffLimit &limit)
+			: diff(diff), limit(limit), random(0x6c70636f6d70ULL) {}
+
+		void FirstExceptSecond(const T &element) override { Add(diff.FirstExceptSecond, firstSeen, element); }
+		void SecondExceptFirst(const T &element) override { Add(diff.SecondExceptFirst, secondSeen, element); }
+	};
+
+	/**
+	Sorts a section unless it is already sorted. Sorted sections are only read,
+	so they can be compared from several threads at once.
+
+	\param vec Section to sort.
+	*/
+	template <typename T>
+	void SortSection(std::vector<T> &vec) {
+		TraceSpan span("sort", "diff");
+		span.SetCount("elements", vec.size());
+
+		if (!std::is_sorted(vec.begin(), vec.end()))
+			std::sort(vec.begin(), vec.end());
+	}
+
+	/**
+	Writes the elements of a sorted range that are not in a second sorted range, like std::set_difference.
+	Equivalent elements are not told apart by the comparison, so of a run of equivalent elements, those
+	whose names are not in the matching run of the second range are written. A row kept under its name in
+	both models is then never reported as removed in favour of a duplicate of it.
+
+	\param first1 Begin of the first range.
+	\param last1 End of the first range.
+	\param first2 Begin of the second range.
+	\param last2 End of the second range.
+	\param out Output iterator to write the elements only in the first range to.
+	\param name1 Function returning the name of an element of the first range.
+	\param name2 Function returning the name of an element of the second range.
+	\return End of the written elements.
+	*/
+	template <typename It1, typename It2, typename Out, typename Name1, typename Name2>
+	Out SetDifferenceByName(It1 first1, It1 last1, It2 first2, It2 last2, Out out, Name1 name1, Name2 name2) {
+
+		while (first1 != last1) {
+			if (first2 == last2 || *first1 < *first2) {
+				*out++ = *first1++;
+				continue;
+			}
+
+			if (*first2 < *first1) {
+				++first2;
+				continue;
+			}
+
+			auto end1 = std::next(first1);
+			while (end1 != last1 && !(*first1 < *end1))
+				++end1;
+
+			auto end2 = std::next(first2);
+			while (end2 != last2 && !(*first2 < *end2))
+				++end2;
+
+			auto excess = std::distance(first1, end1) - std::distance(first2, end2);
+
+			if (excess > 0) {
+				std::unordered_multiset<std::string> names;
+				for (auto it = first2; it != end2; ++it)
+					names.insert(name2(*it));
+
+				for (auto it = first1; it != end1 && excess > 0; ++it) {
+					auto name = names.find(name1(*it));
+					if (name != names.end()) {
+						names.erase(name);
+					}
+					else {
+						*out++ = *it;
+						excess--;
+					}
+				}
+			}
+
+			first1 = end1;
+			first2 = end2;
+		}
+
+		return out;
+	}
+
+	template <typename T>
+	SectionDiff<T> CompareSection(std::vector<T> &first, std::vector<T> &second, bool collect = true);
+
+	template <typename T>
+	SectionDiff<T> CompareSection(std::vector<T> &first, std::vector<T> &second, DiffSink<T> &sink);
+
+	template <typename T>
+	SectionDiff<T> CompareSection(std::vector<T> &first, std::vector<T> &second, const DiffLimit &limit);
+
+	CompareResult Compare(LPModel &first, LPModel &second, const CompareOptions &options = CompareOptions());
+
+	template <typename T>
+	void WriteSectionCounts(const std::string &detail_name, const SectionDiff<T> &diff, std::ostream &out);
+
+	std::string GetDumpFilename(const std::string &prefix, const std::string &model, const std::string &detail, const std::string &extension = ".log");
+
+	template <typename T>
+	bool DumpSectionDiff(const std::string &detail_name, const SectionDiff<T> &diff, const std::string &prefix,
+		std::ostream &log = std::cout, const DumpOptions &options = DumpOptions());
+}
+
+#endif // LPCOMPARE_H
@@ -35,10 +35,15 @@
 #include <boost/iostreams/stream.hpp>
 #include <boost/iostreams/stream_buffer.hpp>
 #include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/iostreams/device/array.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
 
 #include "Split.h"
+#include "LPCompare.h"
+#include "MpsReader.h"
+#include "PipelinedReader.h"
+#include "Trace.h"
 
 /**
 \file LPModel.cpp
@@ -52,6 +57,99 @@ using namespace boost::algorithm;
 
 namespace lpcompare {
 
+	/**
+	Finds the section started by a line of an LP file.
+
+	\param line Trimmed line.
+	\return Section started by the line, LPSection::None if the line is not a known section keyword.
+	*/
+	LPSection LPModel::FindSection(const std::string &line) {
+
+		if (boost::iequals(line, "Generals")
+			|| boost::iequals(line, "General")
+			|| boost::iequals(line, "Gen"))
+			return LPSection::Generals;
+
+		if (boost::iequals(line, "Bounds")
+			|| boost::iequals(line, "Bound"))
+			return LPSection::Bounds;
+
+		if (boost::iequals(line, "Binaries")
+			|| boost::iequals(line, "Binary")
+			|| boost::iequals(line, "Bin"))
+			return LPSection::Binaries;
+
+		if (boost::iequals(line, "SOS"))
+			return LPSection::SosVars;
+
+		if (boost::iequals(line, "Subject To")
+			|| boost::iequals(line, "such that")
+			|| boost::iequals(line, "st")
+			|| boost::iequals(line, "S.T.")
+			|| boost::iequals(line, "ST."))
+			return LPSection::Constraints;
+
+		return LPSection::None;
+	}
+
+	/**
+	Splits a line of a Generals, Binaries or SOS section into variable names.
+
+	\param line Line of the section.
+	\param names Vector to append the names to.
+	*/
+	void LPModel::SplitNames(const std::string &line, std::vector<std::string> &names) {
+		::split(line, ' ', names, [](const std::string& s) { return s.length() > 0 && s[0] != '\r' && s[0] != '\n'; });
+	}
+
+	/**
+	Reads the objective section of an LP file as text, from its Minimize or Maximize line up to the
+	next section. Comment lines are left out.
+
+	\param filename Path of the LP file.
+	\param objective Set to the lines of the objective section, empty if the file has none.
+	\return false if the file cannot be read.
+	*/
+	bool LPModel::ReadObjective(const std::string &filename, std::string &objective) {
+
+		ifstream file(filename);
+
+		if (!file) {
+			cout << "Cannot open file: " << filename << std::endl;
+			return false;
+		}
+
+		objective.clear();
+
+		std::string line;
+		bool inObjective = false;
+
+		while (getline(file, line)) {
+			trim_right(line);
+
+			auto trimmed = trim_left_copy(line);
+			if (trimmed.empty() || trimmed[0] == '\\')
+				continue;
+
+			if (!inObjective) {
+				auto keyword = trimmed.substr(0, trimmed.find(' '));
+				inObjective = iequals(keyword, "Minimize") || iequals(keyword, "Maximize")
+					|| iequals(keyword, "Minimum") || iequals(keyword, "Maximum")
+					|| iequals(keyword, "Min") || iequals(keyword, "Max");
+			}
+			else if (FindSection(trimmed) != LPSection::None || iequals(trimmed, "End")) {
+				break;
+			}
+
+			if (inObjective) {
+				objective += line;
+				objective += '\n';
+			}
+		}
+
+		return !file.bad();
+	}
+
 	/**
 	Parses an LP file to build an LPModel instance.
 
@@ -59,12 +157,44 @@ namespace lpcompare {
 	\return true model is read successfully.
 	*/
 	bool LPModel::ReadModel(std::string filename) {
+		return ReadModel(filename, *this);
+	}
+
+	/**
+	Parses an LP file, passing its elements to a sink instead of this instance. Files with the
+	.mps extension are read by an MpsReader.
+
+	\param filename Path of the LP or MPS file.
+	\param sink Sink to receive parsed elements.
+	\return true model is read successfully.
+	*/
+	bool LPModel::ReadModel(std::string filename, ModelSink &sink) {
 		
 		if (!boost::filesystem::exists(filename)) {
 			cout << "File not found: " << filename;
 			return false;
 		}
 
+		if (MpsReader::IsMpsFile(filename)) {
+			MpsReader reader(Canonical, ReportProgress);
+			return reader.Read(filename, sink);
+		}
+
+		if (ParsePool != nullptr) {
+			PipelinedReader reader(*ParsePool, Canonical, ReportProgress);
+			return reader.Read(filename, sink);
+		}
+
+		if (ParseThreads > 0) {
+			PipelinedReader reader(ParseThreads, Canonical, ReportProgress);
+			return reader.Read(filename, sink);
+		}
+
+		// an empty file cannot be mapped, it holds an empty model.
+		if (boost::filesystem::file_size(filename) == 0)
+			return true;
+
+		TraceSpan span("read file", "read");
 		boost::iostreams::stream<boost::iostreams::mapped_file_source> file(filename);
 
 		if (!file){
@@ -72,55 +202,94 @@ namespace lpcompare {
 			return false;
 		}
 
-		std::string *line = new std::string();
+		span.SetCount("bytes", boost::filesystem::file_size(filename));
+
+		return ReadModel(file, sink);
+	}
+
+	/**
+	Parses an LP model held in memory to build an LPModel instance.
+
+	\param data LP file contents.
+	\param length Length of data in bytes.
+	\return true model is read successfully.
+	*/
+	bool LPModel::ReadModel(const char *data, std::size_t length) {
+
+		boost::iostreams::stream<boost::iostreams::array_source> file(data, length);
+
+		if (!file){
+			cout << "Cannot open model buffer.";
+			return false;
+		}
+
+		return ReadModel(file);
+	}
+
+	/**
+	Parses an LP model from a stream to build an LPModel instance.
+
+	\param file istream to read data from.
+	\return true model is read successfully.
+	*/
+	bool LPModel::ReadModel(std::istream &file) {
+		return ReadModel(file, *this);
+	}
+
+	/**
+	Parses an LP model from a stream, passing its elements to a sink.
+
+	\param file istream to read data from.
+	\param sink Sink to receive parsed elements.
+	\return true model is read successfully.
+	*/
+	bool LPModel::ReadModel(std::istream &file, ModelSink &sink) {
+
+		std::string line;
 		bool reconsider;
 
-		getline(file, *line);
+		lineOffset = nextOffset = lineNumber = 0;
+		GetLine(file, line);
 		linesRead = 0;
 		while (!file.eof()){
 			reconsider = false;
 
 			IncLineCount();
 
-			if (line->length() == 0 || (line->length() > 0 && ((*line)[0] == ' ' || (*line)[0] == '\\'))) {
-				getline(file, *line);
+			if (line.length() == 0 || (line.length() > 0 && (line[0] == ' ' || line[0] == '\\'))) {
+				GetLine(file, line);
 				continue;
 			}
 
-			trim(*line);
+			trim(line);
 
-			if (boost::iequals(*line, "Generals")
-				|| boost::iequals(*line, "General")
-				|| boost::iequals(*line, "Gen")) {
-				line = ReadGenerals(file);
+			switch (FindSection(line)) {
+			case LPSection::Generals:
+				line = ReadGenerals(file, sink);
 				reconsider = true;
-			}
-			else if (boost::iequals(*line, "Bounds")
-				|| boost::iequals(*line, "Bound")) {
-				line = ReadBounds(file);
+				break;
+			case LPSection::Bounds:
+				line = ReadBounds(file, sink);
 				reconsider = true;
-			}
-			else if (boost::iequals(*line, "Binaries")
-				|| boost::iequals(*line, "Binary")
-				|| boost::iequals(*line, "Bin")) {
-				line = ReadBinaries(file);
+				break;
+			case LPSection::Binaries:
+				line = ReadBinaries(file, sink);
 				reconsider = true;
-			}
-			else if (boost::iequals(*line, "SOS")) {
-				line = ReadSosVars(file);
+				break;
+			case LPSection::SosVars:
+				line = ReadSosVars(file, sink);
 				reconsider = true;
-			}
-			else if (boost::iequals(*line, "Subject To")
-				|| boost::iequals(*line, "such that")
-				|| boost::iequals(*line, "st")
-				|| boost::iequals(*line, "S.T.")
-				|| boost::iequals(*line, "ST.")) {
-				line = ReadConstraints(file);
+				break;
+			case LPSection::Constraints:
+				line = ReadConstraints(file, sink);
 				reconsider = true;
+				break;
+			default:
+				break;
 			}
 
 			if (!reconsider) {
-				getline(file, *line);
+				GetLine(file, line);
 			}
 		}
 
@@ -131,39 +300,46 @@ namespace lpcompare {
 	Parses an LP file segment for variables.
 
 	\param file istream to read data from.
-	\param list List to add parsed variables to.
-	\param operation Operation to parse a line and add artifacts to the list.
+	\param sink Sink to add parsed variables to.
+	\param traceName Name of the trace span of the segment.
+	\param operation Operation to parse a line and add artifacts to the sink.
 	\return last line read.
 	*/
-	template<typename T, typename F>
-	std::string* LPModel::ReadVars(
+	template<typename F>
+	std::string LPModel::ReadVars(
 		std::istream &file,
-		std::vector<T>& list,
+		ModelSink &sink,
+		const char *traceName,
 		F operation)
 	{
-		std::string* line = new std::string();
+		TraceSpan span(traceName, "parse");
+		auto firstLine = linesRead;
+
+		std::string line;
 
-		getline(file, *line);
+		GetLine(file, line);
 		IncLineCount();
 
 		while (!file.eof()) {
 
-			if (line->length() > 0 && ((*line)[0] == '\\')) {
-				getline(file, *line);
+			if (line.length() > 0 && (line[0] == '\\')) {
+				GetLine(file, line);
 				IncLineCount();
 				continue;
 			}
 
-			if (line->length() > 0 && ((*line)[0] != ' ')) {
+			if (line.length() > 0 && (line[0] != ' ')) {
+				span.SetCount("lines", linesRead - firstLine);
 				return line;
 			}
 
-			operation(*line, list);
+			operation(line, sink);
 
-			getline(file, *line);
+			GetLine(file, line);
 			IncLineCount();
 		}
 
+		span.SetCount("lines", linesRead - firstLine);
 		return line;
 	}
 
@@ -171,12 +347,18 @@ namespace lpcompare {
 	Parses an LP file segment for Generals.
 
 	\param file istream to read data from.
+	\param sink Sink to add parsed variables to.
 	\return last line read.
 	*/
-	std::string* LPModel::ReadGenerals(std::istream &file) {
+	std::string LPModel::ReadGenerals(std::istream &file, ModelSink &sink) {
 
-		return ReadVars(file, Generals, [](const std::string& line, std::vector<std::string>& list) {
-			::split(line, ' ', list, [](const std::string& s) { return s.length() > 0 && s[0] != '\r' && s[0] != '\n'; });
+		std::vector<std::string> names;
+
+		return ReadVars(file, sink, "parse Generals", [&names](const std::string& line, ModelSink& sink) {
+			names.clear();
+			SplitNames(line, names);
+			for (auto &name : names)
+				sink.AddGeneral(std::move(name));
 		});
 	}
 
@@ -184,12 +366,18 @@ namespace lpcompare {
 	Parses an LP file segment for Binaries.
 
 	\param file istream to read data from.
+	\param sink Sink to add parsed variables to.
 	\return last line read.
 	*/
-	std::string* LPModel::ReadBinaries(std::istream &file) {
+	std::string LPModel::ReadBinaries(std::istream &file, ModelSink &sink) {
+
+		std::vector<std::string> names;
 
-		return ReadVars(file, Binaries, [](const std::string& line, std::vector<std::string>& list) {
-			::split(line, ' ', list, [](const std::string& s) { return s.length() > 0 && s[0] != '\r' && s[0] != '\n'; });
+		return ReadVars(file, sink, "parse Binaries", [&names](const std::string& line, ModelSink& sink) {
+			names.clear();
+			SplitNames(line, names);
+			for (auto &name : names)
+				sink.AddBinary(std::move(name));
 		});
 	}
 
@@ -197,12 +385,18 @@ namespace lpcompare {
 	Parses an LP file segment for SOS variables.
 
 	\param file istream to read data from.
+	\param sink Sink to add parsed variables to.
 	\return last line read.
 	*/
-	std::string* LPModel::ReadSosVars(std::istream &file) {
+	std::string LPModel::ReadSosVars(std::istream &file, ModelSink &sink) {
+
+		std::vector<std::string> names;
 
-		return ReadVars(file, SosVars, [](const std::string& line, std::vector<std::string>& list) {
-			::split(line, ' ', list, [](const std::string& s) { return s.length() > 0 && s[0] != '\r' && s[0] != '\n'; });
+		return ReadVars(file, sink, "parse SOS", [&names](const std::string& line, ModelSink& sink) {
+			names.clear();
+			SplitNames(line, names);
+			for (auto &name : names)
+				sink.AddSosVar(std::move(name));
 		});
 	}
 
@@ -210,18 +404,21 @@ namespace lpcompare {
 	Parses an LP file segment for bounds.
 
 	\param file istream to read data from.
+	\param sink Sink to add parsed bounds to.
 	\return last line read.
 	*/
-	std::string* LPModel::ReadBounds(std::istream &file) {
+	std::string LPModel::ReadBounds(std::istream &file, ModelSink &sink) {
 
-		return ReadVars(file, Bounds, [](const std::string& line, std::vector<Bound>& list) {
+		return ReadVars(file, sink, "parse Bounds", [this](const std::string& line, ModelSink& sink) {
 
 			if (line.length() > 0 && line[0] != '\r' && line[0] != '\n') {
 
 				auto b = Bound::Parse(line);
 
 				if (b != nullptr) {
-					list.push_back(*b);
+					b->Source = SourceLocation(lineOffset, lineNumber, line.length());
+					sink.AddBound(*b);
+					delete b;
 				}
 			}
 		});
@@ -231,44 +428,52 @@ namespace lpcompare {
 	Parses an LP file segment for constraints.
 
 	\param file istream to read data from.
+	\param sink Sink to add parsed constraints to.
 	\return last line read.
 	*/
-	std::string* LPModel::ReadConstraints(std::istream &file) {
+	std::string LPModel::ReadConstraints(std::istream &file, ModelSink &sink) {
 
-		std::string* line = new std::string();
+		TraceSpan span("parse Constraints", "parse");
+		auto firstLine = linesRead;
 
-		getline(file, *line);
+		std::string line;
+
+		GetLine(file, line);
 		IncLineCount();
 
 		std::vector<std::string> consraws;
 		consraws.reserve(10);
 
+		SourceLocation source; // location of the lines in consraws.
+
 		while (!file.eof()) {
 
-			if (line->length() > 0 && ((*line)[0] == '\\')) {
-				getline(file, *line);
+			if (line.length() > 0 && (line[0] == '\\')) {
+				GetLine(file, line);
 				IncLineCount();
 				continue;
 			}
 
-			if ((*line)[0] != ' ')
+			if (line[0] != ' ')
 				break;
 
-			if ((*line)[1] != ' ' && consraws.size() > 0) {
+			if (line[1] != ' ' && consraws.size() > 0) {
 
 				std::string rawcons;
 
 				rawcons = "";
 
-				for (auto cons : consraws) {
+				for (const auto &cons : consraws) {
 					rawcons += cons;
 					rawcons += " ";
 				}
 
-				auto b = Constraint::Parse(rawcons);
+				auto b = Constraint::Parse(rawcons, Canonical);
 
 				if (b != nullptr) {
-					Constraints.push_back(*b);
+					b->Source = source;
+					sink.AddConstraint(std::move(*b));
+					delete b;
 				}
 
 				consraws.clear();
@@ -276,9 +481,13 @@ namespace lpcompare {
 				consraws.reserve(10); // most of the time is lost while allocating and destructing consraws vector.
 			}
 
-			consraws.push_back(*line);
+			if (consraws.empty())
+				source = SourceLocation(lineOffset, lineNumber, 0);
+			source.Length = static_cast<std::uint32_t>(lineOffset + line.length() - source.Offset);
 
-			getline(file, *line);
+			consraws.push_back(line);
+
+			GetLine(file, line);
 			IncLineCount();
 		}
 
@@ -286,20 +495,66 @@ namespace lpcompare {
 
 			std::string rawcons;
 
-			for (auto cons : consraws) {
+			for (const auto &cons : consraws) {
 				rawcons += cons;
 				rawcons += " ";
 			}
 
-			auto b = Constraint::Parse(rawcons);
+			auto b = Constraint::Parse(rawcons, Canonical);
 
 			if (b != nullptr) {
-				Constraints.push_back(*b);
+				b->Source = source;
+				sink.AddConstraint(std::move(*b));
+				delete b;
 			}
 
 			consraws.clear();
 		}
 
+		span.SetCount("lines", linesRead - firstLine);
 		return line;
 	}
+
+	/**
+	Sorts all sections of the model so that they can be compared. Sections that are already
+	sorted are left untouched, hence a sorted model can be shared between threads.
+	*/
+	void LPModel::Sort() {
+		SortSection(Generals);
+		SortSection(Binaries);
+		SortSection(SosVars);
+		SortSection(Bounds);
+		SortSection(Constraints);
+	}
+
+	/**
+	Estimates heap memory held by the model, used to cap model caches.
+
+	\return approximate size of the model in bytes.
+	*/
+	std::size_t LPModel::EstimateMemory() const {
+
+		auto string_size = [](const std::string &s) {
+			return sizeof(std::string) + (s.capacity() > 15 ? s.capacity() : 0);
+		};
+
+		std::size_t size = sizeof(LPModel);
+
+		for (const auto *vars : { &Generals, &Binaries, &SosVars }) {
+			for (const auto &var : *vars)
+				size += string_size(var);
+		}
+
+		for (const auto &bound : Bounds)
+			size += sizeof(Bound) + string_size(bound.VarName) - sizeof(std::string);
+
+		for (const auto &cons : Constraints) {
+			size += sizeof(Constraint) + string_size(cons.Name) - sizeof(std::string);
+
+			for (const auto &term : cons.GetTerms())
+				size += sizeof(Term) + string_size(term.varName) - sizeof(std::string);
+		}
+
+		return size;
+	}
 }
\ No newline at end of file
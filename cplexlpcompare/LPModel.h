@@ -26,6 +26,7 @@
 #ifndef LPMODEL_H
 #define LPMODEL_H
 
+#include <cstdint>
 #include <vector>
 #include <fstream>
 #include <iostream>
@@ -38,42 +39,91 @@
 
 namespace lpcompare {
 
+	class ThreadPool;
+
 	/**
 	\class LPModel
 	Represents an LP model composed of a bounds, constraints and variables of different kinds.
 	*/
 
+	/**
+	Sections of an LP file that are read into an LPModel.
+	*/
+	enum class LPSection
+	{
+		None = 0,
+		Generals,
+		Binaries,
+		SosVars,
+		Bounds,
+		Constraints,
+	};
+
+	/**
+	\class ModelSink
+	Receives the elements of an LP file as they are parsed, so that a model can be processed
+	without holding it in memory.
+	*/
+	class ModelSink {
+	public:
+		virtual ~ModelSink() {}
+
+		virtual void AddGeneral(std::string name) = 0;
+		virtual void AddBinary(std::string name) = 0;
+		virtual void AddSosVar(std::string name) = 0;
+		virtual void AddBound(Bound bound) = 0;
+		virtual void AddConstraint(Constraint cons) = 0;
+	};
+
 	const char SEPS [] = { ' ' };  /**< Delimiter for bounds. */
 	const char SEPS_CONS [] = { ' ', '\t', '\n', '\r' };  /**< Delimiter for constraints. */
 
-	class LPModel {
+	class LPModel : public ModelSink {
 
-		template<typename T, typename F>
-		std::string* ReadVars(
+		template<typename F>
+		std::string ReadVars(
 			std::istream &file,
-			std::vector<T>& list,
+			ModelSink &sink,
+			const char *traceName,
 			F operation);
 
-		std::string* ReadGenerals(std::istream &file);
-		std::string* ReadBinaries(std::istream &file);
-		std::string* ReadSosVars(std::istream &file);
-		std::string* ReadBounds(std::istream &file);
-		std::string* ReadConstraints(std::istream &file);
+		std::string ReadGenerals(std::istream &file, ModelSink &sink);
+		std::string ReadBinaries(std::istream &file, ModelSink &sink);
+		std::string ReadSosVars(std::istream &file, ModelSink &sink);
+		std::string ReadBounds(std::istream &file, ModelSink &sink);
+		std::string ReadConstraints(std::istream &file, ModelSink &sink);
 
 		long linesRead = 0; /**< Counter for lines read. */
 
 		/**
-		Increases linesRead counter by one. Prints linesRead to std::cout every million lines.
+		Increases linesRead counter by one. Prints linesRead to std::cout every million lines
+		if progress reporting is enabled.
 		*/
 		void IncLineCount()
 		{
 			linesRead++;
 
-			if (linesRead % 1000000 == 0) {
+			if (ReportProgress && linesRead % 1000000 == 0) {
 				std::cout << "Lines read: " << linesRead << std::endl;
 			}
 		}
 
+		std::uint64_t lineOffset = 0; /**< Byte offset of the line read last. */
+		std::uint64_t nextOffset = 0; /**< Byte offset of the line after it. */
+		std::uint64_t lineNumber = 0; /**< Line number of the line read last, starting at 1. */
+
+		/**
+		Reads a line, keeping track of its byte offset and line number for the locations of
+		bounds and constraints.
+		*/
+		void GetLine(std::istream &file, std::string &line)
+		{
+			lineOffset = nextOffset;
+			std::getline(file, line);
+			nextOffset += line.length() + 1;
+			lineNumber++;
+		}
+
 	public:
 
 		std::vector<std::string> Generals;
@@ -82,6 +132,11 @@ namespace lpcompare {
 		std::vector<Bound> Bounds;
 		std::vector<Constraint> Constraints;
 
+		bool ReportProgress = true; /**< Print read progress to std::cout. */
+		bool Canonical = false; /**< Read constraints in their canonical form, see Constraint::Canonicalize. */
+		unsigned ParseThreads = 0; /**< Parser threads of a PipelinedReader for files, 0 to parse on the calling thread. */
+		ThreadPool *ParsePool = nullptr; /**< Pool of a PipelinedReader for files, used instead of ParseThreads. */
+
 		LPModel() {
 			Generals = std::vector<std::string>();
 			Binaries = std::vector<std::string>();
@@ -91,7 +146,26 @@ namespace lpcompare {
 		}
 		~LPModel() {}
 
+		static LPSection FindSection(const std::string &line);
+		static void SplitNames(const std::string &line, std::vector<std::string> &names);
+		static bool ReadObjective(const std::string &filename, std::string &objective);
+
 		bool ReadModel(std::string filename);
+		bool ReadModel(const char *data, std::size_t length);
+		bool ReadModel(std::istream &file);
+
+		bool ReadModel(std::string filename, ModelSink &sink);
+		bool ReadModel(std::istream &file, ModelSink &sink);
+
+		void AddGeneral(std::string name) override { Generals.push_back(std::move(name)); }
+		void AddBinary(std::string name) override { Binaries.push_back(std::move(name)); }
+		void AddSosVar(std::string name) override { SosVars.push_back(std::move(name)); }
+		void AddBound(Bound bound) override { Bounds.push_back(std::move(bound)); }
+		void AddConstraint(Constraint cons) override { Constraints.push_back(std::move(cons)); }
+
+		void Sort();
+
+		std::size_t EstimateMemory() const;
 	};
 }
 
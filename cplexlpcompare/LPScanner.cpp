@@ -0,0 +1,240 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#include "LPScanner.h"
+
+#include <cstring>
+#include <boost/algorithm/string.hpp>
+
+/**
+\file LPScanner.cpp
+Implements LPScanner class.
+*/
+
+namespace lpcompare {
+
+	/**
+	Creates a scanner over a buffer. Bytes after the last newline are ignored.
+
+	\param data LP file contents.
+	\param length Length of data in bytes.
+	*/
+	LPScanner::LPScanner(const char *data, std::size_t length) : position(data), end(data + length) {
+
+		while (end > data && end[-1] != '\n')
+			end--;
+	}
+
+	/**
+	Reads the next line.
+
+	\param line Receives the line, without its newline.
+	\return false at the end of the data.
+	*/
+	bool LPScanner::NextLine(RowRange &line) {
+
+		if (position == end)
+			return false;
+
+		auto newline = static_cast<const char*>(std::memchr(position, '\n', end - position));
+
+		line.Begin = position;
+		line.End = newline;
+		position = newline + 1;
+		linesRead++;
+		line.Line = linesRead;
+
+		return true;
+	}
+
+	/**
+	Finds the next element of the file.
+
+	\param rowSection Receives the section of the element.
+	\param row Receives the bytes of the element.
+	\return false if there are no more elements.
+	*/
+	bool LPScanner::Next(LPSection &rowSection, RowRange &row) {
+
+		RowRange line;
+
+		while (NextLine(line)) {
+
+			auto length = line.End - line.Begin;
+
+			switch (section) {
+			case LPSection::None: {
+				if (length == 0 || line.Begin[0] == ' ' || line.Begin[0] == '\\')
+					break;
+
+				std::string keyword(line.Begin, line.End);
+				boost::algorithm::trim(keyword);
+				section = LPModel::FindSection(keyword);
+				break;
+			}
+			case LPSection::Constraints:
+				if (length > 0 && line.Begin[0] == '\\')
+					break;
+
+				if (length == 0 || line.Begin[0] != ' ') {
+					// the line ends the section, it is read again outside of it.
+					position = line.Begin;
+					linesRead--;
+					section = LPSection::None;
+
+					if (pending.Begin != nullptr) {
+						rowSection = LPSection::Constraints;
+						row = pending;
+						pending.Begin = nullptr;
+						return true;
+					}
+					break;
+				}
+
+				if ((length < 2 || line.Begin[1] != ' ') && pending.Begin != nullptr) {
+					rowSection = LPSection::Constraints;
+					row = pending;
+					pending = line;
+					return true;
+				}
+
+				if (pending.Begin == nullptr) {
+					pending.Begin = line.Begin;
+					pending.Line = line.Line;
+				}
+				pending.End = line.End;
+				break;
+			default:
+				if (length > 0 && line.Begin[0] == '\\')
+					break;
+
+				if (length > 0 && line.Begin[0] != ' ') {
+					position = line.Begin;
+					linesRead--;
+					section = LPSection::None;
+					break;
+				}
+
+				if (length == 0)
+					break;
+
+				rowSection = section;
+				row = line;
+				return true;
+			}
+		}
+
+		if (pending.Begin != nullptr) {
+			rowSection = LPSection::Constraints;
+			row = pending;
+			pending.Begin = nullptr;
+			return true;
+		}
+
+		return false;
+	}
+
+	/**
+	Parses an element found by LPScanner as LPModel::ReadModel does.
+
+	\param section Section of the element.
+	\param row Bytes of the element.
+	\param sink Sink to receive the parsed variables, bound or constraint.
+	\param canonical Parse constraints in their canonical form.
+	\param buffer Buffer for the text of the element, reused between calls.
+	\param data Start of the file the row was scanned from, bounds and constraints get their
+	location in it. nullptr to leave their location unknown.
+	*/
+	void ParseRow(LPSection section, const RowRange &row, ModelSink &sink, bool canonical, std::string &buffer, const char *data) {
+
+		SourceLocation source;
+
+		if (data != nullptr)
+			source = SourceLocation(row.Begin - data, row.Line, row.End - row.Begin);
+
+		switch (section) {
+		case LPSection::Generals:
+		case LPSection::Binaries:
+		case LPSection::SosVars: {
+			std::vector<std::string> names;
+			buffer.assign(row.Begin, row.End);
+			LPModel::SplitNames(buffer, names);
+
+			for (auto &name : names) {
+				if (section == LPSection::Generals)
+					sink.AddGeneral(std::move(name));
+				else if (section == LPSection::Binaries)
+					sink.AddBinary(std::move(name));
+				else
+					sink.AddSosVar(std::move(name));
+			}
+			break;
+		}
+		case LPSection::Bounds: {
+			buffer.assign(row.Begin, row.End);
+
+			if (buffer.empty() || buffer[0] == '\r')
+				break;
+
+			auto b = Bound::Parse(buffer);
+
+			if (b != nullptr) {
+				b->Source = source;
+				sink.AddBound(*b);
+				delete b;
+			}
+			break;
+		}
+		case LPSection::Constraints: {
+			// lines are joined as LPModel::ReadConstraints does, skipping comments.
+			buffer.clear();
+
+			for (auto begin = row.Begin; begin <= row.End;) {
+				auto end = begin;
+				while (end < row.End && *end != '\n')
+					end++;
+
+				if (*begin != '\\') {
+					buffer.append(begin, end);
+					buffer += ' ';
+				}
+
+				begin = end + 1;
+			}
+
+			auto b = Constraint::Parse(buffer, canonical);
+
+			if (b != nullptr) {
+				b->Source = source;
+				sink.AddConstraint(std::move(*b));
+				delete b;
+			}
+			break;
+		}
+		default:
+			break;
+		}
+	}
+}
@@ -0,0 +1,83 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef LPSCANNER_H
+#define LPSCANNER_H
+
+#include <cstddef>
+#include <string>
+
+#include "LPModel.h"
+
+namespace lpcompare {
+
+	/**
+	\class RowRange
+	Bytes of one element of an LP file: a line of variable names, a bound, or the lines of a
+	constraint. Lines are separated by '\n', the last one excludes it.
+	*/
+	struct RowRange {
+		const char *Begin = nullptr;
+		const char *End = nullptr;
+		long Line = 0; /**< Line number of the first line, starting at 1, set by LPScanner. */
+	};
+
+	/**
+	\class LPScanner
+	Splits an LP file held in memory into the byte ranges of its elements without parsing them, so
+	that elements can be parsed elsewhere. Sections and comments are handled as by LPModel::ReadModel,
+	only lines terminated by a newline are read.
+	*/
+	class LPScanner {
+
+		const char *position;
+		const char *end;
+		LPSection section = LPSection::None;
+		RowRange pending; /**< Lines of the constraint read so far. */
+		long linesRead = 0;
+
+		bool NextLine(RowRange &line);
+
+	public:
+
+		LPScanner(const char *data, std::size_t length);
+
+		bool Next(LPSection &rowSection, RowRange &row);
+
+		/**
+		\return Number of lines scanned so far.
+		*/
+		long LinesRead() const { return linesRead; }
+
+		/**
+		\return Start of the next line to scan.
+		*/
+		const char *Position() const { return position; }
+	};
+
+	void ParseRow(LPSection section, const RowRange &row, ModelSink &sink, bool canonical, std::string &buffer, const char *data = nullptr);
+}
+
+#endif // LPSCANNER_H
@@ -0,0 +1,447 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#include "LazyReader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include "Hash.h"
+#include "HwCounters.h"
+#include "MpsReader.h"
+#include "Trace.h"
+
+/**
+\file LazyReader.cpp
+Implements LazyReader class.
+*/
+
+using std::cout;
+
+namespace lpcompare {
+
+	/**
+	Mapped LP file with its variables parsed and its bounds and constraints hashed.
+	*/
+	struct LazyIndex {
+		boost::iostreams::mapped_file_source File;
+		std::vector<RowHash> Bounds;
+		std::vector<RowHash> Constraints;
+	};
+
+	/**
+	Writes the text of a row with comment lines left out, whitespace runs replaced by a single
+	space and leading and trailing whitespace removed.
+
+	\param row Bytes of the row.
+	\param buffer Receives the normalized text.
+	*/
+	void LazyReader::NormalizeRow(const RowRange &row, std::string &buffer) {
+
+		buffer.clear();
+		bool space = false;
+		bool lineStart = true;
+		bool comment = false;
+
+		for (auto p = row.Begin; p < row.End; p++) {
+			auto c = *p;
+
+			if (c == '\n') {
+				lineStart = true;
+				comment = false;
+				space = true;
+				continue;
+			}
+
+			if (lineStart) {
+				lineStart = false;
+				comment = c == '\\';
+			}
+
+			if (comment)
+				continue;
+
+			if (c == ' ' || c == '\t' || c == '\r') {
+				space = true;
+				continue;
+			}
+
+			if (space && !buffer.empty())
+				buffer += ' ';
+			space = false;
+
+			buffer += c;
+		}
+	}
+
+	/**
+	Hashes the normalized text of a row.
+
+	\param row Bytes of the row.
+	\param buffer Buffer for the normalized text.
+	\return Hash of the normalized text.
+	*/
+	std::uint64_t LazyReader::HashRow(const RowRange &row, std::string &buffer) {
+		NormalizeRow(row, buffer);
+		return HashBytes(buffer.data(), buffer.size());
+	}
+
+	/**
+	Maps an LP file, parses its variable sections into a model and hashes its bounds and constraints.
+	MPS files are read into the model in full and leave the index empty, hence no rows are matched.
+
+	\param filename Path of the LP or MPS file.
+	\param index Receives the mapping and the hashes.
+	\param model Model to receive the variables.
+	\param canonical Read constraints of an MPS file in their canonical form.
+	\return false if the file cannot be read.
+	*/
+	static bool build_index(const std::string &filename, LazyIndex &index, LPModel &model, bool canonical) {
+
+		if (MpsReader::IsMpsFile(filename)) {
+			MpsReader reader(canonical, false);
+			return reader.Read(filename, model);
+		}
+
+		if (!boost::filesystem::exists(filename)) {
+			cout << "File not found: " << filename;
+			return false;
+		}
+
+		if (boost::filesystem::file_size(filename) == 0)
+			return true;
+
+		try {
+			index.File.open(filename);
+		}
+		catch (const std::exception &) {
+			cout << "Cannot open file: " << filename;
+			return false;
+		}
+
+		TraceSpan span("hash rows", "read");
+		span.SetCount("bytes", index.File.size());
+
+		LPScanner scanner(index.File.data(), index.File.size());
+		LPSection section;
+		RowRange row;
+		std::string buffer;
+
+		while (scanner.Next(section, row)) {
+
+			switch (section) {
+			case LPSection::Bounds:
+				index.Bounds.push_back({ LazyReader::HashRow(row, buffer), row });
+				break;
+			case LPSection::Constraints:
+				index.Constraints.push_back({ LazyReader::HashRow(row, buffer), row });
+				break;
+			default:
+				ParseRow(section, row, model, false, buffer, index.File.data());
+				break;
+			}
+		}
+
+		return true;
+	}
+
+	/**
+	Removes rows whose normalized text occurs in both lists, once per occurrence. Rows of equal hash
+	are compared by their text, so a hash collision is never taken for a match.
+
+	\param first Rows of the first model, left with its unmatched rows.
+	\param second Rows of the second model, left with its unmatched rows.
+	\param matched Receives the number of rows removed from each list.
+	*/
+	void LazyReader::MatchRows(std::vector<RowHash> &first, std::vector<RowHash> &second, std::size_t &matched) {
+
+		auto by_hash = [](const RowHash &a, const RowHash &b) { return a.Hash < b.Hash; };
+		std::sort(first.begin(), first.end(), by_hash);
+		std::sort(second.begin(), second.end(), by_hash);
+
+		std::vector<bool> firstMatched(first.size()), secondMatched(second.size());
+		std::string buffer1, buffer2;
+		matched = 0;
+
+		for (std::size_t i = 0, j = 0; i < first.size() && j < second.size();) {
+
+			if (first[i].Hash < second[j].Hash) {
+				i++;
+				continue;
+			}
+
+			if (second[j].Hash < first[i].Hash) {
+				j++;
+				continue;
+			}
+
+			NormalizeRow(first[i].Row, buffer1);
+			NormalizeRow(second[j].Row, buffer2);
+
+			if (buffer1 == buffer2) {
+				firstMatched[i] = true;
+				secondMatched[j] = true;
+				matched++;
+				j++;
+			}
+			i++;
+		}
+
+		auto keep_unmatched = [](std::vector<RowHash> &rows, const std::vector<bool> &rowMatched) {
+			std::size_t kept = 0;
+			for (std::size_t i = 0; i < rows.size(); i++) {
+				if (!rowMatched[i])
+					rows[kept++] = rows[i];
+			}
+			rows.resize(kept);
+		};
+
+		keep_unmatched(first, firstMatched);
+		keep_unmatched(second, secondMatched);
+	}
+
+	/**
+	Compares two rows of equal hash by their bytes, then by their normalized text.
+
+	\param first Row of the first model.
+	\param second Row of the second model.
+	\param buffer1 Reused buffer.
+	\param buffer2 Reused buffer.
+	\return true if the rows are textually equal.
+	*/
+	static bool rows_equal(const RowHash &first, const RowHash &second, std::string &buffer1, std::string &buffer2) {
+
+		if (first.Hash != second.Hash)
+			return false;
+
+		auto length = first.Row.End - first.Row.Begin;
+		if (length == second.Row.End - second.Row.Begin && std::memcmp(first.Row.Begin, second.Row.Begin, length) == 0)
+			return true;
+
+		LazyReader::NormalizeRow(first.Row, buffer1);
+		LazyReader::NormalizeRow(second.Row, buffer2);
+		return buffer1 == buffer2;
+	}
+
+	/**
+	Checks whether two files are byte-identical, comparing mapped slices so that a difference
+	early in large files is found without touching the rest.
+
+	\param firstFilename Path of the first file.
+	\param secondFilename Path of the second file.
+	\param identical Receives whether the files are byte-identical.
+	\return false if a file cannot be read.
+	*/
+	bool LazyReader::IdenticalFiles(const std::string &firstFilename, const std::string &secondFilename, bool &identical) {
+
+		const std::size_t slice = 1 << 20;
+		identical = false;
+
+		for (const auto &filename : { firstFilename, secondFilename }) {
+			if (!boost::filesystem::exists(filename)) {
+				cout << "File not found: " << filename;
+				return false;
+			}
+		}
+
+		auto size = boost::filesystem::file_size(firstFilename);
+		if (size != boost::filesystem::file_size(secondFilename))
+			return true;
+
+		if (size == 0) {
+			identical = true;
+			return true;
+		}
+
+		boost::iostreams::mapped_file_source first, second;
+
+		try {
+			first.open(firstFilename);
+			second.open(secondFilename);
+		}
+		catch (const std::exception &) {
+			cout << "Cannot open file: " << (first.is_open() ? secondFilename : firstFilename);
+			return false;
+		}
+
+		for (std::size_t at = 0; at < first.size(); at += slice) {
+			auto length = std::min(slice, first.size() - at);
+			if (std::memcmp(first.data() + at, second.data() + at, length) != 0)
+				return true;
+		}
+
+		identical = true;
+		return true;
+	}
+
+	/**
+	Removes rows that are textually equal in both lists, walking the lists in file order. Equal
+	rows at the same position are matched in one linear pass. Where the lists diverge, the walk
+	resynchronizes at the nearest pair of equal rows within the lookahead, searched in order of
+	increasing edit distance as in Myers' diff, and the rows skipped on either side are set aside.
+	If no such pair exists before the end of the lists, the walk stops. The rows set aside and the
+	remaining rows are then matched by hash as by MatchRows, which is cheap when few are left. The
+	lists are not aligned if the walk stopped early or more rows were matched by hash than in order.
+	Unmatched rows are parsed and compared, so alignment only decides how fast rows are left out.
+
+	\param first Rows of the first model in file order, left with its unmatched rows.
+	\param second Rows of the second model in file order, left with its unmatched rows.
+	\param lookahead Rows searched ahead on each side at a divergence.
+	\param matched Receives the number of rows removed from each list.
+	\return false if the lists were not aligned.
+	*/
+	bool LazyReader::AlignRows(std::vector<RowHash> &first, std::vector<RowHash> &second, std::size_t lookahead, std::size_t &matched) {
+
+		std::vector<RowHash> firstLeft, secondLeft;
+		std::string buffer1, buffer2;
+		std::size_t i = 0, j = 0;
+		bool aligned = true;
+		matched = 0;
+
+		while (i < first.size() && j < second.size()) {
+
+			if (rows_equal(first[i], second[j], buffer1, buffer2)) {
+				matched++;
+				i++;
+				j++;
+				continue;
+			}
+
+			// resynchronize at the first equal pair with the fewest rows skipped.
+			bool found = false;
+			for (std::size_t distance = 1; distance <= 2 * lookahead && !found; distance++) {
+				for (std::size_t skip1 = distance > lookahead ? distance - lookahead : 0; skip1 <= std::min(distance, lookahead); skip1++) {
+					auto skip2 = distance - skip1;
+
+					if (i + skip1 >= first.size() || j + skip2 >= second.size())
+						continue;
+
+					if (rows_equal(first[i + skip1], second[j + skip2], buffer1, buffer2)) {
+						firstLeft.insert(firstLeft.end(), first.begin() + i, first.begin() + i + skip1);
+						secondLeft.insert(secondLeft.end(), second.begin() + j, second.begin() + j + skip2);
+						i += skip1;
+						j += skip2;
+						found = true;
+						break;
+					}
+				}
+			}
+
+			// a divergence at the end of both lists leaves their tails unmatched.
+			if (!found) {
+				aligned = first.size() - i <= lookahead && second.size() - j <= lookahead;
+				break;
+			}
+		}
+
+		firstLeft.insert(firstLeft.end(), first.begin() + i, first.end());
+		secondLeft.insert(secondLeft.end(), second.begin() + j, second.end());
+
+		std::size_t hashMatched;
+		MatchRows(firstLeft, secondLeft, hashMatched);
+
+		aligned = aligned && hashMatched <= matched;
+		matched += hashMatched;
+
+		first.swap(firstLeft);
+		second.swap(secondLeft);
+
+		return aligned;
+	}
+
+	/**
+	Reads two LP files, leaving out bounds and constraints that are textually equal in both.
+
+	\param firstFilename Path of the first LP file.
+	\param secondFilename Path of the second LP file.
+	\param first Receives the variables and the unmatched rows of the first file.
+	\param second Receives the variables and the unmatched rows of the second file.
+	\param match Receives the number of rows left out of each model.
+	\return false if a file cannot be read.
+	*/
+	bool LazyReader::Read(const std::string &firstFilename, const std::string &secondFilename,
+		LPModel &first, LPModel &second, LazyMatch &match) {
+
+		if (Aligned) {
+			TraceSpan span("compare bytes", "read");
+
+			if (!IdenticalFiles(firstFilename, secondFilename, match.Identical))
+				return false;
+			if (match.Identical)
+				return true;
+		}
+
+		LazyIndex firstIndex, secondIndex;
+		bool firstRead = false;
+
+		std::thread firstReader([&]() {
+			HwScope counters;
+			firstRead = build_index(firstFilename, firstIndex, first, Canonical);
+		});
+
+		bool secondRead = build_index(secondFilename, secondIndex, second, Canonical);
+
+		firstReader.join();
+
+		if (!firstRead || !secondRead)
+			return false;
+
+		{
+			TraceSpan span("match rows", "read");
+			span.SetCount("rows", firstIndex.Bounds.size() + firstIndex.Constraints.size()
+				+ secondIndex.Bounds.size() + secondIndex.Constraints.size());
+
+			if (Aligned) {
+				match.BoundsAligned = AlignRows(firstIndex.Bounds, secondIndex.Bounds, Lookahead, match.Bounds);
+				match.ConstraintsAligned = AlignRows(firstIndex.Constraints, secondIndex.Constraints, Lookahead, match.Constraints);
+			}
+			else {
+				MatchRows(firstIndex.Bounds, secondIndex.Bounds, match.Bounds);
+				MatchRows(firstIndex.Constraints, secondIndex.Constraints, match.Constraints);
+			}
+		}
+
+		TraceSpan span("parse unmatched rows", "parse");
+		span.SetCount("rows", firstIndex.Bounds.size() + firstIndex.Constraints.size()
+			+ secondIndex.Bounds.size() + secondIndex.Constraints.size());
+
+		std::string buffer;
+
+		for (const auto &row : firstIndex.Bounds)
+			ParseRow(LPSection::Bounds, row.Row, first, Canonical, buffer, firstIndex.File.data());
+		for (const auto &row : firstIndex.Constraints)
+			ParseRow(LPSection::Constraints, row.Row, first, Canonical, buffer, firstIndex.File.data());
+		for (const auto &row : secondIndex.Bounds)
+			ParseRow(LPSection::Bounds, row.Row, second, Canonical, buffer, secondIndex.File.data());
+		for (const auto &row : secondIndex.Constraints)
+			ParseRow(LPSection::Constraints, row.Row, second, Canonical, buffer, secondIndex.File.data());
+
+		return true;
+	}
+}
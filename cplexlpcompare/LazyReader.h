@@ -0,0 +1,94 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef LAZYREADER_H
+#define LAZYREADER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "LPModel.h"
+#include "LPScanner.h"
+
+namespace lpcompare {
+
+	/**
+	\class RowHash
+	Hash of the whitespace-normalized text of a bound or constraint and its bytes in the file.
+	*/
+	struct RowHash {
+		std::uint64_t Hash;
+		RowRange Row;
+	};
+
+	/**
+	\class LazyMatch
+	Number of bounds and constraints that are textually equal in both models and were not parsed.
+	*/
+	struct LazyMatch {
+		std::size_t Bounds = 0;
+		std::size_t Constraints = 0;
+		bool Identical = false; /**< The files are byte-identical and nothing was read, only with LazyReader::Aligned. */
+		bool BoundsAligned = false; /**< Bounds were matched in file order, only with LazyReader::Aligned. */
+		bool ConstraintsAligned = false; /**< Constraints were matched in file order, only with LazyReader::Aligned. */
+	};
+
+	/**
+	\class LazyReader
+	Reads two LP files for a comparison while parsing as little as possible. Both files are mapped
+	and scanned, bounds and constraints are only hashed by their text with whitespace runs collapsed.
+	Rows whose text occurs in both files are equal and left out, only the remaining rows are parsed
+	into the models. Variable sections are parsed in full.
+
+	Differences between the models are the same as between the fully read models, element counts
+	are the sizes of the models plus the LazyMatch counts.
+
+	Aligned reads suit models written in a stable order. Byte-identical files are not read at all,
+	otherwise rows are matched walking both files in lockstep, see AlignRows, and the rows skipped
+	by the walk are matched by hash.
+	*/
+	class LazyReader {
+
+		static void MatchRows(std::vector<RowHash> &first, std::vector<RowHash> &second, std::size_t &matched);
+
+	public:
+
+		bool Canonical = false; /**< Parse remaining constraints in their canonical form. */
+		bool Aligned = false; /**< Match rows in file order, see AlignRows. */
+		std::size_t Lookahead = 1024; /**< Rows searched ahead on each side to resynchronize an aligned walk. */
+
+		static void NormalizeRow(const RowRange &row, std::string &buffer);
+		static std::uint64_t HashRow(const RowRange &row, std::string &buffer);
+		static bool IdenticalFiles(const std::string &firstFilename, const std::string &secondFilename, bool &identical);
+		static bool AlignRows(std::vector<RowHash> &first, std::vector<RowHash> &second, std::size_t lookahead, std::size_t &matched);
+
+		bool Read(const std::string &firstFilename, const std::string &secondFilename,
+			LPModel &first, LPModel &second, LazyMatch &match);
+	};
+}
+
+#endif // LAZYREADER_H
@@ -0,0 +1,351 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#include "ManifestCompare.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+
+/**
+\file ManifestCompare.cpp
+Implements ManifestCompare class.
+*/
+
+namespace lpcompare {
+
+	const std::size_t PARALLEL_SORT_ELEMENTS = 65536; /**< Sections at least this large are sorted in parallel. */
+
+	/**
+	Sorts a section on a pool. Large sections are split into one chunk per worker, the chunks are
+	sorted by a ParallelFor and merged pairwise in rounds, each round again by a ParallelFor.
+
+	\param pool Thread pool, may be the pool of the calling task.
+	\param vec Section to sort.
+	*/
+	template <typename T>
+	static void sort_on_pool(ThreadPool &pool, std::vector<T> &vec) {
+
+		if (vec.size() < PARALLEL_SORT_ELEMENTS || pool.Size() < 2) {
+			SortSection(vec);
+			return;
+		}
+
+		TraceSpan span("sort", "diff");
+		span.SetCount("elements", vec.size());
+
+		if (std::is_sorted(vec.begin(), vec.end()))
+			return;
+
+		auto size = vec.size();
+		auto chunkSize = (size + pool.Size() - 1) / pool.Size();
+
+		pool.ParallelFor(size, chunkSize, [&vec](std::size_t begin, std::size_t end) {
+			std::sort(vec.begin() + begin, vec.begin() + end);
+		});
+
+		for (auto width = chunkSize; width < size; width *= 2) {
+			pool.ParallelFor((size + 2 * width - 1) / (2 * width), 1, [&vec, width, size](std::size_t begin, std::size_t end) {
+				for (auto merge = begin; merge < end; merge++) {
+					auto first = merge * 2 * width;
+					auto middle = std::min(first + width, size);
+					auto last = std::min(first + 2 * width, size);
+					std::inplace_merge(vec.begin() + first, vec.begin() + middle, vec.begin() + last);
+				}
+			});
+		}
+	}
+
+	/**
+	\class ManifestCompare::PairState
+	Models and task counters of a pair being compared.
+	*/
+	struct ManifestCompare::PairState {
+		std::size_t Index;
+		LPModel First;
+		LPModel Second;
+		CompareResult Result;
+		std::atomic<int> ModelsLeft;
+		std::atomic<int> SectionsLeft;
+		std::mutex ErrorMutex;
+		std::string Error;
+		std::chrono::steady_clock::time_point Start;
+
+		explicit PairState(std::size_t index) : Index(index), ModelsLeft(2), SectionsLeft(5), Start(std::chrono::steady_clock::now()) {
+			First.ReportProgress = false;
+			Second.ReportProgress = false;
+		}
+
+		void SetError(const std::string &error) {
+			std::lock_guard<std::mutex> lock(ErrorMutex);
+			if (Error.empty())
+				Error = error;
+		}
+	};
+
+	/**
+	Reads a manifest of model pairs. Every line holds two filenames separated by a tab, or by
+	whitespace if there is no tab. Empty lines and lines starting with # are skipped.
+
+	\param filename Filename of the manifest.
+	\param pairs Pairs read.
+	\return false if the manifest cannot be read.
+	*/
+	bool ManifestCompare::ReadManifest(const std::string &filename, std::vector<ComparePair> &pairs) {
+
+		std::ifstream file(filename);
+
+		if (!file) {
+			std::cout << "Cannot open file: " << filename << std::endl;
+			return false;
+		}
+
+		std::string line;
+		long lineNumber = 0;
+
+		while (std::getline(file, line)) {
+			lineNumber++;
+			boost::trim(line);
+
+			if (line.empty() || line[0] == '#')
+				continue;
+
+			std::vector<std::string> fields;
+
+			if (line.find('\t') != std::string::npos)
+				boost::split(fields, line, boost::is_any_of("\t"), boost::token_compress_on);
+			else
+				boost::split(fields, line, boost::is_any_of(" "), boost::token_compress_on);
+
+			if (fields.size() != 2) {
+				std::cout << "Expected two filenames on line " << lineNumber << " of " << filename << std::endl;
+				return false;
+			}
+
+			ComparePair pair;
+			pair.First = boost::trim_copy(fields[0]);
+			pair.Second = boost::trim_copy(fields[1]);
+			pairs.push_back(pair);
+		}
+
+		return true;
+	}
+
+	/**
+	Compares all pairs and blocks until they are finished. Results are stored in the pairs.
+
+	\param pairs Pairs to compare.
+	*/
+	void ManifestCompare::Run(std::vector<ComparePair> &pairs) {
+
+		this->pairs = &pairs;
+
+		for (std::size_t i = 0; i < pairs.size(); i++) {
+			boost::system::error_code ec1, ec2;
+			auto size = boost::filesystem::file_size(pairs[i].First, ec1) + boost::filesystem::file_size(pairs[i].Second, ec2);
+
+			pairs[i].EstimatedMemory = ec1 || ec2 ? 0 : size * MemoryPerFileByte;
+			admissionOrder.push_back(i);
+		}
+
+		// largest pairs first, so the longest pair does not start last.
+		std::stable_sort(admissionOrder.begin(), admissionOrder.end(), [&pairs](std::size_t a, std::size_t b) {
+			return pairs[a].EstimatedMemory > pairs[b].EstimatedMemory;
+		});
+
+		std::unique_lock<std::mutex> lock(mutex);
+		AdmitPairs();
+		pairFinished.wait(lock, [this] { return finished == this->pairs->size(); });
+	}
+
+	/**
+	Starts waiting pairs while they fit the memory budget. A pair is always started if nothing is
+	running. Without a budget, one pair per worker thread runs at a time. Called with mutex held.
+	*/
+	void ManifestCompare::AdmitPairs() {
+
+		while (nextAdmission < admissionOrder.size()) {
+			auto index = admissionOrder[nextAdmission];
+			auto memory = (*pairs)[index].EstimatedMemory;
+
+			bool fits = memoryBudget > 0
+				? memoryInUse + memory <= memoryBudget
+				: running < pool.Size();
+
+			if (running > 0 && !fits)
+				return;
+
+			running++;
+			memoryInUse += memory;
+			nextAdmission++;
+
+			StartPair(index);
+		}
+	}
+
+	/**
+	Queues reading both models of a pair.
+
+	\param index Index of the pair.
+	*/
+	void ManifestCompare::StartPair(std::size_t index) {
+
+		auto state = std::make_shared<PairState>(index);
+
+		pool.Enqueue([this, state]() { ReadModel(state, true); });
+		pool.Enqueue([this, state]() { ReadModel(state, false); });
+	}
+
+	/**
+	Reads a model of a pair, parsing its rows on the pool. The last model read schedules the section
+	comparisons.
+
+	\param state Pair being compared.
+	\param first Read the first model if true, the second otherwise.
+	*/
+	void ManifestCompare::ReadModel(const std::shared_ptr<PairState> &state, bool first) {
+
+		const auto &filename = first ? (*pairs)[state->Index].First : (*pairs)[state->Index].Second;
+		auto &model = first ? state->First : state->Second;
+
+		try {
+			model.Canonical = Canonical;
+			model.ParsePool = &pool;
+			if (!model.ReadModel(filename))
+				state->SetError("cannot read " + filename);
+		}
+		catch (std::exception &e) {
+			state->SetError("cannot read " + filename + ": " + e.what());
+		}
+
+		if (--state->ModelsLeft == 0)
+			CompareSections(state);
+	}
+
+	/**
+	Schedules sorting and diffing of every section of a pair.
+
+	\param state Pair being compared.
+	*/
+	void ManifestCompare::CompareSections(const std::shared_ptr<PairState> &state) {
+
+		if (!state->Error.empty()) {
+			FinishPair(state);
+			return;
+		}
+
+		ScheduleSection(state, state->First.Generals, state->Second.Generals, state->Result.Generals);
+		ScheduleSection(state, state->First.Binaries, state->Second.Binaries, state->Result.Binaries);
+		ScheduleSection(state, state->First.SosVars, state->Second.SosVars, state->Result.SosVars);
+		ScheduleSection(state, state->First.Bounds, state->Second.Bounds, state->Result.Bounds);
+		ScheduleSection(state, state->First.Constraints, state->Second.Constraints, state->Result.Constraints);
+	}
+
+	/**
+	Queues sorting a section of both models as two tasks, followed by a diff task. Large sections are
+	sorted in parallel chunks, see sort_on_pool.
+
+	\param state Pair being compared.
+	\param vec Section of the first model.
+	\param vecother Section of the second model.
+	\param diff Result of the section.
+	*/
+	template <typename T>
+	void ManifestCompare::ScheduleSection(const std::shared_ptr<PairState> &state, std::vector<T> &vec, std::vector<T> &vecother, SectionDiff<T> &diff) {
+
+		auto sortsLeft = std::make_shared<std::atomic<int>>(2);
+		auto collect = !(*pairs)[state->Index].DumpPrefix.empty();
+
+		auto sorted = [this, state, sortsLeft, &vec, &vecother, &diff, collect]() {
+			if (--*sortsLeft > 0)
+				return;
+
+			pool.Enqueue([this, state, &vec, &vecother, &diff, collect]() {
+				diff = collect ? CompareSection(vec, vecother, diffLimit) : CompareSection(vec, vecother, false);
+				FinishSection(state);
+			});
+		};
+
+		pool.Enqueue([this, &vec, sorted]() { sort_on_pool(pool, vec); sorted(); });
+		pool.Enqueue([this, &vecother, sorted]() { sort_on_pool(pool, vecother); sorted(); });
+	}
+
+	/**
+	Counts a finished section. The last section finishes the pair.
+
+	\param state Pair being compared.
+	*/
+	void ManifestCompare::FinishSection(const std::shared_ptr<PairState> &state) {
+		if (--state->SectionsLeft == 0)
+			FinishPair(state);
+	}
+
+	/**
+	Writes dumps of a pair, with the original text of elements read from its files if DumpSource is
+	set, stores its result and admits waiting pairs. Dumped elements are released, only counts are kept.
+
+	\param state Pair being compared.
+	*/
+	void ManifestCompare::FinishPair(const std::shared_ptr<PairState> &state) {
+
+		auto &pair = (*pairs)[state->Index];
+
+		if (state->Error.empty() && !pair.DumpPrefix.empty()) {
+			std::ostringstream log;
+			auto options = dumpOptions;
+
+			if (DumpSource) {
+				options.FirstSource = pair.First;
+				options.SecondSource = pair.Second;
+			}
+
+			DumpSectionDiff("Generals", state->Result.Generals, pair.DumpPrefix, log, options);
+			DumpSectionDiff("Binaries", state->Result.Binaries, pair.DumpPrefix, log, options);
+			DumpSectionDiff("SosVars", state->Result.SosVars, pair.DumpPrefix, log, options);
+			DumpSectionDiff("Bounds", state->Result.Bounds, pair.DumpPrefix, log, options);
+			DumpSectionDiff("Constraints", state->Result.Constraints, pair.DumpPrefix, log, options);
+		}
+
+		pair.Error = state->Error;
+		pair.Result = std::move(state->Result);
+		pair.Result.ReleaseItems();
+		pair.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - state->Start).count();
+
+		state->First = LPModel();
+		state->Second = LPModel();
+
+		std::lock_guard<std::mutex> lock(mutex);
+		running--;
+		memoryInUse -= pair.EstimatedMemory;
+		finished++;
+
+		AdmitPairs();
+		pairFinished.notify_all();
+	}
+}
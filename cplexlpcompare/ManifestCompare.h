@@ -0,0 +1,107 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef MANIFESTCOMPARE_H
+#define MANIFESTCOMPARE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "LPCompare.h"
+#include "ThreadPool.h"
+
+namespace lpcompare {
+
+	/**
+	\class ComparePair
+	A pair of models listed in a manifest and the result of comparing them.
+	*/
+	struct ComparePair {
+		std::string First;
+		std::string Second;
+		std::string DumpPrefix; /**< Filename prefix for difference dumps, empty to only count differences. */
+		std::uintmax_t EstimatedMemory = 0;
+		std::string Error; /**< Reason the pair could not be compared, empty on success. */
+		CompareResult Result;
+		double Seconds = 0;
+	};
+
+	/**
+	\class ManifestCompare
+	Compares many pairs of models inside one process. Reading, sorting and diffing of every pair are
+	separate tasks on a work-stealing ThreadPool. Models are parsed and large sections sorted in
+	chunks on the same pool, so a large pair is spread over idle workers; diffing a section is one task.
+	Pairs are admitted largest first while their estimated memory fits a budget.
+	*/
+	class ManifestCompare {
+
+		struct PairState;
+
+		ThreadPool &pool;
+		std::uintmax_t memoryBudget;
+		DumpOptions dumpOptions;
+		DiffLimit diffLimit;
+
+		std::vector<ComparePair> *pairs = nullptr;
+		std::vector<std::size_t> admissionOrder;
+		std::size_t nextAdmission = 0;
+		std::size_t running = 0;
+		std::size_t finished = 0;
+		std::uintmax_t memoryInUse = 0;
+		std::mutex mutex;
+		std::condition_variable pairFinished;
+
+		void AdmitPairs();
+		void StartPair(std::size_t index);
+		void ReadModel(const std::shared_ptr<PairState> &state, bool first);
+		void CompareSections(const std::shared_ptr<PairState> &state);
+		void FinishSection(const std::shared_ptr<PairState> &state);
+		void FinishPair(const std::shared_ptr<PairState> &state);
+
+		template <typename T>
+		void ScheduleSection(const std::shared_ptr<PairState> &state, std::vector<T> &vec, std::vector<T> &vecother, SectionDiff<T> &diff);
+
+	public:
+
+		static const unsigned MemoryPerFileByte = 4; /**< Estimated model memory per byte of LP file. */
+
+		bool Canonical = false; /**< Read constraints in canonical form, see Constraint::Canonicalize. */
+		bool DumpSource = false; /**< Dump the original text of differing elements, read again from the files of each pair. */
+
+		ManifestCompare(ThreadPool &pool, std::uintmax_t memoryBudget, const DumpOptions &dumpOptions = DumpOptions(),
+			const DiffLimit &diffLimit = DiffLimit())
+			: pool(pool), memoryBudget(memoryBudget), dumpOptions(dumpOptions), diffLimit(diffLimit) {}
+
+		void Run(std::vector<ComparePair> &pairs);
+
+		static bool ReadManifest(const std::string &filename, std::vector<ComparePair> &pairs);
+	};
+}
+
+#endif // MANIFESTCOMPARE_H
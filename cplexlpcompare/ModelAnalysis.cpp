@@ -0,0 +1,418 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#include "ModelAnalysis.h"
+
+#include <algorithm>
+
+#include "Fingerprint.h"
+#include "Hash.h"
+#include "Trace.h"
+
+/**
+\file ModelAnalysis.cpp
+Implements ModelAnalysis class.
+*/
+
+namespace lpcompare {
+
+	/**
+	Hash of an element and its index in the section, partitioned and sorted to find groups.
+	*/
+	struct ElementKey {
+		std::uint64_t Hash;
+		std::uint32_t Index;
+
+		bool operator<(const ElementKey &other) const {
+			return Hash < other.Hash || (Hash == other.Hash && Index < other.Index);
+		}
+	};
+
+	const std::size_t ANALYSIS_GRAIN = 16384; /**< Elements hashed or scattered per task. */
+	const std::size_t PART_ELEMENTS = 1024; /**< Elements per part on average. */
+	const std::size_t SCATTER_CHUNKS = 64; /**< Chunks of a counting sort into parts, at most. */
+
+	/**
+	Finds groups of equal elements of a section. Elements are hashed in parallel, then scattered by
+	the high bits of their hashes into parts of about PART_ELEMENTS elements, and every part is
+	sorted and grouped in parallel. Sorting parts of constant size keeps the search linear.
+
+	\param pool Thread pool.
+	\param count Number of elements.
+	\param hash Hashes the element of an index, equal elements must have equal hashes.
+	\param equal Tells whether the elements of two indices are equal.
+	\return Groups of at least two equal elements, ordered by their first element.
+	*/
+	template <typename Hash, typename Equal>
+	std::vector<ElementGroup> find_groups(ThreadPool &pool, std::size_t count, Hash hash, Equal equal) {
+
+		std::vector<ElementKey> keys(count);
+
+		pool.ParallelFor(count, ANALYSIS_GRAIN, [&keys, &hash](std::size_t begin, std::size_t end) {
+			for (auto i = begin; i < end; i++)
+				keys[i] = { hash(i), static_cast<std::uint32_t>(i) };
+		});
+
+		unsigned partBits = 0;
+		while (partBits < 20 && (std::size_t(1) << partBits) * PART_ELEMENTS < count)
+			partBits++;
+
+		std::size_t parts = std::size_t(1) << partBits;
+		auto part_of = [partBits](std::uint64_t h) { return partBits == 0 ? 0 : static_cast<std::size_t>(h >> (64 - partBits)); };
+
+		// counting sort by part: every chunk counts its keys, then scatters them at its offsets.
+		// Chunks are few, their counters take parts * SCATTER_CHUNKS words at most.
+		auto chunkSize = std::max(ANALYSIS_GRAIN, count / SCATTER_CHUNKS + 1);
+		std::size_t chunks = (count + chunkSize - 1) / chunkSize;
+		std::vector<std::size_t> offsets(chunks * parts, 0);
+
+		pool.ParallelFor(count, chunkSize, [&](std::size_t begin, std::size_t end) {
+			auto chunkOffsets = &offsets[begin / chunkSize * parts];
+			for (auto i = begin; i < end; i++)
+				chunkOffsets[part_of(keys[i].Hash)]++;
+		});
+
+		std::vector<std::size_t> partBegin(parts + 1, 0);
+		std::size_t total = 0;
+
+		for (std::size_t part = 0; part < parts; part++) {
+			partBegin[part] = total;
+			for (std::size_t chunk = 0; chunk < chunks; chunk++) {
+				auto chunkCount = offsets[chunk * parts + part];
+				offsets[chunk * parts + part] = total;
+				total += chunkCount;
+			}
+		}
+		partBegin[parts] = total;
+
+		std::vector<ElementKey> sorted(count);
+
+		pool.ParallelFor(count, chunkSize, [&](std::size_t begin, std::size_t end) {
+			auto chunkOffsets = &offsets[begin / chunkSize * parts];
+			for (auto i = begin; i < end; i++)
+				sorted[chunkOffsets[part_of(keys[i].Hash)]++] = keys[i];
+		});
+
+		keys.clear();
+		keys.shrink_to_fit();
+
+		std::vector<std::vector<ElementGroup>> partGroups(parts);
+
+		pool.ParallelFor(parts, 16, [&](std::size_t begin, std::size_t end) {
+
+			std::vector<ElementGroup> classes;
+
+			for (auto part = begin; part < end; part++) {
+
+				auto first = sorted.begin() + partBegin[part];
+				auto last = sorted.begin() + partBegin[part + 1];
+				std::sort(first, last);
+
+				for (auto run = first; run != last;) {
+					auto runEnd = run + 1;
+					while (runEnd != last && runEnd->Hash == run->Hash)
+						runEnd++;
+
+					if (runEnd - run > 1) {
+						// elements of equal hash are split into classes of equal elements.
+						classes.clear();
+
+						for (auto key = run; key != runEnd; key++) {
+							auto found = std::find_if(classes.begin(), classes.end(), [&](const ElementGroup &group) {
+								return equal(group.Elements[0], key->Index);
+							});
+
+							if (found == classes.end()) {
+								classes.emplace_back();
+								found = classes.end() - 1;
+							}
+							found->Elements.push_back(key->Index);
+						}
+
+						for (auto &group : classes) {
+							if (group.Elements.size() > 1)
+								partGroups[part].push_back(std::move(group));
+						}
+					}
+
+					run = runEnd;
+				}
+			}
+		});
+
+		std::vector<ElementGroup> groups;
+
+		for (auto &part : partGroups)
+			for (auto &group : part)
+				groups.push_back(std::move(group));
+
+		std::sort(groups.begin(), groups.end(), [](const ElementGroup &a, const ElementGroup &b) {
+			return a.Elements[0] < b.Elements[0];
+		});
+
+		return groups;
+	}
+
+	/**
+	Hashes the terms of a constraint scaled as by Constraint::Canonicalize, so that multiples of a
+	constraint get equal hashes. The hash does not depend on the order of the terms.
+
+	\param cons Constraint.
+	\return Hash of the scaled terms.
+	*/
+	std::uint64_t hash_parallel(const Constraint &cons) {
+
+		const auto &terms = cons.GetTerms();
+		const Term *lead = nullptr;
+
+		for (const auto &term : terms) {
+			if (term.coeff != 0 && (lead == nullptr || term.varName < lead->varName))
+				lead = &term;
+		}
+
+		if (lead == nullptr)
+			return 0;
+
+		std::uint64_t h = 0;
+
+		for (const auto &term : terms) {
+			if (term.coeff != 0)
+				h += HashCombine(HashElement(term.varName), NumberBits(term.coeff / lead->coeff));
+		}
+
+		return Mix64(h);
+	}
+
+	/**
+	Finds duplicate and parallel rows and duplicate bounds of a model.
+
+	\param model Model to analyze, sections are left in their order.
+	*/
+	void ModelAnalysis::Analyze(const LPModel &model) {
+
+		const auto &constraints = model.Constraints;
+		const auto &bounds = model.Bounds;
+
+		{
+			TraceSpan span("find duplicate rows", "analyze");
+			span.SetCount("rows", constraints.size());
+
+			DuplicateRows = find_groups(pool, constraints.size(),
+				[&constraints](std::size_t i) { return HashElement(constraints[i]); },
+				[&constraints](std::size_t a, std::size_t b) { return constraints[a] == constraints[b]; });
+		}
+
+		{
+			TraceSpan span("find parallel rows", "analyze");
+			span.SetCount("rows", constraints.size());
+
+			// every row is copied and canonicalized once, rows of equal hash are compared in canonical form.
+			std::vector<Constraint> canonical(constraints.size());
+
+			pool.ParallelFor(constraints.size(), ANALYSIS_GRAIN, [&](std::size_t begin, std::size_t end) {
+				for (auto i = begin; i < end; i++) {
+					canonical[i] = constraints[i];
+					canonical[i].Canonicalize();
+				}
+			});
+
+			auto groups = find_groups(pool, constraints.size(),
+				[&constraints](std::size_t i) { return hash_parallel(constraints[i]); },
+				[&canonical](std::size_t a, std::size_t b) { return canonical[a].GetTerms() == canonical[b].GetTerms(); });
+
+			ParallelRows.clear();
+
+			std::vector<ElementGroup> classes;
+
+			for (auto &group : groups) {
+
+				// rows of a group have equal canonical terms, they are split into classes of one
+				// constraint scaled by their canonical sense and right-hand side. The group is sorted
+				// stably by them, so every class keeps its rows in ascending order.
+				classes.clear();
+
+				auto elements = group.Elements;
+				std::stable_sort(elements.begin(), elements.end(), [&canonical](std::uint32_t a, std::uint32_t b) {
+					return canonical[a].GetSign() < canonical[b].GetSign()
+						|| (canonical[a].GetSign() == canonical[b].GetSign() && canonical[a].GetRHS() < canonical[b].GetRHS());
+				});
+
+				for (auto index : elements) {
+					if (classes.empty() || canonical[classes.back().Elements[0]].GetSign() != canonical[index].GetSign()
+						|| canonical[classes.back().Elements[0]].GetRHS() != canonical[index].GetRHS()) {
+						classes.emplace_back();
+						classes.back().Same = true;
+					}
+					classes.back().Elements.push_back(index);
+				}
+
+				std::sort(classes.begin(), classes.end(), [](const ElementGroup &a, const ElementGroup &b) {
+					return a.Elements[0] < b.Elements[0];
+				});
+
+				ElementGroup conflicting;
+
+				for (auto &scaled : classes) {
+					conflicting.Elements.push_back(scaled.Elements[0]);
+
+					auto duplicates = std::all_of(scaled.Elements.begin(), scaled.Elements.end(), [&](std::uint32_t index) {
+						return constraints[index] == constraints[scaled.Elements[0]];
+					});
+
+					// classes of duplicates only are reported as duplicate rows.
+					if (!duplicates)
+						ParallelRows.push_back(std::move(scaled));
+				}
+
+				if (classes.size() > 1)
+					ParallelRows.push_back(std::move(conflicting));
+			}
+		}
+
+		{
+			TraceSpan span("find duplicate bounds", "analyze");
+			span.SetCount("bounds", bounds.size());
+
+			DuplicateBounds = find_groups(pool, bounds.size(),
+				[&bounds](std::size_t i) { return HashElement(bounds[i].VarName); },
+				[&bounds](std::size_t a, std::size_t b) { return bounds[a].VarName == bounds[b].VarName; });
+
+			for (auto &group : DuplicateBounds) {
+				group.Same = std::all_of(group.Elements.begin(), group.Elements.end(), [&](std::uint32_t index) {
+					return bounds[index] == bounds[group.Elements[0]];
+				});
+			}
+		}
+	}
+
+	/**
+	\return true if no duplicates were found.
+	*/
+	bool ModelAnalysis::IsClean() const {
+		return DuplicateRows.empty() && ParallelRows.empty() && DuplicateBounds.empty();
+	}
+
+	/**
+	Counts elements of groups.
+
+	\param groups Groups.
+	\param extra Count only the elements after the first of every group.
+	\return Number of elements.
+	*/
+	std::size_t count_elements(const std::vector<ElementGroup> &groups, bool extra) {
+		std::size_t count = 0;
+
+		for (const auto &group : groups)
+			count += group.Elements.size() - (extra ? 1 : 0);
+
+		return count;
+	}
+
+	/**
+	Writes example groups of a kind, each element on a line of its own.
+
+	\param groups Groups found.
+	\param examples Number of groups and of elements per group to write.
+	\param out Stream to write to.
+	\param label Writes the group description, called once per group.
+	\param element Writes an element, called with its index.
+	*/
+	template <typename Label, typename Element>
+	void write_examples(const std::vector<ElementGroup> &groups, std::size_t examples, std::ostream &out, Label label, Element element) {
+
+		for (std::size_t i = 0; i < groups.size() && i < examples; i++) {
+			const auto &group = groups[i];
+
+			out << " ";
+			label(group);
+			out << std::endl;
+
+			for (std::size_t j = 0; j < group.Elements.size() && j < examples; j++) {
+				out << "  ";
+				element(group.Elements[j]);
+				out << std::endl;
+			}
+
+			if (group.Elements.size() > examples)
+				out << "  ... " << group.Elements.size() - examples << " more" << std::endl;
+		}
+
+		if (groups.size() > examples)
+			out << " ... " << groups.size() - examples << " more groups" << std::endl;
+	}
+
+	/**
+	Writes counts of the duplicates found with examples.
+
+	\param model Model that was analyzed, for names and locations of the examples.
+	\param examples Number of groups of every kind and of elements per group to write.
+	\param out Stream to write to.
+	*/
+	void ModelAnalysis::Write(const LPModel &model, std::size_t examples, std::ostream &out) const {
+
+		auto row = [&model, &out](std::uint32_t index) {
+			const auto &cons = model.Constraints[index];
+			out << (cons.Name.empty() ? "(unnamed)" : cons.Name);
+			WriteLocation(cons.Source, out);
+		};
+
+		out << "Duplicate rows: " << count_elements(DuplicateRows, true) << " redundant in "
+			<< DuplicateRows.size() << " groups" << std::endl;
+
+		write_examples(DuplicateRows, examples, out, [&out](const ElementGroup &group) {
+			out << group.Elements.size() << " equal rows:";
+		}, row);
+
+		std::size_t scaledRows = 0;
+		std::size_t scaledGroups = 0;
+
+		for (const auto &group : ParallelRows) {
+			if (group.Same) {
+				scaledRows += group.Elements.size();
+				scaledGroups++;
+			}
+		}
+
+		out << "Parallel rows: " << scaledRows << " rows in " << scaledGroups << " groups of one constraint scaled, "
+			<< ParallelRows.size() - scaledGroups << " groups with different sense or right-hand side" << std::endl;
+
+		write_examples(ParallelRows, examples, out, [&out](const ElementGroup &group) {
+			if (group.Same)
+				out << group.Elements.size() << " rows, one constraint scaled:";
+			else
+				out << group.Elements.size() << " classes with different sense or right-hand side, one row each:";
+		}, row);
+
+		out << "Duplicate bounds: " << count_elements(DuplicateBounds, false) << " declarations of "
+			<< DuplicateBounds.size() << " variables" << std::endl;
+
+		write_examples(DuplicateBounds, examples, out, [&model, &out](const ElementGroup &group) {
+			out << model.Bounds[group.Elements[0]].VarName << ", " << group.Elements.size()
+				<< (group.Same ? " equal declarations:" : " declarations:");
+		}, [&model, &out](std::uint32_t index) {
+			Bound::dump(model.Bounds[index], out);
+		});
+	}
+}
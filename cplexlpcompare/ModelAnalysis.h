@@ -0,0 +1,86 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef MODELANALYSIS_H
+#define MODELANALYSIS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "LPModel.h"
+#include "ThreadPool.h"
+
+/**
+\file ModelAnalysis.h
+Defines the search for duplicate and parallel rows and duplicate bounds within a model.
+*/
+
+namespace lpcompare {
+
+	/**
+	Elements of a section that duplicate each other, by their index in the section.
+	*/
+	struct ElementGroup {
+		std::vector<std::uint32_t> Elements; /**< Indices in ascending order. */
+		bool Same = false; /**< Parallel rows that are one constraint scaled, bounds repeated verbatim. */
+	};
+
+	/**
+	\class ModelAnalysis
+	Finds rows and bounds of a model that repeat each other:
+	- duplicate rows, constraints with equal terms, sense and right-hand side, names aside
+	- parallel rows, constraints whose terms are multiples of each other, see Constraint::Canonicalize
+	- duplicate bounds, variables with more than one bound declaration
+
+	Rows are hashed in parallel and partitioned by hash into small parts, which are grouped in
+	parallel, so the analysis takes time linear in the size of the model. Elements of equal hash
+	are compared before they are grouped.
+	*/
+	class ModelAnalysis {
+
+		ThreadPool &pool;
+
+	public:
+
+		std::vector<ElementGroup> DuplicateRows;
+		/**
+		Rows that are one constraint scaled and not all duplicates, and for parallel rows of different
+		sense or right-hand side, a group of one row per class of rows that are one constraint scaled.
+		*/
+		std::vector<ElementGroup> ParallelRows;
+		std::vector<ElementGroup> DuplicateBounds;
+
+		explicit ModelAnalysis(ThreadPool &pool) : pool(pool) {}
+
+		void Analyze(const LPModel &model);
+
+		bool IsClean() const;
+		void Write(const LPModel &model, std::size_t examples, std::ostream &out) const;
+	};
+}
+
+#endif // MODELANALYSIS_H
@@ -0,0 +1,185 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#include "ModelCache.h"
+
+#include <sstream>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include "Hash.h"
+
+/**
+\file ModelCache.cpp
+Implements ModelCache class.
+*/
+
+namespace lpcompare {
+
+	/**
+	Hashes the contents of a file through a read-only mapping.
+
+	\param filename File to hash.
+	\param hash Hash of the file contents.
+	\return false if the file cannot be mapped.
+	*/
+	bool ModelCache::HashFile(const std::string &filename, std::uint64_t &hash) {
+
+		if (boost::filesystem::file_size(filename) == 0) {
+			hash = HashBytes("", 0);
+			return true;
+		}
+
+		boost::iostreams::mapped_file_source file(filename);
+
+		if (!file.is_open())
+			return false;
+
+		hash = HashBytes(file.data(), file.size());
+		return true;
+	}
+
+	/**
+	Finds a model in the cache or reads it. An entry is reused if the file has the same size and its
+	contents hash to the same value.
+
+	\param filename Filename of the model.
+	\param error Reason of the failure if no model is returned.
+	\return Sorted model, nullptr if it cannot be read.
+	*/
+	std::shared_ptr<LPModel> ModelCache::Get(const std::string &filename, std::string &error) {
+
+		boost::system::error_code ec;
+		auto path = boost::filesystem::absolute(filename).string();
+
+		auto size = boost::filesystem::file_size(path, ec);
+
+		if (ec) {
+			error = "File not found: " + filename;
+			return nullptr;
+		}
+
+		std::uint64_t hash = 0;
+		bool hashed = false;
+
+		try {
+			hashed = HashFile(path, hash);
+		}
+		catch (std::exception &e) {
+			error = std::string("Cannot open file: ") + e.what();
+			return nullptr;
+		}
+
+		if (!hashed) {
+			error = "Cannot open file: " + filename;
+			return nullptr;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			auto it = index.find(path);
+
+			if (it != index.end() && it->second->ContentHash == hash && it->second->FileSize == size) {
+				entries.splice(entries.begin(), entries, it->second);
+				hits++;
+				return entries.front().Model;
+			}
+
+			misses++;
+		}
+
+		auto model = std::make_shared<LPModel>();
+		model->ReportProgress = false;
+		model->Canonical = Canonical;
+
+		if (!model->ReadModel(path)) {
+			error = "Cannot read model: " + filename;
+			return nullptr;
+		}
+
+		model->Sort();
+
+		Entry entry;
+		entry.Path = path;
+		entry.FileSize = size;
+		entry.ContentHash = hash;
+		entry.Memory = model->EstimateMemory();
+		entry.Model = model;
+
+		Insert(std::move(entry));
+
+		return model;
+	}
+
+	/**
+	Adds an entry as the most recently used one and evicts least recently used entries
+	until the cache fits its memory cap. The new entry is never evicted.
+
+	\param entry Entry to add.
+	*/
+	void ModelCache::Insert(Entry entry) {
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto it = index.find(entry.Path);
+
+		if (it != index.end()) {
+			memoryUsed -= it->second->Memory;
+			entries.erase(it->second);
+			index.erase(it);
+		}
+
+		memoryUsed += entry.Memory;
+		entries.push_front(std::move(entry));
+		index[entries.front().Path] = entries.begin();
+
+		while (memoryUsed > memoryCap && entries.size() > 1) {
+			auto &last = entries.back();
+			memoryUsed -= last.Memory;
+			index.erase(last.Path);
+			entries.pop_back();
+		}
+	}
+
+	/**
+	Describes the cache contents.
+
+	\return one line of cache statistics.
+	*/
+	std::string ModelCache::Stats() {
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		std::ostringstream out;
+		out << "models: " << entries.size()
+			<< " memory: " << memoryUsed / (1024 * 1024) << " MB"
+			<< " cap: " << memoryCap / (1024 * 1024) << " MB"
+			<< " hits: " << hits
+			<< " misses: " << misses;
+
+		return out.str();
+	}
+}
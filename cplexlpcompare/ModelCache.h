@@ -0,0 +1,80 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef MODELCACHE_H
+#define MODELCACHE_H
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "LPModel.h"
+
+namespace lpcompare {
+
+	/**
+	\class ModelCache
+	Thread-safe LRU cache of parsed and sorted models keyed by path and content hash.
+	Files are hashed on every lookup, a rewrite within the resolution of modification times is still seen.
+	Cached models are shared read-only, evicted models stay alive until their last user releases them.
+	*/
+	class ModelCache {
+
+		struct Entry {
+			std::string Path;
+			std::uintmax_t FileSize;
+			std::uint64_t ContentHash;
+			std::size_t Memory;
+			std::shared_ptr<LPModel> Model;
+		};
+
+		std::list<Entry> entries; /**< Most recently used first. */
+		std::unordered_map<std::string, std::list<Entry>::iterator> index;
+		std::size_t memoryCap;
+		std::size_t memoryUsed = 0;
+		std::size_t hits = 0;
+		std::size_t misses = 0;
+		std::mutex mutex;
+
+		void Insert(Entry entry);
+
+	public:
+
+		bool Canonical = false; /**< Read constraints in canonical form, see Constraint::Canonicalize. */
+
+		explicit ModelCache(std::size_t memoryCap) : memoryCap(memoryCap) {}
+
+		std::shared_ptr<LPModel> Get(const std::string &filename, std::string &error);
+
+		std::string Stats();
+
+		static bool HashFile(const std::string &filename, std::uint64_t &hash);
+	};
+}
+
+#endif // MODELCACHE_H
@@ -0,0 +1,757 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#include "ModelPatch.h"
+#include "AsyncFileWriter.h"
+#include "Split.h"
+
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/iostreams/stream.hpp>
+
+/**
+\file ModelPatch.cpp
+Implements ModelPatch class.
+*/
+
+namespace lpcompare {
+
+	const char PATCH_HEADER [] = "lpcompare-patch 2";
+	const char PATCH_HEADER_V1 [] = "lpcompare-patch 1"; /**< Coefficients of 0 remove terms. */
+
+	/**
+	Maps variables of a constraint to their coefficients.
+
+	\param cons Constraint to map.
+	\param coeffs Map to fill.
+	\return false if a variable occurs more than once in the constraint.
+	*/
+	static bool map_coefficients(const Constraint &cons, std::unordered_map<std::string, double> &coeffs) {
+		for (const auto &term : cons.GetTerms()) {
+			if (!coeffs.emplace(term.varName, term.coeff).second)
+				return false;
+		}
+
+		return true;
+	}
+
+	/**
+	Builds the change turning a constraint into another one with the same name.
+
+	\param first Constraint of the first model.
+	\param second Constraint of the second model.
+	\param change Change to fill.
+	\return false if the constraints cannot be described by coefficient changes.
+	*/
+	static bool make_change(const Constraint &first, const Constraint &second, ConstraintChange &change) {
+		std::unordered_map<std::string, double> firstCoeffs, secondCoeffs;
+
+		if (!map_coefficients(first, firstCoeffs) || !map_coefficients(second, secondCoeffs))
+			return false;
+
+		change.Name = second.Name;
+		change.Sign = second.GetSign();
+		change.RHS = second.GetRHS();
+
+		for (const auto &term : second.GetTerms()) {
+			auto it = firstCoeffs.find(term.varName);
+			if (it == firstCoeffs.end() || it->second != term.coeff)
+				change.Terms.push_back(term);
+		}
+
+		for (const auto &term : first.GetTerms()) {
+			if (secondCoeffs.find(term.varName) == secondCoeffs.end())
+				change.RemovedTerms.push_back(term.varName);
+		}
+
+		return true;
+	}
+
+	/**
+	Applies a change to a constraint.
+
+	\param cons Constraint of the base model.
+	\param change Change to apply.
+	\return Changed constraint.
+	*/
+	static Constraint apply_change(const Constraint &cons, const ConstraintChange &change) {
+		std::unordered_map<std::string, double> changed;
+		for (const auto &term : change.Terms)
+			changed[term.varName] = term.coeff;
+
+		std::unordered_set<std::string> removed(change.RemovedTerms.begin(), change.RemovedTerms.end());
+
+		std::vector<Term> terms;
+		terms.reserve(cons.GetTerms().size() + change.Terms.size());
+
+		for (const auto &term : cons.GetTerms()) {
+			if (removed.count(term.varName) > 0)
+				continue;
+
+			auto it = changed.find(term.varName);
+			if (it == changed.end()) {
+				terms.push_back(term);
+				continue;
+			}
+
+			Term t;
+			t.coeff = it->second;
+			t.varName = term.varName;
+			terms.push_back(t);
+			changed.erase(it);
+		}
+
+		for (const auto &term : change.Terms) {
+			if (changed.find(term.varName) != changed.end())
+				terms.push_back(term);
+		}
+
+		return Constraint(cons.Name, std::move(terms), change.Sign, change.RHS);
+	}
+
+	/**
+	Creates a patch from the differences of two models. The comparison must have collected the differences.
+
+	\param result Differences of the first and second model.
+	\param log Stream to write warnings to.
+	\return Patch rebuilding the second model from the first.
+	*/
+	ModelPatch ModelPatch::Create(const CompareResult &result, std::ostream &log) {
+
+		ModelPatch patch;
+
+		const auto &removed = result.Constraints.FirstExceptSecond;
+		const auto &added = result.Constraints.SecondExceptFirst;
+
+		std::unordered_map<std::string, std::size_t> addedByName;
+		for (std::size_t i = 0; i < added.size(); i++) {
+			if (!added[i].Name.empty())
+				addedByName.emplace(added[i].Name, i);
+		}
+
+		std::vector<bool> changed(added.size(), false);
+		std::size_t unnamed = 0;
+
+		for (const auto &cons : removed) {
+			if (cons.Name.empty()) {
+				unnamed++;
+				continue;
+			}
+
+			auto it = addedByName.find(cons.Name);
+			if (it != addedByName.end() && !changed[it->second]) {
+				ConstraintChange change;
+				if (make_change(cons, added[it->second], change)) {
+					changed[it->second] = true;
+					patch.ChangedConstraints.push_back(std::move(change));
+					continue;
+				}
+			}
+
+			patch.RemovedConstraints.push_back(cons.Name);
+		}
+
+		for (std::size_t i = 0; i < added.size(); i++) {
+			if (!changed[i])
+				patch.AddedConstraints.push_back(added[i]);
+		}
+
+		if (unnamed > 0)
+			log << "Warning: " << unnamed << " unnamed constraints cannot be removed by the patch." << std::endl;
+
+		patch.RemovedBounds = result.Bounds.FirstExceptSecond;
+		patch.AddedBounds = result.Bounds.SecondExceptFirst;
+		patch.RemovedGenerals = result.Generals.FirstExceptSecond;
+		patch.AddedGenerals = result.Generals.SecondExceptFirst;
+		patch.RemovedBinaries = result.Binaries.FirstExceptSecond;
+		patch.AddedBinaries = result.Binaries.SecondExceptFirst;
+
+		if (!result.SosVars.AreEquivalent())
+			log << "Warning: SOS differences are not included in the patch." << std::endl;
+
+		return patch;
+	}
+
+	/**
+	Writes the patch to a file.
+
+	\param filename Name of the patch file.
+	\return false if the file cannot be written.
+	*/
+	bool ModelPatch::Write(const std::string &filename) const {
+
+		std::ofstream out(filename, std::ios::binary);
+		if (!out) {
+			std::cout << "Cannot write patch: " << filename << std::endl;
+			return false;
+		}
+
+		char number[32];
+
+		out << PATCH_HEADER << '\n';
+
+		for (const auto &name : RemovedConstraints)
+			out << "-row " << name << '\n';
+
+		for (const auto &change : ChangedConstraints) {
+			std::snprintf(number, sizeof(number), "%.17g", change.RHS);
+			out << "~row " << change.Name << " " << get_constraintop(change.Sign) << " " << number;
+
+			for (const auto &term : change.Terms) {
+				std::snprintf(number, sizeof(number), "%.17g", term.coeff);
+				out << " " << number << " " << term.varName;
+			}
+
+			for (const auto &var : change.RemovedTerms)
+				out << " - " << var;
+			out << '\n';
+		}
+
+		for (const auto &cons : AddedConstraints) {
+			out << "+row";
+			Constraint::writeLP(cons, out);
+		}
+
+		for (const auto &bound : RemovedBounds) {
+			out << "-bound";
+			Bound::writeLP(bound, out);
+		}
+
+		for (const auto &bound : AddedBounds) {
+			out << "+bound";
+			Bound::writeLP(bound, out);
+		}
+
+		for (const auto &name : RemovedGenerals)
+			out << "-general " << name << '\n';
+		for (const auto &name : AddedGenerals)
+			out << "+general " << name << '\n';
+		for (const auto &name : RemovedBinaries)
+			out << "-binary " << name << '\n';
+		for (const auto &name : AddedBinaries)
+			out << "+binary " << name << '\n';
+
+		out.flush();
+		if (!out) {
+			std::cout << "Cannot write patch: " << filename << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	/**
+	Parses a ~row line of a patch.
+
+	\param line Line without the ~row prefix.
+	\param zeroRemoves Whether a coefficient of 0 removes a term, as in version 1 patches.
+	\param change Change to fill.
+	\return false if the line is malformed.
+	*/
+	static bool parse_change(const std::string &line, bool zeroRemoves, ConstraintChange &change) {
+		std::vector<std::string> parts;
+		split(line, ' ', parts, [](const std::string& s) { return s.length() > 0; });
+
+		if (parts.size() < 3 || parts.size() % 2 == 0)
+			return false;
+
+		change.Name = parts[0];
+		change.Sign = get_constraintop(parts[1]);
+
+		try {
+			change.RHS = std::stod(parts[2]);
+
+			for (std::size_t i = 3; i + 1 < parts.size(); i += 2) {
+				if (parts[i] == "-") {
+					change.RemovedTerms.push_back(parts[i + 1]);
+					continue;
+				}
+
+				Term term;
+				term.coeff = std::stod(parts[i]);
+				term.varName = parts[i + 1];
+
+				if (zeroRemoves && term.coeff == 0)
+					change.RemovedTerms.push_back(term.varName);
+				else
+					change.Terms.push_back(term);
+			}
+		}
+		catch (const std::exception&) {
+			return false;
+		}
+
+		return true;
+	}
+
+	/**
+	Reads a patch from a file.
+
+	\param filename Name of the patch file.
+	\return false if the file cannot be read or is malformed.
+	*/
+	bool ModelPatch::Read(const std::string &filename) {
+
+		std::ifstream in(filename, std::ios::binary);
+		if (!in) {
+			std::cout << "Cannot read patch: " << filename << std::endl;
+			return false;
+		}
+
+		std::string line;
+		getline(in, line);
+		boost::trim(line);
+
+		bool version1 = line == PATCH_HEADER_V1;
+
+		if (line != PATCH_HEADER && !version1) {
+			std::cout << "Not a patch file: " << filename << std::endl;
+			return false;
+		}
+
+		std::size_t lineNumber = 1;
+
+		while (getline(in, line)) {
+			lineNumber++;
+			boost::trim_right(line);
+
+			if (line.empty())
+				continue;
+
+			auto space = line.find(' ');
+			auto kind = line.substr(0, space);
+			auto rest = space == std::string::npos ? std::string() : line.substr(space);
+			auto name = boost::trim_copy(rest);
+			bool valid = !name.empty();
+
+			if (valid && kind == "-row") {
+				RemovedConstraints.push_back(name);
+			}
+			else if (valid && kind == "~row") {
+				ConstraintChange change;
+				valid = parse_change(name, version1, change);
+				if (valid)
+					ChangedConstraints.push_back(std::move(change));
+			}
+			else if (valid && kind == "+row") {
+				auto cons = Constraint::Parse(rest);
+				valid = cons != nullptr;
+				if (valid) {
+					AddedConstraints.push_back(std::move(*cons));
+					delete cons;
+				}
+			}
+			else if (valid && (kind == "-bound" || kind == "+bound")) {
+				auto bound = Bound::Parse(rest);
+				valid = bound != nullptr;
+				if (valid) {
+					(kind == "-bound" ? RemovedBounds : AddedBounds).push_back(*bound);
+					delete bound;
+				}
+			}
+			else if (valid && kind == "-general") {
+				RemovedGenerals.push_back(name);
+			}
+			else if (valid && kind == "+general") {
+				AddedGenerals.push_back(name);
+			}
+			else if (valid && kind == "-binary") {
+				RemovedBinaries.push_back(name);
+			}
+			else if (valid && kind == "+binary") {
+				AddedBinaries.push_back(name);
+			}
+			else {
+				valid = false;
+			}
+
+			if (!valid) {
+				std::cout << "Malformed patch line " << lineNumber << ": " << line << std::endl;
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/**
+	\class PatchApplier
+	State of a single pass over the base model while a patch is applied.
+	*/
+	class PatchApplier {
+
+		const ModelPatch &patch;
+		std::ostream &out;
+
+		std::unordered_set<std::string> removedRows;
+		std::unordered_map<std::string, const ConstraintChange*> changedRows;
+		std::multiset<Bound> removedBounds;
+		std::unordered_set<std::string> removedGenerals;
+		std::unordered_set<std::string> removedBinaries;
+
+		std::size_t matchedRows = 0;
+		std::size_t matchedChanges = 0;
+		std::size_t matchedGenerals = 0;
+		std::size_t matchedBinaries = 0;
+
+		bool wroteConstraints = false;
+		bool wroteBounds = false;
+		bool wroteGenerals = false;
+		bool wroteBinaries = false;
+
+		std::vector<std::string> row; /**< Lines of the constraint being read. */
+
+	public:
+
+		LPSection Section = LPSection::None;
+
+		PatchApplier(const ModelPatch &patch, std::ostream &out)
+			: patch(patch), out(out)
+		{
+			removedRows.insert(patch.RemovedConstraints.begin(), patch.RemovedConstraints.end());
+			for (const auto &change : patch.ChangedConstraints)
+				changedRows[change.Name] = &change;
+			removedBounds.insert(patch.RemovedBounds.begin(), patch.RemovedBounds.end());
+			removedGenerals.insert(patch.RemovedGenerals.begin(), patch.RemovedGenerals.end());
+			removedBinaries.insert(patch.RemovedBinaries.begin(), patch.RemovedBinaries.end());
+		}
+
+		/**
+		Writes the constraint being read, removing or changing it as the patch requires.
+		*/
+		void FlushRow() {
+			if (row.empty())
+				return;
+
+			std::vector<std::string> parts;
+			split(row[0], ' ', parts, [](const std::string& s) { return s.length() > 0; });
+
+			std::string name;
+			if (!parts.empty() && parts[0].back() == ':')
+				name = parts[0].substr(0, parts[0].length() - 1);
+
+			if (!name.empty() && removedRows.count(name) > 0) {
+				matchedRows++;
+				row.clear();
+				return;
+			}
+
+			auto change = name.empty() ? changedRows.end() : changedRows.find(name);
+
+			if (change != changedRows.end()) {
+				std::string rawcons;
+				for (const auto &line : row) {
+					rawcons += line;
+					rawcons += " ";
+				}
+
+				auto cons = Constraint::Parse(rawcons);
+				if (cons != nullptr) {
+					Constraint::writeLP(apply_change(*cons, *change->second), out);
+					delete cons;
+					matchedChanges++;
+					row.clear();
+					return;
+				}
+			}
+
+			for (const auto &line : row)
+				out << line << '\n';
+
+			row.clear();
+		}
+
+		/**
+		Ends the current section, appending the additions of the patch to it.
+		*/
+		void EndSection() {
+			switch (Section) {
+			case LPSection::Constraints:
+				FlushRow();
+				WriteAddedConstraints();
+				break;
+			case LPSection::Bounds:
+				WriteAddedBounds();
+				break;
+			case LPSection::Generals:
+				WriteAddedVars(patch.AddedGenerals, wroteGenerals);
+				break;
+			case LPSection::Binaries:
+				WriteAddedVars(patch.AddedBinaries, wroteBinaries);
+				break;
+			default:
+				break;
+			}
+
+			Section = LPSection::None;
+		}
+
+		void WriteAddedConstraints() {
+			for (const auto &cons : patch.AddedConstraints)
+				Constraint::writeLP(cons, out);
+			wroteConstraints = true;
+		}
+
+		void WriteAddedBounds() {
+			for (const auto &bound : patch.AddedBounds)
+				Bound::writeLP(bound, out);
+			wroteBounds = true;
+		}
+
+		void WriteAddedVars(const std::vector<std::string> &vars, bool &wrote) {
+			for (const auto &var : vars)
+				out << " " << var << '\n';
+			wrote = true;
+		}
+
+		/**
+		Writes the sections that the base model lacks but the patch adds to.
+		*/
+		void WriteMissingSections() {
+			if (!wroteConstraints && !patch.AddedConstraints.empty()) {
+				out << "Subject To\n";
+				WriteAddedConstraints();
+			}
+			if (!wroteBounds && !patch.AddedBounds.empty()) {
+				out << "Bounds\n";
+				WriteAddedBounds();
+			}
+			if (!wroteGenerals && !patch.AddedGenerals.empty()) {
+				out << "Generals\n";
+				WriteAddedVars(patch.AddedGenerals, wroteGenerals);
+			}
+			if (!wroteBinaries && !patch.AddedBinaries.empty()) {
+				out << "Binaries\n";
+				WriteAddedVars(patch.AddedBinaries, wroteBinaries);
+			}
+		}
+
+		/**
+		Writes a line of a Generals or Binaries section without the removed variables.
+
+		\param line Line of the section.
+		\param removed Variables to remove.
+		\param matched Number of removed variables found.
+		*/
+		void FilterVars(const std::string &line, const std::unordered_set<std::string> &removed, std::size_t &matched) {
+			std::vector<std::string> vars;
+			split(line, ' ', vars, [](const std::string& s) { return s.length() > 0 && s[0] != '\r' && s[0] != '\n'; });
+
+			std::string kept;
+			for (auto &var : vars) {
+				boost::trim(var);
+				if (removed.count(var) > 0) {
+					matched++;
+					continue;
+				}
+				kept += " ";
+				kept += var;
+			}
+
+			if (kept.length() == line.length() || removed.empty())
+				out << line << '\n';
+			else if (!kept.empty())
+				out << kept << '\n';
+		}
+
+		/**
+		Processes a line of a section.
+
+		\param line Line of the base model.
+		\return false if the line ends the section and must be processed as a section header.
+		*/
+		bool SectionLine(const std::string &line) {
+
+			if (line.length() > 0 && line[0] == '\\') {
+				if (Section == LPSection::Constraints && !row.empty())
+					row.push_back(line);
+				else
+					out << line << '\n';
+				return true;
+			}
+
+			if (Section == LPSection::Constraints) {
+				if (line.length() == 0 || line[0] != ' ')
+					return false;
+
+				if (line.length() > 1 && line[1] != ' ')
+					FlushRow();
+
+				row.push_back(line);
+				return true;
+			}
+
+			if (line.length() > 0 && line[0] != ' ')
+				return false;
+
+			switch (Section) {
+			case LPSection::Bounds: {
+				std::string copy = line;
+				auto bound = boost::trim_copy(copy).empty() ? nullptr : Bound::Parse(copy);
+
+				bool remove = false;
+				if (bound != nullptr) {
+					auto it = removedBounds.find(*bound);
+					if (it != removedBounds.end()) {
+						removedBounds.erase(it);
+						remove = true;
+					}
+					delete bound;
+				}
+
+				if (!remove)
+					out << line << '\n';
+				break;
+			}
+			case LPSection::Generals:
+				FilterVars(line, removedGenerals, matchedGenerals);
+				break;
+			case LPSection::Binaries:
+				FilterVars(line, removedBinaries, matchedBinaries);
+				break;
+			default:
+				out << line << '\n';
+				break;
+			}
+
+			return true;
+		}
+
+		/**
+		Processes a line of the base model.
+
+		\param line Line of the base model.
+		*/
+		void Line(const std::string &line) {
+
+			if (Section != LPSection::None && SectionLine(line))
+				return;
+
+			EndSection();
+
+			auto header = boost::trim_copy(line);
+			auto section = LPModel::FindSection(header);
+
+			if (section == LPSection::None && boost::iequals(header, "End"))
+				WriteMissingSections();
+
+			if (section == LPSection::Constraints)
+				wroteConstraints = true;
+			else if (section == LPSection::Bounds)
+				wroteBounds = true;
+
+			out << line << '\n';
+
+			if (section != LPSection::SosVars)
+				Section = section;
+		}
+
+		/**
+		Finishes the pass over the base model.
+
+		\param log Stream to write unmatched patch entries to.
+		\return false if some entries of the patch did not match the base model.
+		*/
+		bool Finish(std::ostream &log) {
+			EndSection();
+			WriteMissingSections();
+
+			std::size_t unmatched = 0;
+
+			auto report = [&](std::size_t expected, std::size_t matched, const char *what) {
+				if (matched < expected) {
+					log << "Warning: " << expected - matched << " " << what << " of the patch not found in the base model." << std::endl;
+					unmatched += expected - matched;
+				}
+			};
+
+			report(removedRows.size(), matchedRows, "removed constraints");
+			report(changedRows.size(), matchedChanges, "changed constraints");
+			report(patch.RemovedBounds.size(), patch.RemovedBounds.size() - removedBounds.size(), "removed bounds");
+			report(removedGenerals.size(), matchedGenerals, "removed generals");
+			report(removedBinaries.size(), matchedBinaries, "removed binaries");
+
+			return unmatched == 0;
+		}
+	};
+
+	/**
+	Applies the patch to a model file, writing the patched model to another file.
+	Lines of the base model that the patch does not touch are copied verbatim.
+
+	\param baseFilename LP file to patch.
+	\param outFilename LP file to write.
+	\param log Stream to write warnings to.
+	\return false if a file cannot be read or written, or the patch does not match the base model.
+	*/
+	bool ModelPatch::Apply(const std::string &baseFilename, const std::string &outFilename, std::ostream &log) const {
+
+		if (!boost::filesystem::exists(baseFilename)) {
+			log << "File not found: " << baseFilename << std::endl;
+			return false;
+		}
+
+		boost::iostreams::stream<boost::iostreams::mapped_file_source> file(baseFilename);
+
+		if (!file) {
+			log << "Cannot open file: " << baseFilename << std::endl;
+			return false;
+		}
+
+		AsyncFileWriter writer;
+		if (!writer.Open(outFilename, false)) {
+			log << "Cannot write model: " << outFilename << std::endl;
+			return false;
+		}
+
+		bool matched;
+		{
+			WriterStreamBuf streamBuf(writer);
+			std::ostream out(&streamBuf);
+			PatchApplier applier(*this, out);
+
+			std::string line;
+			while (getline(file, line))
+				applier.Line(line);
+
+			matched = applier.Finish(log);
+		}
+
+		if (!writer.Close()) {
+			log << "Cannot write model: " << outFilename << std::endl;
+			return false;
+		}
+
+		return matched;
+	}
+}
@@ -0,0 +1,85 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef MODELPATCH_H
+#define MODELPATCH_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "LPCompare.h"
+
+namespace lpcompare {
+
+	/**
+	\class ConstraintChange
+	New sign, right-hand side and changed coefficients of a constraint that exists in both models.
+	*/
+	struct ConstraintChange {
+		std::string Name;
+		ConstraintOp Sign;
+		double RHS;
+		std::vector<Term> Terms; /**< Changed or added terms, a coefficient of 0 is kept as a term. */
+		std::vector<std::string> RemovedTerms; /**< Variables whose terms are removed. */
+	};
+
+	/**
+	\class ModelPatch
+	Differences between two models that rebuild the second model from the first.
+
+	A patch is a text file starting with <tt>lpcompare-patch 2</tt>, followed by one change per line:
+	- <tt>-row name</tt> removes a constraint
+	- <tt>+row  name: 2 x + 3 y <= 4</tt> adds a constraint
+	- <tt>~row name sign rhs [coeff var]... [- var]...</tt> changes a constraint, <tt>- var</tt> removes the term of var
+
+	Version 1 patches, where a coefficient of 0 removed a term, are still read.
+	- <tt>-bound</tt> and <tt>+bound</tt> followed by a bound line remove and add bounds
+	- <tt>-general</tt>, <tt>+general</tt>, <tt>-binary</tt> and <tt>+binary</tt> followed by a variable name
+
+	Constraints are referenced by name. SOS sections are not patched.
+	*/
+	class ModelPatch {
+	public:
+
+		std::vector<std::string> RemovedConstraints;
+		std::vector<Constraint> AddedConstraints;
+		std::vector<ConstraintChange> ChangedConstraints;
+		std::vector<Bound> RemovedBounds;
+		std::vector<Bound> AddedBounds;
+		std::vector<std::string> RemovedGenerals;
+		std::vector<std::string> AddedGenerals;
+		std::vector<std::string> RemovedBinaries;
+		std::vector<std::string> AddedBinaries;
+
+		static ModelPatch Create(const CompareResult &result, std::ostream &log = std::cout);
+
+		bool Write(const std::string &filename) const;
+		bool Read(const std::string &filename);
+		bool Apply(const std::string &baseFilename, const std::string &outFilename, std::ostream &log = std::cout) const;
+	};
+}
+
+#endif // MODELPATCH_H
@@ -0,0 +1,612 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#include "MpsReader.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include "LPScanner.h"
+#include "Trace.h"
+
+/**
+\file MpsReader.cpp
+Implements MpsReader class.
+*/
+
+using std::cout;
+
+namespace lpcompare {
+
+	const std::size_t MPS_FIELDS = 7; /**< Fields of a data line kept, one more than MPS allows. */
+	const double MPS_INFINITY = std::numeric_limits<double>::infinity();
+
+	/**
+	Sections of an MPS file.
+	*/
+	enum class MpsSection
+	{
+		None = 0,
+		Rows,
+		Columns,
+		Rhs,
+		Ranges,
+		Bounds,
+		Skip, /**< A section that does not contribute to the compared model, e.g. SOS or OBJSENSE. */
+		End,
+	};
+
+	/**
+	Model read from an MPS file before its rows are assembled.
+	*/
+	struct MpsModel {
+		std::unordered_map<std::string, std::uint32_t> RowIds;
+		std::vector<std::string> RowNames;
+		std::vector<char> RowTypes; /**< N, L, G or E. */
+		std::vector<double> Rhs;
+		std::vector<double> Ranges;
+		std::vector<char> HasRange;
+
+		std::unordered_map<std::string, std::uint32_t> ColumnIds;
+		std::vector<std::string> ColumnNames;
+		std::vector<char> Integer;
+		std::vector<char> Binary;
+		std::vector<double> Lower;
+		std::vector<double> Upper;
+
+		std::vector<std::uint32_t> EntryRows; /**< Nonzeros in COLUMNS order. */
+		std::vector<std::uint32_t> EntryColumns;
+		std::vector<double> EntryValues;
+	};
+
+	/**
+	Creates a reader.
+
+	\param canonical Pass constraints in their canonical form, see Constraint::Canonicalize.
+	\param reportProgress Print the number of lines read to std::cout every million lines.
+	*/
+	MpsReader::MpsReader(bool canonical, bool reportProgress)
+		: canonical(canonical), reportProgress(reportProgress)
+	{
+	}
+
+	/**
+	Tells whether a file is read as an MPS file, by its extension.
+
+	\param filename Path of the file.
+	\return true if the extension is .mps in any case.
+	*/
+	bool MpsReader::IsMpsFile(const std::string &filename) {
+		return boost::iequals(boost::filesystem::path(filename).extension().string(), ".mps");
+	}
+
+	/**
+	Splits a line into whitespace separated fields.
+
+	\param begin First byte of the line.
+	\param end End of the line, excluding the newline.
+	\param fields Receives at most MPS_FIELDS fields.
+	\return Number of fields found, up to MPS_FIELDS.
+	*/
+	static std::size_t split_fields(const char *begin, const char *end, RowRange *fields) {
+
+		std::size_t count = 0;
+		auto p = begin;
+
+		while (count < MPS_FIELDS) {
+			while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+				p++;
+			if (p == end)
+				break;
+
+			fields[count].Begin = p;
+			while (p < end && *p != ' ' && *p != '\t' && *p != '\r')
+				p++;
+			fields[count].End = p;
+			count++;
+		}
+
+		return count;
+	}
+
+	/**
+	Compares a field with a keyword.
+
+	\param field Field of a line.
+	\param keyword Keyword in upper case.
+	\return true if the field is the keyword in any case.
+	*/
+	static bool field_is(const RowRange &field, const char *keyword) {
+
+		auto length = std::strlen(keyword);
+		if (static_cast<std::size_t>(field.End - field.Begin) != length)
+			return false;
+
+		for (std::size_t i = 0; i < length; i++)
+			if (std::toupper(static_cast<unsigned char>(field.Begin[i])) != keyword[i])
+				return false;
+
+		return true;
+	}
+
+	/**
+	Parses a numeric field.
+
+	\param field Field of a line.
+	\param value Receives the number.
+	\return false if the field is not a number.
+	*/
+	static bool parse_number(const RowRange &field, double &value) {
+
+		char buffer[64];
+		auto length = static_cast<std::size_t>(field.End - field.Begin);
+
+		if (length == 0 || length >= sizeof(buffer))
+			return false;
+
+		std::memcpy(buffer, field.Begin, length);
+		buffer[length] = '\0';
+
+		char *parsed;
+		value = std::strtod(buffer, &parsed);
+
+		return parsed == buffer + length;
+	}
+
+	/**
+	Finds the section started by a line of an MPS file.
+
+	\param keyword First field of the line.
+	\return Section started by the line.
+	*/
+	static MpsSection find_section(const RowRange &keyword) {
+
+		if (field_is(keyword, "ROWS"))
+			return MpsSection::Rows;
+		if (field_is(keyword, "COLUMNS"))
+			return MpsSection::Columns;
+		if (field_is(keyword, "RHS"))
+			return MpsSection::Rhs;
+		if (field_is(keyword, "RANGES"))
+			return MpsSection::Ranges;
+		if (field_is(keyword, "BOUNDS"))
+			return MpsSection::Bounds;
+		if (field_is(keyword, "ENDATA"))
+			return MpsSection::End;
+		if (field_is(keyword, "NAME"))
+			return MpsSection::None;
+
+		return MpsSection::Skip;
+	}
+
+	/**
+	Finds the id of a row or column.
+
+	\param ids Ids by name.
+	\param field Name of the row or column.
+	\param key Reused buffer for the name.
+	\param id Receives the id.
+	\return false if there is no such row or column.
+	*/
+	static bool find_id(const std::unordered_map<std::string, std::uint32_t> &ids, const RowRange &field, std::string &key, std::uint32_t &id) {
+
+		key.assign(field.Begin, field.End);
+
+		auto found = ids.find(key);
+		if (found == ids.end())
+			return false;
+
+		id = found->second;
+		return true;
+	}
+
+	/**
+	Writes a bound as a line of an LP file written by CPLEX.
+
+	\param name Column name.
+	\param lower Lower bound.
+	\param upper Upper bound.
+	\return Line of the Bounds section.
+	*/
+	static std::string bound_line(const std::string &name, double lower, double upper) {
+
+		char buffer[64];
+		std::string line = " ";
+
+		if (lower == upper) {
+			std::snprintf(buffer, sizeof(buffer), " = %.17g", upper);
+			return line + name + buffer;
+		}
+
+		if (lower == -MPS_INFINITY && upper == MPS_INFINITY)
+			return line + name + " Free";
+
+		if (lower == -MPS_INFINITY)
+			line += "-inf <= ";
+		else if (lower != 0 || upper == MPS_INFINITY) {
+			std::snprintf(buffer, sizeof(buffer), "%.17g <= ", lower);
+			line += buffer;
+		}
+
+		line += name;
+
+		if (upper != MPS_INFINITY) {
+			std::snprintf(buffer, sizeof(buffer), " <= %.17g", upper);
+			line += buffer;
+		}
+
+		return line;
+	}
+
+	/**
+	Passes a bound to a sink the way LPModel reads it from an LP file.
+
+	\param name Column name.
+	\param lower Lower bound.
+	\param upper Upper bound.
+	\param sink Sink to receive the bound.
+	*/
+	static void add_bound(const std::string &name, double lower, double upper, ModelSink &sink) {
+
+		auto b = Bound::Parse(bound_line(name, lower, upper));
+
+		if (b != nullptr) {
+			sink.AddBound(*b);
+			delete b;
+		}
+	}
+
+	/**
+	Maps an MPS file and reads it.
+
+	\param filename Path of the MPS file.
+	\param sink Sink to receive parsed elements.
+	\return true if the model is read successfully.
+	*/
+	bool MpsReader::Read(const std::string &filename, ModelSink &sink) {
+
+		if (!boost::filesystem::exists(filename)) {
+			cout << "File not found: " << filename;
+			return false;
+		}
+
+		if (boost::filesystem::file_size(filename) == 0)
+			return true;
+
+		TraceSpan span("read file", "read");
+		boost::iostreams::mapped_file_source file;
+
+		try {
+			file.open(filename);
+		}
+		catch (const std::exception &) {
+			cout << "Cannot open file: " << filename;
+			return false;
+		}
+
+		span.SetCount("bytes", file.size());
+		return Read(file.data(), file.size(), sink);
+	}
+
+	/**
+	Reads an MPS model held in memory. Data lines start with whitespace and have whitespace
+	separated fields, hence names must not contain spaces, also in fixed MPS.
+
+	\param data MPS file contents.
+	\param length Length of data in bytes.
+	\param sink Sink to receive parsed elements.
+	\return false if the model is malformed.
+	*/
+	bool MpsReader::Read(const char *data, std::size_t length, ModelSink &sink) {
+
+		MpsModel model;
+		MpsSection section = MpsSection::None;
+		RowRange fields[MPS_FIELDS];
+		std::string key;
+		bool integerMarker = false;
+		long linesRead = 0;
+
+		auto position = data;
+		auto end = data + length;
+
+		TraceSpan readSpan("read MPS", "parse");
+
+		auto fail = [&linesRead](const char *message) {
+			cout << "Invalid MPS line " << linesRead << ": " << message << std::endl;
+			return false;
+		};
+
+		// adds a row or column value pair of a COLUMNS, RHS or RANGES line.
+		auto add_value = [&](std::uint32_t column, const RowRange &rowField, const RowRange &valueField) {
+
+			std::uint32_t row;
+			double value;
+
+			if (!find_id(model.RowIds, rowField, key, row))
+				return fail("unknown row");
+			if (!parse_number(valueField, value))
+				return fail("invalid number");
+
+			if (model.RowTypes[row] == 'N')
+				return true;
+
+			switch (section) {
+			case MpsSection::Columns:
+				model.EntryRows.push_back(row);
+				model.EntryColumns.push_back(column);
+				model.EntryValues.push_back(value);
+				break;
+			case MpsSection::Rhs:
+				model.Rhs[row] = value;
+				break;
+			default:
+				model.Ranges[row] = value;
+				model.HasRange[row] = 1;
+				break;
+			}
+
+			return true;
+		};
+
+		while (position < end && section != MpsSection::End) {
+
+			auto lineEnd = static_cast<const char*>(std::memchr(position, '\n', end - position));
+			if (lineEnd == nullptr)
+				lineEnd = end;
+
+			auto line = position;
+			position = lineEnd < end ? lineEnd + 1 : end;
+
+			linesRead++;
+			if (reportProgress && linesRead % 1000000 == 0)
+				cout << "Lines read: " << linesRead << std::endl;
+
+			auto count = split_fields(line, lineEnd, fields);
+
+			if (count == 0 || *line == '*')
+				continue;
+
+			if (*line != ' ' && *line != '\t') {
+				section = find_section(fields[0]);
+				continue;
+			}
+
+			switch (section) {
+			case MpsSection::Rows: {
+				if (count != 2)
+					return fail("expected a row type and name");
+
+				char type = static_cast<char>(std::toupper(static_cast<unsigned char>(*fields[0].Begin)));
+				if (fields[0].End - fields[0].Begin != 1 || std::strchr("NLGE", type) == nullptr)
+					return fail("unknown row type");
+
+				std::string name(fields[1].Begin, fields[1].End);
+				auto id = static_cast<std::uint32_t>(model.RowNames.size());
+
+				if (!model.RowIds.emplace(name, id).second)
+					return fail("duplicate row");
+
+				model.RowNames.push_back(std::move(name));
+				model.RowTypes.push_back(type);
+				model.Rhs.push_back(0);
+				model.Ranges.push_back(0);
+				model.HasRange.push_back(0);
+				break;
+			}
+			case MpsSection::Columns: {
+				if (count == 3 && field_is(fields[1], "'MARKER'")) {
+					if (field_is(fields[2], "'INTORG'"))
+						integerMarker = true;
+					else if (field_is(fields[2], "'INTEND'"))
+						integerMarker = false;
+					else
+						return fail("unknown marker");
+					break;
+				}
+
+				if (count != 3 && count != 5)
+					return fail("expected a column and one or two row values");
+
+				std::uint32_t column;
+				if (!find_id(model.ColumnIds, fields[0], key, column)) {
+					column = static_cast<std::uint32_t>(model.ColumnNames.size());
+					model.ColumnIds.emplace(key, column);
+					model.ColumnNames.push_back(key);
+					model.Integer.push_back(integerMarker);
+					model.Binary.push_back(0);
+					model.Lower.push_back(0);
+					model.Upper.push_back(MPS_INFINITY);
+				}
+
+				if (!add_value(column, fields[1], fields[2]))
+					return false;
+				if (count == 5 && !add_value(column, fields[3], fields[4]))
+					return false;
+				break;
+			}
+			case MpsSection::Rhs:
+			case MpsSection::Ranges: {
+				// the set name is optional, pairs follow it.
+				std::size_t first = count % 2;
+				if (count < 2 || count > 5)
+					return fail("expected one or two row values");
+
+				for (auto i = first; i + 1 < count; i += 2)
+					if (!add_value(0, fields[i], fields[i + 1]))
+						return false;
+				break;
+			}
+			case MpsSection::Bounds: {
+				auto &type = fields[0];
+				bool hasValue = !(field_is(type, "FR") || field_is(type, "MI") || field_is(type, "PL") || field_is(type, "BV"));
+				// the set name is optional, BV may have a value.
+				std::size_t nameField = count == 4 || (!hasValue && count == 3) ? 2 : 1;
+
+				if (count < (hasValue ? 3u : 2u) || count > 4)
+					return fail("expected a bound type, column and value");
+
+				std::uint32_t column;
+				if (!find_id(model.ColumnIds, fields[nameField], key, column))
+					return fail("unknown column");
+
+				double value = 0;
+				if (hasValue && !parse_number(fields[count - 1], value))
+					return fail("invalid number");
+
+				auto &lower = model.Lower[column];
+				auto &upper = model.Upper[column];
+
+				if (field_is(type, "UP") || field_is(type, "UI")) {
+					upper = value;
+					if (value < 0 && lower == 0)
+						lower = -MPS_INFINITY;
+				}
+				else if (field_is(type, "LO") || field_is(type, "LI"))
+					lower = value;
+				else if (field_is(type, "FX"))
+					lower = upper = value;
+				else if (field_is(type, "FR")) {
+					lower = -MPS_INFINITY;
+					upper = MPS_INFINITY;
+				}
+				else if (field_is(type, "MI"))
+					lower = -MPS_INFINITY;
+				else if (field_is(type, "PL"))
+					upper = MPS_INFINITY;
+				else if (field_is(type, "BV"))
+					model.Binary[column] = 1;
+				else
+					return fail("unknown bound type");
+
+				if (field_is(type, "UI") || field_is(type, "LI"))
+					model.Integer[column] = 1;
+				break;
+			}
+			case MpsSection::Skip:
+				break;
+			default:
+				return fail("data outside of a section");
+			}
+		}
+
+		readSpan.SetCount("lines", linesRead);
+
+		// assemble rows: count nonzeros per row, then place them at the offsets of their rows.
+		TraceSpan assembleSpan("assemble rows", "parse");
+		assembleSpan.SetCount("nonzeros", model.EntryRows.size());
+
+		auto rows = model.RowNames.size();
+		std::vector<std::size_t> offsets(rows + 1, 0);
+
+		for (auto row : model.EntryRows)
+			offsets[row + 1]++;
+		for (std::size_t i = 0; i < rows; i++)
+			offsets[i + 1] += offsets[i];
+
+		std::vector<std::uint32_t> rowColumns(model.EntryRows.size());
+		std::vector<double> rowValues(model.EntryRows.size());
+		{
+			std::vector<std::size_t> next(offsets.begin(), offsets.end() - 1);
+
+			for (std::size_t i = 0; i < model.EntryRows.size(); i++) {
+				auto at = next[model.EntryRows[i]]++;
+				rowColumns[at] = model.EntryColumns[i];
+				rowValues[at] = model.EntryValues[i];
+			}
+		}
+
+		std::vector<std::uint32_t>().swap(model.EntryRows);
+		std::vector<std::uint32_t>().swap(model.EntryColumns);
+		std::vector<double>().swap(model.EntryValues);
+
+		for (std::size_t row = 0; row < rows; row++) {
+
+			auto type = model.RowTypes[row];
+			if (type == 'N')
+				continue;
+
+			const auto &name = model.RowNames[row];
+			bool ranged = model.HasRange[row] != 0;
+
+			std::vector<Term> terms(offsets[row + 1] - offsets[row] + (ranged ? 1 : 0));
+			for (auto i = offsets[row]; i < offsets[row + 1]; i++) {
+				auto &term = terms[i - offsets[row]];
+				term.coeff = rowValues[i];
+				term.varName = model.ColumnNames[rowColumns[i]];
+			}
+
+			auto sign = type == 'L' ? ConstraintOp::LTE : type == 'G' ? ConstraintOp::GTE : ConstraintOp::EQ;
+			auto rhs = model.Rhs[row];
+
+			if (ranged) {
+				auto range = model.Ranges[row];
+				double lower = type == 'G' || (type == 'E' && range > 0) ? rhs : rhs - std::fabs(range);
+				double upper = lower + std::fabs(range);
+
+				terms.back().coeff = -1;
+				terms.back().varName = "Rg" + name;
+				sign = ConstraintOp::EQ;
+				rhs = lower;
+
+				add_bound(terms.back().varName, 0, upper - lower, sink);
+			}
+
+			Constraint cons(name, std::move(terms), sign, rhs);
+			if (canonical)
+				cons.Canonicalize();
+
+			sink.AddConstraint(std::move(cons));
+		}
+
+		for (std::size_t column = 0; column < model.ColumnNames.size(); column++) {
+
+			const auto &name = model.ColumnNames[column];
+
+			if (model.Binary[column]) {
+				sink.AddBinary(name);
+				continue;
+			}
+
+			if (model.Integer[column])
+				sink.AddGeneral(name);
+
+			if (model.Lower[column] != 0 || model.Upper[column] != MPS_INFINITY)
+				add_bound(name, model.Lower[column], model.Upper[column], sink);
+		}
+
+		return true;
+	}
+}
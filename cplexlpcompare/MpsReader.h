@@ -0,0 +1,65 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef MPSREADER_H
+#define MPSREADER_H
+
+#include <cstddef>
+#include <string>
+
+#include "LPModel.h"
+
+namespace lpcompare {
+
+	/**
+	\class MpsReader
+	Reads a fixed or free MPS file into a ModelSink, so that it can be compared with an LP file or
+	another MPS file. The file is mapped and its lines are split into fields in place. Nonzeros of
+	the column-major COLUMNS section are kept in flat arrays and assembled into rows with a counting
+	sort once the file is read, so there is no allocation per nonzero.
+
+	Elements are passed to the sink as the LP file written for the model by CPLEX would give them:
+	integer columns between INTORG and INTEND markers and LI and UI bounds are Generals, BV bounds
+	are Binaries, the objective and other free rows are left out as they are by LPModel. A ranged
+	row <tt>r</tt> becomes <tt>r: terms - Rgr = lower</tt> with the bound
+	<tt>0 <= Rgr <= upper - lower</tt>.
+	*/
+	class MpsReader {
+
+		bool canonical;
+		bool reportProgress;
+
+	public:
+
+		MpsReader(bool canonical = false, bool reportProgress = true);
+
+		static bool IsMpsFile(const std::string &filename);
+
+		bool Read(const std::string &filename, ModelSink &sink);
+		bool Read(const char *data, std::size_t length, ModelSink &sink);
+	};
+}
+
+#endif // MPSREADER_H
@@ -0,0 +1,359 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#include "PipelinedReader.h"
+
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include "HwCounters.h"
+#include "SpscRing.h"
+#include "Trace.h"
+
+/**
+\file PipelinedReader.cpp
+Implements PipelinedReader class.
+*/
+
+using std::cout;
+
+namespace lpcompare {
+
+	/**
+	Byte ranges of consecutive elements of one section, passed from the reader to a parser.
+	*/
+	struct RowBatch {
+		LPSection Section = LPSection::None;
+		std::vector<RowRange> Rows;
+		bool Last = false; /**< Marks the end of the file. */
+	};
+
+	/**
+	Parsed elements of a RowBatch, passed from a parser to the calling thread.
+	*/
+	struct ParsedBatch : public ModelSink {
+		LPSection Section = LPSection::None;
+		std::vector<std::string> Names;
+		std::vector<Bound> Bounds;
+		std::vector<Constraint> Constraints;
+		bool Last = false; /**< Marks the end of the file. */
+
+		void AddGeneral(std::string name) override { Names.push_back(std::move(name)); }
+		void AddBinary(std::string name) override { Names.push_back(std::move(name)); }
+		void AddSosVar(std::string name) override { Names.push_back(std::move(name)); }
+		void AddBound(Bound bound) override { Bounds.push_back(std::move(bound)); }
+		void AddConstraint(Constraint cons) override { Constraints.push_back(std::move(cons)); }
+	};
+
+	/**
+	Parses the elements of a batch.
+
+	\param batch Byte ranges of the elements.
+	\param parsed Receives the parsed elements.
+	\param canonical Parse constraints in their canonical form.
+	\param data Start of the model, locations of bounds and constraints are relative to it.
+	*/
+	static void parse_batch(const RowBatch &batch, ParsedBatch &parsed, bool canonical, const char *data) {
+
+		parsed.Section = batch.Section;
+		std::string buffer;
+
+		for (const auto &row : batch.Rows)
+			ParseRow(batch.Section, row, parsed, canonical, buffer, data);
+	}
+
+	/**
+	Passes parsed elements to a sink.
+
+	\param parsed Parsed elements of a batch.
+	\param sink Sink to receive the elements.
+	*/
+	static void deliver_batch(ParsedBatch &parsed, ModelSink &sink) {
+
+		switch (parsed.Section) {
+		case LPSection::Generals:
+			for (auto &name : parsed.Names)
+				sink.AddGeneral(std::move(name));
+			break;
+		case LPSection::Binaries:
+			for (auto &name : parsed.Names)
+				sink.AddBinary(std::move(name));
+			break;
+		case LPSection::SosVars:
+			for (auto &name : parsed.Names)
+				sink.AddSosVar(std::move(name));
+			break;
+		case LPSection::Bounds:
+			for (auto &bound : parsed.Bounds)
+				sink.AddBound(std::move(bound));
+			break;
+		case LPSection::Constraints:
+			for (auto &cons : parsed.Constraints)
+				sink.AddConstraint(std::move(cons));
+			break;
+		default:
+			break;
+		}
+	}
+
+	/**
+	Creates a reader.
+
+	\param parsers Number of parser threads, at least one.
+	\param canonical Read constraints in their canonical form, see Constraint::Canonicalize.
+	\param reportProgress Print read progress to std::cout.
+	*/
+	PipelinedReader::PipelinedReader(unsigned parsers, bool canonical, bool reportProgress)
+		: parsers(parsers > 0 ? parsers : 1), canonical(canonical), reportProgress(reportProgress) {}
+
+	/**
+	Creates a reader parsing on the workers of a pool.
+
+	\param pool Thread pool, may be the pool of the calling task.
+	\param canonical Read constraints in their canonical form, see Constraint::Canonicalize.
+	\param reportProgress Print read progress to std::cout.
+	*/
+	PipelinedReader::PipelinedReader(ThreadPool &pool, bool canonical, bool reportProgress)
+		: parsers(pool.Size()), canonical(canonical), reportProgress(reportProgress), pool(&pool) {}
+
+	/**
+	Maps an LP file and reads it.
+
+	\param filename Path of the LP file.
+	\param sink Sink to receive parsed elements.
+	\return true if the model is read successfully.
+	*/
+	bool PipelinedReader::Read(const std::string &filename, ModelSink &sink) {
+
+		if (!boost::filesystem::exists(filename)) {
+			cout << "File not found: " << filename;
+			return false;
+		}
+
+		if (boost::filesystem::file_size(filename) == 0)
+			return true;
+
+		TraceSpan span("read file", "read");
+		boost::iostreams::mapped_file_source file;
+
+		try {
+			file.open(filename);
+		}
+		catch (const std::exception &) {
+			cout << "Cannot open file: " << filename;
+			return false;
+		}
+
+		span.SetCount("bytes", file.size());
+		return Read(file.data(), file.size(), sink);
+	}
+
+	/**
+	Reads an LP model held in memory.
+
+	\param data LP file contents.
+	\param length Length of data in bytes.
+	\param sink Sink to receive parsed elements.
+	\return true if the model is read successfully.
+	*/
+	bool PipelinedReader::Read(const char *data, std::size_t length, ModelSink &sink) {
+
+		if (pool != nullptr)
+			return ReadOnPool(data, length, sink);
+
+		std::vector<std::unique_ptr<SpscRing<RowBatch>>> rowRings;
+		std::vector<std::unique_ptr<SpscRing<ParsedBatch>>> parsedRings;
+
+		for (unsigned i = 0; i < parsers; i++) {
+			rowRings.emplace_back(new SpscRing<RowBatch>(RingBatches));
+			parsedRings.emplace_back(new SpscRing<ParsedBatch>(RingBatches));
+		}
+
+		std::thread reader([this, data, length, &rowRings]() {
+
+			HwScope counters;
+			TraceSpan span("scan", "read");
+			span.SetCount("bytes", length);
+
+			LPScanner scanner(data, length);
+			std::size_t sequence = 0;
+			long nextProgress = 1000000;
+
+			RowBatch batch;
+			batch.Rows.reserve(BatchRows);
+
+			auto publish = [&]() {
+				rowRings[sequence++ % parsers]->Push(batch);
+				batch = RowBatch();
+				batch.Rows.reserve(BatchRows);
+			};
+
+			LPSection section;
+			RowRange row;
+
+			while (scanner.Next(section, row)) {
+
+				if (!batch.Rows.empty() && (batch.Section != section || batch.Rows.size() == BatchRows))
+					publish();
+
+				batch.Section = section;
+				batch.Rows.push_back(row);
+
+				if (reportProgress && scanner.LinesRead() >= nextProgress) {
+					cout << "Lines read: " << nextProgress << std::endl;
+					nextProgress += 1000000;
+				}
+			}
+
+			if (!batch.Rows.empty())
+				publish();
+
+			for (unsigned i = 0; i < parsers; i++) {
+				batch.Last = true;
+				publish();
+			}
+		});
+
+		std::vector<std::thread> parserThreads;
+
+		for (unsigned i = 0; i < parsers; i++) {
+			parserThreads.emplace_back([this, i, data, &rowRings, &parsedRings]() {
+				HwScope counters;
+				RowBatch batch;
+
+				while (true) {
+					rowRings[i]->Pop(batch);
+
+					ParsedBatch parsed;
+					parsed.Last = batch.Last;
+
+					if (!batch.Last) {
+						TraceSpan span("parse batch", "parse");
+						span.SetCount("rows", batch.Rows.size());
+						parse_batch(batch, parsed, canonical, data);
+					}
+
+					parsedRings[i]->Push(parsed);
+
+					if (batch.Last)
+						break;
+				}
+			});
+		}
+
+		// batches come back in the order they were handed out.
+		ParsedBatch parsed;
+
+		for (std::size_t sequence = 0;; sequence++) {
+			parsedRings[sequence % parsers]->Pop(parsed);
+
+			if (parsed.Last)
+				break;
+
+			deliver_batch(parsed, sink);
+		}
+
+		reader.join();
+		for (auto &parser : parserThreads)
+			parser.join();
+
+		return true;
+	}
+
+	/**
+	Reads an LP model held in memory, parsing on the pool. Windows of a few batches per worker are
+	scanned on the calling thread and parsed by a ParallelFor, so memory stays bounded as with rings.
+
+	\param data LP file contents.
+	\param length Length of data in bytes.
+	\param sink Sink to receive parsed elements.
+	\return true if the model is read successfully.
+	*/
+	bool PipelinedReader::ReadOnPool(const char *data, std::size_t length, ModelSink &sink) {
+
+		TraceSpan span("scan", "read");
+		span.SetCount("bytes", length);
+
+		LPScanner scanner(data, length);
+		long nextProgress = 1000000;
+
+		std::vector<RowBatch> window;
+		std::vector<ParsedBatch> parsed;
+
+		auto parse_window = [&]() {
+			parsed.clear();
+			parsed.resize(window.size());
+
+			pool->ParallelFor(window.size(), 1, [this, data, &window, &parsed](std::size_t begin, std::size_t end) {
+				for (auto i = begin; i < end; i++) {
+					TraceSpan span("parse batch", "parse");
+					span.SetCount("rows", window[i].Rows.size());
+					parse_batch(window[i], parsed[i], canonical, data);
+				}
+			});
+
+			for (auto &batch : parsed)
+				deliver_batch(batch, sink);
+
+			window.clear();
+		};
+
+		RowBatch batch;
+		batch.Rows.reserve(BatchRows);
+
+		LPSection section;
+		RowRange row;
+
+		while (scanner.Next(section, row)) {
+
+			if (!batch.Rows.empty() && (batch.Section != section || batch.Rows.size() == BatchRows)) {
+				window.push_back(std::move(batch));
+				batch = RowBatch();
+				batch.Rows.reserve(BatchRows);
+
+				if (window.size() == parsers * RingBatches)
+					parse_window();
+			}
+
+			batch.Section = section;
+			batch.Rows.push_back(row);
+
+			if (reportProgress && scanner.LinesRead() >= nextProgress) {
+				cout << "Lines read: " << nextProgress << std::endl;
+				nextProgress += 1000000;
+			}
+		}
+
+		if (!batch.Rows.empty())
+			window.push_back(std::move(batch));
+
+		parse_window();
+
+		return true;
+	}
+}
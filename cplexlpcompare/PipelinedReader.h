@@ -0,0 +1,73 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef PIPELINEDREADER_H
+#define PIPELINEDREADER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "LPModel.h"
+#include "LPScanner.h"
+#include "ThreadPool.h"
+
+namespace lpcompare {
+
+	/**
+	\class PipelinedReader
+	Reads an LP file in a pipeline so that reading and parsing overlap. A reader thread scans the
+	mapped file, taking its page faults, and hands batches of element byte ranges round robin to
+	parser threads through SpscRing buffers. The calling thread takes the parsed batches back in
+	file order and passes their elements to a ModelSink, hence the sink sees the same elements in
+	the same order as with LPModel::ReadModel. Full rings stall the earlier stage, so at most a few
+	batches per parser are in flight.
+
+	A reader created on a ThreadPool parses on the pool instead of its own threads: the calling
+	thread scans a window of batches, which are parsed by a ParallelFor, and delivers them in order.
+	*/
+	class PipelinedReader {
+
+		unsigned parsers;
+		bool canonical;
+		bool reportProgress;
+		ThreadPool *pool = nullptr;
+
+		bool ReadOnPool(const char *data, std::size_t length, ModelSink &sink);
+
+	public:
+
+		static const std::size_t BatchRows = 1024; /**< Elements per batch. */
+		static const std::size_t RingBatches = 4; /**< Batches held between two stages per parser. */
+
+		PipelinedReader(unsigned parsers, bool canonical = false, bool reportProgress = true);
+		PipelinedReader(ThreadPool &pool, bool canonical = false, bool reportProgress = true);
+
+		bool Read(const std::string &filename, ModelSink &sink);
+		bool Read(const char *data, std::size_t length, ModelSink &sink);
+	};
+}
+
+#endif // PIPELINEDREADER_H
@@ -0,0 +1,349 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#include "ShardCompare.h"
+
+#include <sstream>
+#include <boost/algorithm/string.hpp>
+
+#include "Fingerprint.h"
+
+/**
+\file ShardCompare.cpp
+Implements ShardWriter class and the result format of shard workers.
+*/
+
+namespace lpcompare {
+
+	const char SHARD_RESULT_HEADER [] = "lpcompare-shard 1";
+
+	/**
+	Creates the shard files of a model.
+
+	\param directory Directory to create the files in.
+	\param model Model name, part of the filenames.
+	\param shards Number of shards.
+	*/
+	ShardWriter::ShardWriter(const std::string &directory, const std::string &model, std::size_t shards)
+		: sections(shards, LPSection::None) {
+
+		for (std::size_t i = 0; i < shards; i++) {
+			buffers.emplace_back(new char[BufferSize]);
+			files.emplace_back(new std::ofstream());
+			files.back()->rdbuf()->pubsetbuf(buffers.back().get(), BufferSize);
+			files.back()->open(ShardFilename(directory, model, i), std::ios::binary);
+		}
+	}
+
+	/**
+	Creates the filename of a shard.
+
+	\param directory Directory of the shard files.
+	\param model Model name.
+	\param shard Index of the shard.
+	\return Path of the shard file.
+	*/
+	std::string ShardWriter::ShardFilename(const std::string &directory, const std::string &model, std::size_t shard) {
+		return directory + "/shard-" + std::to_string(shard) + "-" + model + ".lp";
+	}
+
+	/**
+	Checks whether every shard file is open and written so far.
+
+	\return false if a file cannot be written.
+	*/
+	bool ShardWriter::Good() const {
+		for (const auto &file : files) {
+			if (!file->good())
+				return false;
+		}
+		return true;
+	}
+
+	/**
+	Flushes and closes the shard files.
+
+	\return false if a file cannot be written.
+	*/
+	bool ShardWriter::Close() {
+		bool good = true;
+
+		for (auto &file : files) {
+			file->close();
+			good = good && !file->fail();
+		}
+
+		return good;
+	}
+
+	/**
+	Selects the shard of an element and starts its section there if needed.
+
+	\param hash Hash of the element.
+	\param section Section of the element.
+	\return Stream of the shard file.
+	*/
+	std::ostream &ShardWriter::Select(std::uint64_t hash, LPSection section) {
+
+		auto shard = static_cast<std::size_t>(Mix64(hash) % files.size());
+		auto &out = *files[shard];
+
+		if (sections[shard] != section) {
+			sections[shard] = section;
+
+			switch (section) {
+			case LPSection::Generals: out << "Generals\n"; break;
+			case LPSection::Binaries: out << "Binaries\n"; break;
+			case LPSection::SosVars: out << "SOS\n"; break;
+			case LPSection::Bounds: out << "Bounds\n"; break;
+			case LPSection::Constraints: out << "Subject To\n"; break;
+			default: break;
+			}
+		}
+
+		return out;
+	}
+
+	/**
+	Writes a general variable to its shard.
+
+	\param name Variable name.
+	*/
+	void ShardWriter::AddGeneral(std::string name) {
+		Select(HashElement(name), LPSection::Generals) << ' ' << name << '\n';
+	}
+
+	/**
+	Writes a binary variable to its shard.
+
+	\param name Variable name.
+	*/
+	void ShardWriter::AddBinary(std::string name) {
+		Select(HashElement(name), LPSection::Binaries) << ' ' << name << '\n';
+	}
+
+	/**
+	Writes an SOS variable to its shard.
+
+	\param name Variable name.
+	*/
+	void ShardWriter::AddSosVar(std::string name) {
+		Select(HashElement(name), LPSection::SosVars) << ' ' << name << '\n';
+	}
+
+	/**
+	Writes a bound to its shard.
+
+	\param bound Bound to write.
+	*/
+	void ShardWriter::AddBound(Bound bound) {
+		Bound::writeLP(bound, Select(HashElement(bound), LPSection::Bounds));
+	}
+
+	/**
+	Writes a constraint to its shard.
+
+	\param cons Constraint to write.
+	*/
+	void ShardWriter::AddConstraint(Constraint cons) {
+		Constraint::writeLP(cons, Select(HashElement(cons), LPSection::Constraints));
+	}
+
+	/**
+	Writes the counts and the differing elements of a section.
+
+	\param name Section name.
+	\param diff Differences of the section.
+	\param out Stream to write to.
+	\param write Function writing an element as a single line.
+	*/
+	template <typename T, typename F>
+	static void write_section(const std::string &name, const SectionDiff<T> &diff, std::ostream &out, F write) {
+
+		out << "section " << name << ' ' << diff.FirstCount << ' ' << diff.SecondCount << ' '
+			<< diff.FirstExceptSecondCount << ' ' << diff.SecondExceptFirstCount << '\n';
+
+		for (const auto &element : diff.FirstExceptSecond) {
+			out << '-';
+			write(element, out);
+		}
+
+		for (const auto &element : diff.SecondExceptFirst) {
+			out << '+';
+			write(element, out);
+		}
+	}
+
+	/**
+	Writes the result of a shard worker: the counts of every section followed by the differing
+	elements, <tt>-</tt> for elements only in the first model and <tt>+</tt> for elements only in
+	the second, in LP format. The result ends with a line <tt>end</tt>.
+
+	\param result Differences of the shard.
+	\param out Stream to write to.
+	*/
+	void WriteShardResult(const CompareResult &result, std::ostream &out) {
+
+		auto write_name = [](const std::string &name, std::ostream &out) { out << name << '\n'; };
+
+		out << SHARD_RESULT_HEADER << '\n';
+		write_section("Generals", result.Generals, out, write_name);
+		write_section("Binaries", result.Binaries, out, write_name);
+		write_section("SosVars", result.SosVars, out, write_name);
+		write_section("Bounds", result.Bounds, out, [](const Bound &bound, std::ostream &out) { Bound::writeLP(bound, out); });
+		write_section("Constraints", result.Constraints, out, [](const Constraint &cons, std::ostream &out) { Constraint::writeLP(cons, out); });
+		out << "end" << std::endl;
+	}
+
+	/**
+	Passes an element of a shard result to a sink.
+
+	\param sink Sink of the section, nullptr to skip the element.
+	\param first true for an element only in the first model.
+	\param element Element.
+	*/
+	template <typename T>
+	static void pass_element(DiffSink<T> *sink, bool first, const T &element) {
+		if (sink == nullptr)
+			return;
+
+		if (first)
+			sink->FirstExceptSecond(element);
+		else
+			sink->SecondExceptFirst(element);
+	}
+
+	/**
+	Adds the counts of a shard to a section.
+
+	\param diff Section to add to.
+	\param counts Counts of the shard, in the order they are written.
+	*/
+	template <typename T>
+	static void add_counts(SectionDiff<T> &diff, const std::size_t counts[4]) {
+		diff.Compared = true;
+		diff.FirstCount += counts[0];
+		diff.SecondCount += counts[1];
+		diff.FirstExceptSecondCount += counts[2];
+		diff.SecondExceptFirstCount += counts[3];
+	}
+
+	/**
+	Reads the result of a shard worker, adding its counts to a result and passing its elements to sinks.
+
+	\param in Stream of the worker result.
+	\param result Result to add the counts to.
+	\param sinks Sinks to receive differing elements.
+	\param log Stream to report errors to.
+	\return false if the result is malformed or incomplete.
+	*/
+	bool ReadShardResult(std::istream &in, CompareResult &result, ShardSinks &sinks, std::ostream &log) {
+
+		std::string line;
+		getline(in, line);
+		boost::trim_right(line);
+
+		if (line != SHARD_RESULT_HEADER) {
+			log << "Not a shard result: " << line << std::endl;
+			return false;
+		}
+
+		std::string section;
+
+		while (getline(in, line)) {
+			boost::trim_right(line);
+
+			if (line == "end")
+				return true;
+
+			if (line.empty())
+				continue;
+
+			if (line[0] == '-' || line[0] == '+') {
+				bool first = line[0] == '-';
+				auto rest = line.substr(1);
+				bool valid = true;
+
+				if (section == "Generals")
+					pass_element(sinks.Generals, first, rest);
+				else if (section == "Binaries")
+					pass_element(sinks.Binaries, first, rest);
+				else if (section == "SosVars")
+					pass_element(sinks.SosVars, first, rest);
+				else if (section == "Bounds") {
+					auto bound = Bound::Parse(rest);
+					valid = bound != nullptr;
+					if (valid) {
+						pass_element(sinks.Bounds, first, *bound);
+						delete bound;
+					}
+				}
+				else if (section == "Constraints") {
+					auto cons = Constraint::Parse(rest);
+					valid = cons != nullptr;
+					if (valid) {
+						pass_element(sinks.Constraints, first, *cons);
+						delete cons;
+					}
+				}
+				else
+					valid = false;
+
+				if (!valid) {
+					log << "Invalid shard result line: " << line << std::endl;
+					return false;
+				}
+				continue;
+			}
+
+			std::istringstream fields(line);
+			std::string keyword;
+			std::size_t counts[4];
+
+			if (!(fields >> keyword >> section >> counts[0] >> counts[1] >> counts[2] >> counts[3]) || keyword != "section") {
+				log << "Invalid shard result line: " << line << std::endl;
+				return false;
+			}
+
+			if (section == "Generals")
+				add_counts(result.Generals, counts);
+			else if (section == "Binaries")
+				add_counts(result.Binaries, counts);
+			else if (section == "SosVars")
+				add_counts(result.SosVars, counts);
+			else if (section == "Bounds")
+				add_counts(result.Bounds, counts);
+			else if (section == "Constraints")
+				add_counts(result.Constraints, counts);
+			else {
+				log << "Unknown section in shard result: " << section << std::endl;
+				return false;
+			}
+		}
+
+		log << "Incomplete shard result." << std::endl;
+		return false;
+	}
+}
@@ -0,0 +1,90 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef SHARDCOMPARE_H
+#define SHARDCOMPARE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "LPCompare.h"
+
+namespace lpcompare {
+
+	/**
+	\class ShardWriter
+	Partitions a model into shard LP files by the hash of its elements. Equal elements hash alike
+	whatever their name or term order, so they land in the same shard of both models and the
+	differences of all shards add up to the differences of the models.
+	*/
+	class ShardWriter : public ModelSink {
+
+		std::vector<std::unique_ptr<std::ofstream>> files;
+		std::vector<std::unique_ptr<char[]>> buffers;
+		std::vector<LPSection> sections; /**< Section last written to every shard. */
+
+		std::ostream &Select(std::uint64_t hash, LPSection section);
+
+	public:
+
+		static const std::size_t BufferSize = 1 << 16; /**< Write buffer per shard file. */
+
+		ShardWriter(const std::string &directory, const std::string &model, std::size_t shards);
+
+		static std::string ShardFilename(const std::string &directory, const std::string &model, std::size_t shard);
+
+		bool Good() const;
+		bool Close();
+
+		void AddGeneral(std::string name) override;
+		void AddBinary(std::string name) override;
+		void AddSosVar(std::string name) override;
+		void AddBound(Bound bound) override;
+		void AddConstraint(Constraint cons) override;
+	};
+
+	/**
+	\class ShardSinks
+	Receive the differing elements returned by shard workers, nullptr for sections whose elements
+	are not needed.
+	*/
+	struct ShardSinks {
+		DiffSink<std::string> *Generals = nullptr;
+		DiffSink<std::string> *Binaries = nullptr;
+		DiffSink<std::string> *SosVars = nullptr;
+		DiffSink<Bound> *Bounds = nullptr;
+		DiffSink<Constraint> *Constraints = nullptr;
+	};
+
+	void WriteShardResult(const CompareResult &result, std::ostream &out);
+	bool ReadShardResult(std::istream &in, CompareResult &result, ShardSinks &sinks, std::ostream &log = std::cout);
+}
+
+#endif // SHARDCOMPARE_H
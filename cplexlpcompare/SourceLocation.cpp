@@ -0,0 +1,77 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#include "SourceLocation.h"
+
+/**
+\file SourceLocation.cpp
+Implements writing SourceLocation instances and original text in difference dumps.
+*/
+
+namespace lpcompare {
+
+	/**
+	Writes a location as <tt>[line 12, byte 345]</tt>, nothing if the location is unknown.
+
+	\param location Location to write.
+	\param out Stream to write to.
+	*/
+	void WriteLocation(const SourceLocation &location, std::ostream &out) {
+
+		if (!location.IsKnown())
+			return;
+
+		out << "  [line " << location.Line << ", byte " << location.Offset << "]";
+	}
+
+	/**
+	Writes the original text of an element, every line on a line of its own starting with
+	<tt>indent</tt> and <tt>&gt; </tt>. Carriage returns are left out.
+
+	\param text Original text, lines separated by '\n'.
+	\param length Length of text in bytes.
+	\param indent Written before every line.
+	\param out Stream to write to.
+	*/
+	void WriteSourceText(const char *text, std::size_t length, const char *indent, std::ostream &out) {
+
+		auto end = text + length;
+
+		for (auto begin = text; begin <= end;) {
+			auto lineEnd = begin;
+			while (lineEnd < end && *lineEnd != '\n')
+				lineEnd++;
+
+			auto textEnd = lineEnd;
+			if (textEnd > begin && textEnd[-1] == '\r')
+				textEnd--;
+
+			out << '\n' << indent << "> ";
+			out.write(begin, textEnd - begin);
+
+			begin = lineEnd + 1;
+		}
+	}
+}
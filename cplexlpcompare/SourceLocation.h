@@ -0,0 +1,57 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef SOURCELOCATION_H
+#define SOURCELOCATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace lpcompare {
+
+	/**
+	\class SourceLocation
+	Position of a bound or constraint in the file it was read from, so that a difference can be
+	traced back to its original text. Elements that were not read from a file have no location.
+	*/
+	struct SourceLocation {
+		std::uint64_t Offset = 0; /**< Byte offset of the first line of the element. */
+		std::uint64_t Line = 0;   /**< Line number of the first line, starting at 1, 0 if unknown. */
+		std::uint32_t Length = 0; /**< Bytes up to the end of the last line, excluding its newline. */
+
+		SourceLocation() {}
+
+		SourceLocation(std::uint64_t offset, std::uint64_t line, std::size_t length)
+			: Offset(offset), Line(line), Length(static_cast<std::uint32_t>(length)) {}
+
+		bool IsKnown() const { return Line != 0; }
+	};
+
+	void WriteLocation(const SourceLocation &location, std::ostream &out);
+	void WriteSourceText(const char *text, std::size_t length, const char *indent, std::ostream &out);
+}
+
+#endif // SOURCELOCATION_H
@@ -0,0 +1,182 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#include "SparseMatrix.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+/**
+\file SparseMatrix.cpp
+Implements SparseMatrix class.
+*/
+
+namespace lpcompare {
+
+	/**
+	Finds the column of a variable, adding a column if the variable is new.
+
+	\param name Variable name.
+	\return Column index.
+	*/
+	std::uint32_t SparseMatrix::ColumnId(const std::string &name) {
+		auto it = ColumnIds.emplace(name, static_cast<std::uint32_t>(ColumnNames.size()));
+
+		if (it.second)
+			ColumnNames.push_back(name);
+
+		return it.first->second;
+	}
+
+	const std::size_t TransposeGrain = 16384; /**< Rows or columns per task of a parallel transpose. */
+
+	/**
+	Builds the rows of the matrix from the constraints of a model and its transpose.
+
+	\param model Model to build the matrix of.
+	\param pool Pool to transpose on, nullptr to transpose on the calling thread.
+	*/
+	void SparseMatrix::Build(const LPModel &model, ThreadPool *pool) {
+
+		std::size_t entries = 0;
+		for (const auto &cons : model.Constraints)
+			entries += cons.GetTerms().size();
+
+		RowNames.reserve(model.Constraints.size());
+		Senses.reserve(model.Constraints.size());
+		RHS.reserve(model.Constraints.size());
+		RowStart.reserve(model.Constraints.size() + 1);
+		RowColumns.reserve(entries);
+		RowValues.reserve(entries);
+
+		RowStart.push_back(0);
+
+		for (const auto &cons : model.Constraints) {
+			RowNames.push_back(cons.Name);
+			Senses.push_back(cons.GetSign());
+			RHS.push_back(cons.GetRHS());
+
+			for (const auto &term : cons.GetTerms()) {
+				RowColumns.push_back(ColumnId(term.varName));
+				RowValues.push_back(term.coeff);
+			}
+
+			RowStart.push_back(RowColumns.size());
+		}
+
+		for (const auto &bound : model.Bounds)
+			ColumnId(bound.VarName);
+		for (const auto &name : model.Generals)
+			ColumnId(name);
+		for (const auto &name : model.Binaries)
+			ColumnId(name);
+
+		Transpose(pool);
+	}
+
+	/**
+	Builds the column form from the row form with a counting sort of the entries by column.
+	On a pool, entries are counted and scattered concurrently with atomic counters per column,
+	then every column is sorted by row so that the result does not depend on scheduling.
+
+	\param pool Pool to run on, nullptr to run on the calling thread.
+	*/
+	void SparseMatrix::Transpose(ThreadPool *pool) {
+
+		ColumnStart.assign(Columns() + 1, 0);
+		ColumnRows.resize(Entries());
+		ColumnValues.resize(Entries());
+
+		if (pool == nullptr || pool->Size() < 2) {
+
+			for (auto column : RowColumns)
+				ColumnStart[column + 1]++;
+
+			for (std::size_t c = 0; c < Columns(); c++)
+				ColumnStart[c + 1] += ColumnStart[c];
+
+			std::vector<std::size_t> next(ColumnStart.begin(), ColumnStart.end() - 1);
+
+			for (std::size_t r = 0; r < Rows(); r++) {
+				for (auto k = RowStart[r]; k < RowStart[r + 1]; k++) {
+					auto position = next[RowColumns[k]]++;
+					ColumnRows[position] = static_cast<std::uint32_t>(r);
+					ColumnValues[position] = RowValues[k];
+				}
+			}
+
+			return;
+		}
+
+		std::unique_ptr<std::atomic<std::size_t>[]> next(new std::atomic<std::size_t>[Columns()]());
+
+		pool->ParallelFor(Entries(), TransposeGrain * 8, [&](std::size_t begin, std::size_t end) {
+			for (auto k = begin; k < end; k++)
+				next[RowColumns[k]].fetch_add(1, std::memory_order_relaxed);
+		});
+
+		for (std::size_t c = 0; c < Columns(); c++) {
+			ColumnStart[c + 1] = ColumnStart[c] + next[c].load(std::memory_order_relaxed);
+			next[c].store(ColumnStart[c], std::memory_order_relaxed);
+		}
+
+		pool->ParallelFor(Rows(), TransposeGrain, [&](std::size_t begin, std::size_t end) {
+			for (auto r = begin; r < end; r++) {
+				for (auto k = RowStart[r]; k < RowStart[r + 1]; k++) {
+					auto position = next[RowColumns[k]].fetch_add(1, std::memory_order_relaxed);
+					ColumnRows[position] = static_cast<std::uint32_t>(r);
+					ColumnValues[position] = RowValues[k];
+				}
+			}
+		});
+
+		pool->ParallelFor(Columns(), TransposeGrain, [&](std::size_t begin, std::size_t end) {
+			std::vector<std::pair<std::uint32_t, double>> entries;
+
+			for (auto c = begin; c < end; c++) {
+				auto first = ColumnRows.begin() + ColumnStart[c];
+				auto last = ColumnRows.begin() + ColumnStart[c + 1];
+
+				if (std::is_sorted(first, last))
+					continue;
+
+				entries.clear();
+				for (auto k = ColumnStart[c]; k < ColumnStart[c + 1]; k++)
+					entries.emplace_back(ColumnRows[k], ColumnValues[k]);
+
+				std::stable_sort(entries.begin(), entries.end(), [](const std::pair<std::uint32_t, double> &a, const std::pair<std::uint32_t, double> &b) {
+					return a.first < b.first;
+				});
+
+				for (std::size_t i = 0; i < entries.size(); i++) {
+					ColumnRows[ColumnStart[c] + i] = entries[i].first;
+					ColumnValues[ColumnStart[c] + i] = entries[i].second;
+				}
+			}
+		});
+	}
+}
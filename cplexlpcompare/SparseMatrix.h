@@ -0,0 +1,80 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef SPARSEMATRIX_H
+#define SPARSEMATRIX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "LPModel.h"
+#include "ThreadPool.h"
+
+/**
+\file SparseMatrix.h
+Defines the constraint matrix of a model in compressed sparse form.
+*/
+
+namespace lpcompare {
+
+	/**
+	\class SparseMatrix
+	Constraint matrix of a model in compressed sparse row (CSR) form together with its transpose in
+	compressed sparse column (CSC) form. Columns are variables, numbered in order of first appearance
+	in the constraints, bounds, generals and binaries.
+	*/
+	class SparseMatrix {
+	public:
+
+		std::vector<std::string> RowNames;
+		std::vector<ConstraintOp> Senses;
+		std::vector<double> RHS;
+
+		std::vector<std::string> ColumnNames;
+		std::unordered_map<std::string, std::uint32_t> ColumnIds;
+
+		std::vector<std::size_t> RowStart; /**< Entries of row r are [RowStart[r], RowStart[r + 1]). */
+		std::vector<std::uint32_t> RowColumns;
+		std::vector<double> RowValues;
+
+		std::vector<std::size_t> ColumnStart; /**< Entries of column c are [ColumnStart[c], ColumnStart[c + 1]). */
+		std::vector<std::uint32_t> ColumnRows;
+		std::vector<double> ColumnValues;
+
+		std::size_t Rows() const { return RowNames.size(); }
+		std::size_t Columns() const { return ColumnNames.size(); }
+		std::size_t Entries() const { return RowColumns.size(); }
+
+		std::uint32_t ColumnId(const std::string &name);
+
+		void Build(const LPModel &model, ThreadPool *pool = nullptr);
+		void Transpose(ThreadPool *pool = nullptr);
+	};
+}
+
+#endif // SPARSEMATRIX_H
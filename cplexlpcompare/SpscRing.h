@@ -0,0 +1,145 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/**
+\file SpscRing.h
+Defines SpscRing, a bounded lock-free queue between one producer and one consumer thread.
+*/
+
+namespace lpcompare {
+
+	/**
+	\class SpscRing
+	Bounded ring buffer for exactly one producing and one consuming thread. Head and tail are only
+	written by their own side, so pushing and popping need no locks. A full ring blocks the
+	producer, which bounds the memory held between two pipeline stages.
+	*/
+	template <typename T>
+	class SpscRing {
+
+		std::vector<T> slots;
+		std::size_t mask;
+
+		alignas(64) std::atomic<std::size_t> head; /**< Next slot to pop, written by the consumer. */
+		alignas(64) std::atomic<std::size_t> tail; /**< Next slot to push, written by the producer. */
+
+		/**
+		Waits a little longer each time a side finds the ring full or empty, spinning first and
+		sleeping once the other side seems to be busy for a while.
+
+		\param attempt Number of failed attempts so far.
+		*/
+		static void Backoff(unsigned attempt) {
+			if (attempt < 64)
+				std::this_thread::yield();
+			else
+				std::this_thread::sleep_for(std::chrono::microseconds(50));
+		}
+
+	public:
+
+		/**
+		Creates a ring.
+
+		\param capacity Minimum number of elements held, rounded up to a power of two.
+		*/
+		explicit SpscRing(std::size_t capacity) : head(0), tail(0) {
+			std::size_t size = 2;
+			while (size < capacity)
+				size <<= 1;
+
+			slots.resize(size);
+			mask = size - 1;
+		}
+
+		SpscRing(const SpscRing&) = delete;
+		SpscRing &operator=(const SpscRing&) = delete;
+
+		/**
+		Pushes an element if the ring is not full. Called by the producer only.
+
+		\param value Element to move into the ring.
+		\return false if the ring is full, value is left untouched then.
+		*/
+		bool TryPush(T &value) {
+			auto t = tail.load(std::memory_order_relaxed);
+
+			if (t - head.load(std::memory_order_acquire) > mask)
+				return false;
+
+			slots[t & mask] = std::move(value);
+			tail.store(t + 1, std::memory_order_release);
+			return true;
+		}
+
+		/**
+		Pops an element if the ring is not empty. Called by the consumer only.
+
+		\param value Receives the element.
+		\return false if the ring is empty.
+		*/
+		bool TryPop(T &value) {
+			auto h = head.load(std::memory_order_relaxed);
+
+			if (h == tail.load(std::memory_order_acquire))
+				return false;
+
+			value = std::move(slots[h & mask]);
+			head.store(h + 1, std::memory_order_release);
+			return true;
+		}
+
+		/**
+		Pushes an element, waiting while the ring is full.
+
+		\param value Element to move into the ring.
+		*/
+		void Push(T &value) {
+			for (unsigned attempt = 0; !TryPush(value); attempt++)
+				Backoff(attempt);
+		}
+
+		/**
+		Pops an element, waiting while the ring is empty.
+
+		\param value Receives the element.
+		*/
+		void Pop(T &value) {
+			for (unsigned attempt = 0; !TryPop(value); attempt++)
+				Backoff(attempt);
+		}
+	};
+}
+
+#endif // SPSCRING_H
@@ -0,0 +1,316 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#include "StructuralCompare.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "Fingerprint.h"
+#include "Hash.h"
+
+/**
+\file StructuralCompare.cpp
+Implements StructuralCompare class.
+*/
+
+namespace lpcompare {
+
+	const std::size_t RefineGrain = 4096; /**< Rows or columns recolored per task. */
+
+	/**
+	Hashes a bound without its variable name.
+
+	\param bound Bound to hash.
+	\return 64-bit hash of the bound.
+	*/
+	static std::uint64_t hash_bound(const Bound &bound) {
+		auto h = HashCombine(NumberBits(bound.LB), static_cast<std::uint64_t>(NormalizeOp(bound.LB_Op)));
+		h = HashCombine(h, NumberBits(bound.UB));
+		return HashCombine(h, static_cast<std::uint64_t>(NormalizeOp(bound.UB_Op)));
+	}
+
+	/**
+	Assigns the initial colors: rows by sense, right-hand side and length, columns by bounds,
+	integrality and length.
+
+	\param model Model of the matrix.
+	\param matrix Constraint matrix.
+	\param colors Colors to initialize.
+	*/
+	void StructuralCompare::Seed(const LPModel &model, const SparseMatrix &matrix, Colors &colors) {
+
+		colors.Rows.resize(matrix.Rows());
+		colors.Columns.assign(matrix.Columns(), 0);
+
+		for (std::size_t r = 0; r < matrix.Rows(); r++) {
+			auto h = HashCombine(static_cast<std::uint64_t>(NormalizeOp(matrix.Senses[r])), NumberBits(matrix.RHS[r]));
+			colors.Rows[r] = HashCombine(h, matrix.RowStart[r + 1] - matrix.RowStart[r]);
+		}
+
+		// several bounds of a column are summed, so their order does not matter.
+		for (const auto &bound : model.Bounds)
+			colors.Columns[matrix.ColumnIds.at(bound.VarName)] += Mix64(hash_bound(bound));
+
+		for (const auto &name : model.Generals)
+			colors.Columns[matrix.ColumnIds.at(name)] += 0x1000193ULL;
+		for (const auto &name : model.Binaries)
+			colors.Columns[matrix.ColumnIds.at(name)] += 0x100000001b3ULL;
+
+		for (std::size_t c = 0; c < matrix.Columns(); c++)
+			colors.Columns[c] = HashCombine(colors.Columns[c], matrix.ColumnStart[c + 1] - matrix.ColumnStart[c]);
+	}
+
+	/**
+	Runs one round of refinement: every row is recolored by the multiset of its coefficients and
+	column colors, then every column by the multiset of its coefficients and new row colors.
+
+	\param matrix Constraint matrix.
+	\param colors Colors to refine.
+	*/
+	void StructuralCompare::Refine(const SparseMatrix &matrix, Colors &colors) {
+
+		std::vector<std::uint64_t> rows(colors.Rows.size());
+
+		pool.ParallelFor(matrix.Rows(), RefineGrain, [&](std::size_t begin, std::size_t end) {
+			for (auto r = begin; r < end; r++) {
+				std::uint64_t neighbours = 0;
+
+				for (auto k = matrix.RowStart[r]; k < matrix.RowStart[r + 1]; k++)
+					neighbours += Mix64(HashCombine(NumberBits(matrix.RowValues[k]), colors.Columns[matrix.RowColumns[k]]));
+
+				rows[r] = HashCombine(colors.Rows[r], neighbours);
+			}
+		});
+
+		colors.Rows.swap(rows);
+
+		std::vector<std::uint64_t> columns(colors.Columns.size());
+
+		pool.ParallelFor(matrix.Columns(), RefineGrain, [&](std::size_t begin, std::size_t end) {
+			for (auto c = begin; c < end; c++) {
+				std::uint64_t neighbours = 0;
+
+				for (auto k = matrix.ColumnStart[c]; k < matrix.ColumnStart[c + 1]; k++)
+					neighbours += Mix64(HashCombine(NumberBits(matrix.ColumnValues[k]), colors.Rows[matrix.ColumnRows[k]]));
+
+				columns[c] = HashCombine(colors.Columns[c], neighbours);
+			}
+		});
+
+		colors.Columns.swap(columns);
+	}
+
+	/**
+	Counts distinct colors.
+
+	\param colors Colors to count.
+	\return Number of distinct colors.
+	*/
+	std::size_t StructuralCompare::CountDistinct(const std::vector<std::uint64_t> &colors) {
+		auto sorted = colors;
+		std::sort(sorted.begin(), sorted.end());
+		return std::unique(sorted.begin(), sorted.end()) - sorted.begin();
+	}
+
+	/**
+	Matches elements of two models by their colors. Elements of a color are matched up to the
+	smaller of its counts in both models.
+
+	\param first Colors of the first model.
+	\param second Colors of the second model.
+	\param firstNames Names of the elements of the first model.
+	\param secondNames Names of the elements of the second model.
+	\param firstLeft Elements of the first model to match, replaced by the unmatched ones.
+	\param secondLeft Elements of the second model to match, replaced by the unmatched ones.
+	\param renamed Incremented for every one to one match with different names.
+	\return Number of matched elements.
+	*/
+	std::size_t StructuralCompare::Match(const std::vector<std::uint64_t> &first, const std::vector<std::uint64_t> &second,
+		const std::vector<std::string> &firstNames, const std::vector<std::string> &secondNames,
+		std::vector<std::size_t> &firstLeft, std::vector<std::size_t> &secondLeft, std::size_t &renamed) {
+
+		std::vector<std::pair<std::uint64_t, std::size_t>> own, other;
+
+		own.reserve(firstLeft.size());
+		for (auto i : firstLeft)
+			own.emplace_back(first[i], i);
+
+		other.reserve(secondLeft.size());
+		for (auto i : secondLeft)
+			other.emplace_back(second[i], i);
+
+		std::sort(own.begin(), own.end());
+		std::sort(other.begin(), other.end());
+
+		std::size_t matched = 0;
+		std::vector<std::size_t> firstUnmatched, secondUnmatched;
+		std::size_t i = 0, j = 0;
+
+		while (i < own.size() || j < other.size()) {
+
+			if (j == other.size() || (i < own.size() && own[i].first < other[j].first)) {
+				firstUnmatched.push_back(own[i++].second);
+				continue;
+			}
+
+			if (i == own.size() || other[j].first < own[i].first) {
+				secondUnmatched.push_back(other[j++].second);
+				continue;
+			}
+
+			auto color = own[i].first;
+			auto ownEnd = i, otherEnd = j;
+			while (ownEnd < own.size() && own[ownEnd].first == color)
+				ownEnd++;
+			while (otherEnd < other.size() && other[otherEnd].first == color)
+				otherEnd++;
+
+			auto count = std::min(ownEnd - i, otherEnd - j);
+			matched += count;
+
+			if (ownEnd - i == 1 && otherEnd - j == 1 && firstNames[own[i].second] != secondNames[other[j].second])
+				renamed++;
+
+			for (i += count; i < ownEnd; i++)
+				firstUnmatched.push_back(own[i].second);
+			for (j += count; j < otherEnd; j++)
+				secondUnmatched.push_back(other[j].second);
+		}
+
+		// keep unmatched elements in model order.
+		std::sort(firstUnmatched.begin(), firstUnmatched.end());
+		std::sort(secondUnmatched.begin(), secondUnmatched.end());
+		firstLeft.swap(firstUnmatched);
+		secondLeft.swap(secondUnmatched);
+
+		return matched;
+	}
+
+	/**
+	Matches elements of two models by their final colors, then the rest by their local colors.
+
+	\param first Final colors of the first model.
+	\param second Final colors of the second model.
+	\param firstLocal Colors of the first model after the first round.
+	\param secondLocal Colors of the second model after the first round.
+	\param firstNames Names of the elements of the first model.
+	\param secondNames Names of the elements of the second model.
+	\return Matching of the elements.
+	*/
+	StructuralMatch StructuralCompare::Match(const std::vector<std::uint64_t> &first, const std::vector<std::uint64_t> &second,
+		const std::vector<std::uint64_t> &firstLocal, const std::vector<std::uint64_t> &secondLocal,
+		const std::vector<std::string> &firstNames, const std::vector<std::string> &secondNames) {
+
+		StructuralMatch match;
+
+		std::vector<std::size_t> firstLeft(first.size()), secondLeft(second.size());
+		for (std::size_t i = 0; i < firstLeft.size(); i++)
+			firstLeft[i] = i;
+		for (std::size_t i = 0; i < secondLeft.size(); i++)
+			secondLeft[i] = i;
+
+		match.Matched = Match(first, second, firstNames, secondNames, firstLeft, secondLeft, match.Renamed);
+		match.MatchedLocally = Match(firstLocal, secondLocal, firstNames, secondNames, firstLeft, secondLeft, match.Renamed);
+
+		match.FirstExceptSecondCount = firstLeft.size();
+		match.SecondExceptFirstCount = secondLeft.size();
+
+		for (std::size_t i = 0; i < firstLeft.size() && i < MaxExamples; i++)
+			match.FirstExceptSecond.push_back(firstNames[firstLeft[i]]);
+		for (std::size_t i = 0; i < secondLeft.size() && i < MaxExamples; i++)
+			match.SecondExceptFirst.push_back(secondNames[secondLeft[i]]);
+
+		return match;
+	}
+
+	/**
+	Compares two models regardless of row and column names. SOS sections are not compared.
+
+	\param first First model.
+	\param second Second model.
+	\param maxRounds Refinement rounds to run at most.
+	\return Result of the comparison.
+	*/
+	StructuralResult StructuralCompare::Compare(const LPModel &first, const LPModel &second, unsigned maxRounds) {
+
+		SparseMatrix matrix1, matrix2;
+		Colors colors1, colors2;
+
+		pool.ParallelFor(2, 1, [&](std::size_t begin, std::size_t) {
+			if (begin == 0) {
+				matrix1.Build(first, &pool);
+				Seed(first, matrix1, colors1);
+			}
+			else {
+				matrix2.Build(second, &pool);
+				Seed(second, matrix2, colors2);
+			}
+		});
+
+		auto classes = [](const Colors &colors) {
+			return CountDistinct(colors.Rows) + CountDistinct(colors.Columns);
+		};
+
+		StructuralResult result;
+		Colors local1, local2;
+		auto classes1 = classes(colors1);
+		auto classes2 = classes(colors2);
+
+		// both models get the same number of rounds, so that equal structures get equal colors.
+		while (result.Rounds < maxRounds) {
+			Refine(matrix1, colors1);
+			Refine(matrix2, colors2);
+			result.Rounds++;
+
+			if (result.Rounds == 1) {
+				local1 = colors1;
+				local2 = colors2;
+			}
+
+			auto refined1 = classes(colors1);
+			auto refined2 = classes(colors2);
+
+			if (refined1 == classes1 && refined2 == classes2)
+				break;
+
+			classes1 = refined1;
+			classes2 = refined2;
+		}
+
+		if (result.Rounds == 0) {
+			local1 = colors1;
+			local2 = colors2;
+		}
+
+		result.Rows = Match(colors1.Rows, colors2.Rows, local1.Rows, local2.Rows, matrix1.RowNames, matrix2.RowNames);
+		result.Columns = Match(colors1.Columns, colors2.Columns, local1.Columns, local2.Columns, matrix1.ColumnNames, matrix2.ColumnNames);
+
+		result.Identical = result.Rows.Matched == matrix1.Rows() && result.Rows.Matched == matrix2.Rows()
+			&& result.Columns.Matched == matrix1.Columns() && result.Columns.Matched == matrix2.Columns();
+
+		return result;
+	}
+}
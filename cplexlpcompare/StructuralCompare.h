@@ -0,0 +1,111 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef STRUCTURALCOMPARE_H
+#define STRUCTURALCOMPARE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "LPModel.h"
+#include "SparseMatrix.h"
+#include "ThreadPool.h"
+
+/**
+\file StructuralCompare.h
+Defines the comparison of models regardless of row and column names.
+*/
+
+namespace lpcompare {
+
+	/**
+	\class StructuralMatch
+	Rows or columns of two models matched by their refined colors.
+	*/
+	class StructuralMatch {
+	public:
+		std::size_t Matched = 0;
+		std::size_t MatchedLocally = 0; /**< Matched only by their colors after the first round. */
+		std::size_t Renamed = 0; /**< Matched one to one but named differently. */
+		std::size_t FirstExceptSecondCount = 0;
+		std::size_t SecondExceptFirstCount = 0;
+		std::vector<std::string> FirstExceptSecond; /**< Names of some unmatched elements of the first model. */
+		std::vector<std::string> SecondExceptFirst; /**< Names of some unmatched elements of the second model. */
+	};
+
+	/**
+	\class StructuralResult
+	Result of a structural comparison.
+	*/
+	class StructuralResult {
+	public:
+		unsigned Rounds = 0;
+		bool Identical = false; /**< Models cannot be told apart by color refinement. */
+		StructuralMatch Rows;
+		StructuralMatch Columns;
+	};
+
+	/**
+	\class StructuralCompare
+	Compares models up to renaming of rows and columns by color refinement (1-dimensional
+	Weisfeiler-Lehman) over the bipartite graph of rows and columns. Rows are colored by sense and
+	right-hand side, columns by bounds and integrality, then every round recolors each row by the
+	multiset of its coefficients and column colors and each column likewise, until the partitions
+	of both models stop splitting. Elements left unmatched by their final colors are matched by
+	their colors after the first round, which only depend on their immediate neighbourhood.
+	*/
+	class StructuralCompare {
+
+		ThreadPool &pool;
+
+		struct Colors {
+			std::vector<std::uint64_t> Rows;
+			std::vector<std::uint64_t> Columns;
+		};
+
+		void Seed(const LPModel &model, const SparseMatrix &matrix, Colors &colors);
+		void Refine(const SparseMatrix &matrix, Colors &colors);
+
+		static std::size_t CountDistinct(const std::vector<std::uint64_t> &colors);
+		static std::size_t Match(const std::vector<std::uint64_t> &first, const std::vector<std::uint64_t> &second,
+			const std::vector<std::string> &firstNames, const std::vector<std::string> &secondNames,
+			std::vector<std::size_t> &firstLeft, std::vector<std::size_t> &secondLeft, std::size_t &renamed);
+		static StructuralMatch Match(const std::vector<std::uint64_t> &first, const std::vector<std::uint64_t> &second,
+			const std::vector<std::uint64_t> &firstLocal, const std::vector<std::uint64_t> &secondLocal,
+			const std::vector<std::string> &firstNames, const std::vector<std::string> &secondNames);
+
+	public:
+
+		static const std::size_t MaxExamples = 10;
+
+		explicit StructuralCompare(ThreadPool &pool) : pool(pool) {}
+
+		StructuralResult Compare(const LPModel &first, const LPModel &second, unsigned maxRounds = 100);
+	};
+}
+
+#endif // STRUCTURALCOMPARE_H
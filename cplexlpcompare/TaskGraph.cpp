@@ -0,0 +1,112 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#include "TaskGraph.h"
+
+#include "HwCounters.h"
+
+/**
+\file TaskGraph.cpp
+Implements TaskGraph class.
+*/
+
+namespace lpcompare {
+
+	/**
+	Adds a task. Tasks must be added before Run, and only depend on tasks added before them.
+
+	\param task Task to run.
+	\param dependencies Tasks that must finish before this one starts.
+	\return Id of the task, to be used as a dependency of later tasks.
+	*/
+	std::size_t TaskGraph::Add(std::function<void()> task, std::initializer_list<std::size_t> dependencies) {
+
+		auto id = nodes.size();
+
+		nodes.emplace_back();
+		nodes.back().Task = std::move(task);
+		nodes.back().Waiting = dependencies.size();
+
+		for (auto dependency : dependencies)
+			nodes[dependency].Dependents.push_back(id);
+
+		return id;
+	}
+
+	/**
+	Queues a task whose dependencies have finished. Once it has run, its dependents that no longer
+	wait for other tasks are queued in turn.
+
+	\param node Id of the task.
+	*/
+	void TaskGraph::Start(std::size_t node) {
+
+		pool.Enqueue([this, node]() {
+
+			nodes[node].Task();
+
+			std::vector<std::size_t> ready;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+
+				for (auto dependent : nodes[node].Dependents)
+					if (--nodes[dependent].Waiting == 0)
+						ready.push_back(dependent);
+
+				// Run may return and destroy the graph as soon as the lock is released, the
+				// last task must not touch it afterwards.
+				if (--remaining == 0) {
+					finished.notify_all();
+					return;
+				}
+			}
+
+			for (auto dependent : ready)
+				Start(dependent);
+		});
+	}
+
+	/**
+	Runs all tasks and blocks until they have finished. Must not be called from a task of the pool.
+	*/
+	void TaskGraph::Run() {
+
+		std::vector<std::size_t> ready;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			remaining = nodes.size();
+
+			for (std::size_t i = 0; i < nodes.size(); i++)
+				if (nodes[i].Waiting == 0)
+					ready.push_back(i);
+		}
+
+		for (auto node : ready)
+			Start(node);
+
+		std::unique_lock<std::mutex> lock(mutex);
+		finished.wait(lock, [this] { return remaining == 0; });
+	}
+}
@@ -0,0 +1,72 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef TASKGRAPH_H
+#define TASKGRAPH_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <vector>
+
+#include "ThreadPool.h"
+
+namespace lpcompare {
+
+	/**
+	\class TaskGraph
+	Runs tasks on a ThreadPool in the order given by their dependencies. A task is queued as soon
+	as every task it depends on has finished, so independent chains of tasks run concurrently.
+	*/
+	class TaskGraph {
+
+		struct Node {
+			std::function<void()> Task;
+			std::vector<std::size_t> Dependents;
+			std::size_t Waiting = 0; /**< Dependencies not finished yet. */
+		};
+
+		ThreadPool &pool;
+		std::vector<Node> nodes;
+		std::mutex mutex;
+		std::condition_variable finished;
+		std::size_t remaining = 0;
+
+		void Start(std::size_t node);
+
+	public:
+		explicit TaskGraph(ThreadPool &pool) : pool(pool) {}
+
+		TaskGraph(const TaskGraph&) = delete;
+		TaskGraph& operator=(const TaskGraph&) = delete;
+
+		std::size_t Add(std::function<void()> task, std::initializer_list<std::size_t> dependencies = {});
+		void Run();
+	};
+}
+
+#endif // TASKGRAPH_H
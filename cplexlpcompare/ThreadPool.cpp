@@ -0,0 +1,273 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+
+#include "HwCounters.h"
+
+/**
+\file ThreadPool.cpp
+Implements ThreadPool class.
+*/
+
+namespace lpcompare {
+
+	thread_local ThreadPool *current_pool = nullptr; /**< Pool of the calling worker thread. */
+	thread_local unsigned current_worker = 0; /**< Index of the calling worker thread in its pool. */
+
+	/**
+	Starts the worker threads.
+
+	\param threads Number of workers, 0 for one per hardware thread.
+	*/
+	ThreadPool::ThreadPool(unsigned threads) : queued(0), pending(0), nextQueue(0) {
+
+		if (threads == 0)
+			threads = DefaultThreads();
+
+		for (unsigned i = 0; i < threads; i++)
+			queues.emplace_back(new WorkerQueue());
+
+		for (unsigned i = 0; i < threads; i++)
+			workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+	}
+
+	/**
+	Waits for queued tasks to finish and joins the worker threads.
+	*/
+	ThreadPool::~ThreadPool() {
+
+		Wait();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		taskAvailable.notify_all();
+
+		for (auto &worker : workers)
+			worker.join();
+	}
+
+	/**
+	Queues a task to be run by a worker thread. Tasks may queue further tasks. An exception escaping
+	a task is reported on std::cerr and the worker goes on with the next task.
+
+	\param task Task to run.
+	*/
+	void ThreadPool::Enqueue(std::function<void()> task) {
+
+		auto index = current_pool == this
+			? current_worker
+			: static_cast<unsigned>(nextQueue++ % queues.size());
+
+		pending++;
+
+		// counted before it can be taken, so that queued never drops below the tasks in the deques.
+		{
+			std::lock_guard<std::mutex> lock(queues[index]->mutex);
+			queued++;
+			queues[index]->tasks.push_back(std::move(task));
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+		}
+		taskAvailable.notify_one();
+	}
+
+	/**
+	Blocks until all queued tasks have finished. Must not be called from a task.
+	*/
+	void ThreadPool::Wait() {
+		std::unique_lock<std::mutex> lock(mutex);
+		allDone.wait(lock, [this] { return pending == 0; });
+	}
+
+	/**
+	Shared state of a ParallelFor call, owned jointly by the caller and its helper tasks.
+	*/
+	struct ParallelForState {
+		std::atomic<std::size_t> next{ 0 }; /**< Next chunk to claim. */
+		std::atomic<std::size_t> done{ 0 }; /**< Chunks finished. */
+		std::size_t chunks;
+		std::size_t count;
+		std::size_t grain;
+		std::function<void(std::size_t, std::size_t)> body;
+		std::exception_ptr error; /**< First exception thrown by a chunk, guarded by mutex. */
+		std::mutex mutex;
+		std::condition_variable finished;
+
+		/**
+		Claims and runs chunks until none is left. A chunk that throws still counts as finished.
+		*/
+		void Run() {
+			std::size_t chunk;
+
+			while ((chunk = next++) < chunks) {
+				auto begin = chunk * grain;
+
+				try {
+					body(begin, std::min(begin + grain, count));
+				}
+				catch (...) {
+					std::lock_guard<std::mutex> lock(mutex);
+					if (!error)
+						error = std::current_exception();
+				}
+
+				if (++done == chunks) {
+					std::lock_guard<std::mutex> lock(mutex);
+					finished.notify_all();
+				}
+			}
+		}
+	};
+
+	/**
+	Runs a loop over [0, count) in chunks on the workers. The calling thread runs chunks too and
+	returns once every chunk has finished, so it may be called from a task of the pool. The first
+	exception thrown by a chunk is rethrown to the caller then.
+
+	\param count Number of iterations.
+	\param grain Iterations per chunk.
+	\param body Function called with the begin and end of each chunk.
+	*/
+	void ThreadPool::ParallelFor(std::size_t count, std::size_t grain, std::function<void(std::size_t, std::size_t)> body) {
+
+		if (count == 0)
+			return;
+
+		auto state = std::make_shared<ParallelForState>();
+		state->grain = std::max<std::size_t>(grain, 1);
+		state->count = count;
+		state->chunks = (count + state->grain - 1) / state->grain;
+		state->body = std::move(body);
+
+		auto helpers = std::min<std::size_t>(Size(), state->chunks - 1);
+		for (std::size_t i = 0; i < helpers; i++)
+			Enqueue([state]() { state->Run(); });
+
+		state->Run();
+
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->finished.wait(lock, [&state] { return state->done == state->chunks; });
+
+		if (state->error)
+			std::rethrow_exception(state->error);
+	}
+
+	/**
+	Takes the newest task of a worker's own deque, or steals the oldest task of another worker.
+
+	\param index Index of the worker.
+	\param task Task taken.
+	\return false if all deques are empty.
+	*/
+	bool ThreadPool::TryPop(unsigned index, std::function<void()> &task) {
+
+		{
+			auto &own = *queues[index];
+			std::lock_guard<std::mutex> lock(own.mutex);
+
+			if (!own.tasks.empty()) {
+				task = std::move(own.tasks.back());
+				own.tasks.pop_back();
+				queued--;
+				return true;
+			}
+		}
+
+		for (std::size_t i = 1; i < queues.size(); i++) {
+			auto &victim = *queues[(index + i) % queues.size()];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+
+			if (!victim.tasks.empty()) {
+				task = std::move(victim.tasks.front());
+				victim.tasks.pop_front();
+				queued--;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	Runs tasks until the pool is stopped.
+
+	\param index Index of the worker.
+	*/
+	void ThreadPool::WorkerLoop(unsigned index) {
+
+		current_pool = this;
+		current_worker = index;
+
+		for (;;) {
+			std::function<void()> task;
+
+			if (TryPop(index, task)) {
+
+				try {
+					HwScope counters;
+					task();
+				}
+				catch (std::exception &e) {
+					std::cerr << "Error: task failed: " << e.what() << std::endl;
+				}
+				catch (...) {
+					std::cerr << "Error: task failed" << std::endl;
+				}
+
+				if (--pending == 0) {
+					std::lock_guard<std::mutex> lock(mutex);
+					allDone.notify_all();
+				}
+
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(mutex);
+			taskAvailable.wait(lock, [this] { return stopping || queued > 0; });
+
+			if (stopping && queued == 0)
+				return;
+		}
+	}
+
+	/**
+	Finds the number of worker threads to use when none is given.
+
+	\return Number of hardware threads, at least 1.
+	*/
+	unsigned ThreadPool::DefaultThreads() {
+		auto threads = std::thread::hardware_concurrency();
+		return threads > 0 ? threads : 1;
+	}
+}
@@ -0,0 +1,115 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lpcompare {
+
+	/**
+	\class ThreadPool
+	Fixed size pool of worker threads with work stealing. Every worker owns a task deque; tasks queued
+	from a worker go to its own deque and are run newest first, idle workers steal the oldest tasks
+	of other workers. Tasks queued from other threads are spread over the deques round robin.
+	*/
+	class ThreadPool {
+
+		struct WorkerQueue {
+			std::mutex mutex;
+			std::deque<std::function<void()>> tasks;
+		};
+
+		std::vector<std::thread> workers;
+		std::vector<std::unique_ptr<WorkerQueue>> queues;
+		std::mutex mutex;
+		std::condition_variable taskAvailable;
+		std::condition_variable allDone;
+		std::atomic<std::size_t> queued; /**< Tasks waiting in the deques. */
+		std::atomic<std::size_t> pending; /**< Tasks queued or running. */
+		std::atomic<std::size_t> nextQueue;
+		bool stopping = false;
+
+		bool TryPop(unsigned index, std::function<void()> &task);
+		void WorkerLoop(unsigned index);
+
+	public:
+
+		explicit ThreadPool(unsigned threads = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		void Enqueue(std::function<void()> task);
+		void Wait();
+
+		void ParallelFor(std::size_t count, std::size_t grain, std::function<void(std::size_t, std::size_t)> body);
+
+		unsigned Size() const { return static_cast<unsigned>(workers.size()); }
+
+		static unsigned DefaultThreads();
+	};
+
+	/**
+	\class Semaphore
+	Counting semaphore used to bound the number of concurrently held resources.
+	*/
+	class Semaphore {
+
+		std::mutex mutex;
+		std::condition_variable released;
+		std::size_t count;
+
+	public:
+
+		explicit Semaphore(std::size_t count) : count(count) {}
+
+		void Acquire() {
+			std::unique_lock<std::mutex> lock(mutex);
+			released.wait(lock, [this] { return count > 0; });
+			count--;
+		}
+
+		void Release() {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				count++;
+			}
+			released.notify_one();
+		}
+	};
+}
+
+#endif // THREADPOOL_H
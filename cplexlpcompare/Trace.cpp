@@ -0,0 +1,161 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#include "Trace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "AsyncFileWriter.h"
+
+/**
+\file Trace.cpp
+Implements Trace class.
+*/
+
+using std::cout;
+
+namespace lpcompare {
+
+	std::atomic<bool> Trace::enabled(false);
+
+	/**
+	Span recorded by a thread, times in nanoseconds since the trace was enabled.
+	*/
+	struct TraceEvent {
+		const char *Name;
+		const char *Category;
+		std::uint64_t Start;
+		std::uint64_t End;
+		const char *CountName;
+		std::uint64_t Count;
+	};
+
+	/**
+	Spans of one thread. Buffers are owned by the trace and outlive their threads.
+	*/
+	struct TraceBuffer {
+		std::size_t ThreadId;
+		std::vector<TraceEvent> Events;
+	};
+
+	static std::mutex buffers_mutex;
+	static std::vector<std::unique_ptr<TraceBuffer>> buffers;
+	static std::chrono::steady_clock::time_point trace_start;
+	static thread_local TraceBuffer *thread_buffer = nullptr;
+
+	/**
+	Starts recording spans.
+	*/
+	void Trace::Enable() {
+		trace_start = std::chrono::steady_clock::now();
+		enabled = true;
+	}
+
+	/**
+	\return Nanoseconds since the trace was enabled.
+	*/
+	std::uint64_t Trace::Now() {
+		return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - trace_start).count());
+	}
+
+	/**
+	Records a span in the buffer of the calling thread.
+
+	\param name Name of the span.
+	\param category Category of the span.
+	\param start Start of the span, see Now.
+	\param end End of the span, see Now.
+	\param countName Name of the count, nullptr if the span has none.
+	\param count Count of bytes or elements handled in the span.
+	*/
+	void Trace::Record(const char *name, const char *category, std::uint64_t start, std::uint64_t end,
+		const char *countName, std::uint64_t count) {
+
+		if (thread_buffer == nullptr) {
+			std::lock_guard<std::mutex> lock(buffers_mutex);
+			buffers.emplace_back(new TraceBuffer());
+			thread_buffer = buffers.back().get();
+			thread_buffer->ThreadId = buffers.size();
+		}
+
+		thread_buffer->Events.push_back({ name, category, start, end, countName, count });
+	}
+
+	/**
+	Writes the recorded spans as a Chrome trace event JSON file of complete events. Threads must
+	not record spans while the trace is written.
+
+	\param filename Path of the JSON file.
+	\return false if the file cannot be written.
+	*/
+	bool Trace::Write(const std::string &filename) {
+
+		AsyncFileWriter writer;
+
+		if (!writer.Open(filename, false)) {
+			cout << "Cannot open or create file for writing: " << filename << std::endl;
+			return false;
+		}
+
+		std::lock_guard<std::mutex> lock(buffers_mutex);
+
+		char event[512];
+		bool first = true;
+
+		writer.Write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+		for (const auto &buffer : buffers) {
+			for (const auto &e : buffer->Events) {
+				int length = std::snprintf(event, sizeof(event),
+					"%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f",
+					first ? "" : ",\n", e.Name, e.Category, buffer->ThreadId, e.Start / 1000.0, (e.End - e.Start) / 1000.0);
+				writer.Write(event, static_cast<std::size_t>(length));
+
+				if (e.CountName != nullptr) {
+					length = std::snprintf(event, sizeof(event), ",\"args\":{\"%s\":%llu}", e.CountName, static_cast<unsigned long long>(e.Count));
+					writer.Write(event, static_cast<std::size_t>(length));
+				}
+
+				writer.Write("}", 1);
+				first = false;
+			}
+		}
+
+		writer.Write("\n]}\n");
+
+		if (!writer.Close()) {
+			cout << "Cannot write file: " << filename << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,102 @@
+// Copyright (c) 2014 Kerem KAT 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files(the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// 
+// Do not hesisate to contact me about usage of the code or to make comments 
+// about the code. Your feedback will be appreciated.
+//
+// http://dissipatedheat.com/
+// http://github.com/krk/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace lpcompare {
+
+	/**
+	\class Trace
+	Records spans of work as Chrome trace events, so that a run can be opened in a trace viewer
+	such as chrome://tracing or Perfetto. Every thread records into its own buffer, buffers are only
+	registered under a lock when a thread records its first span. While tracing is not enabled a
+	TraceSpan only tests a flag.
+	*/
+	class Trace {
+		static std::atomic<bool> enabled;
+
+	public:
+		static void Enable();
+
+		/**
+		\return true if spans are recorded.
+		*/
+		static bool IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+		static std::uint64_t Now();
+		static void Record(const char *name, const char *category, std::uint64_t start, std::uint64_t end,
+			const char *countName, std::uint64_t count);
+		static bool Write(const std::string &filename);
+	};
+
+	/**
+	\class TraceSpan
+	Records the lifetime of a scope on the calling thread as a span, with an optional count of the
+	bytes or elements handled. Names are not copied and must outlive the trace, e.g. literals.
+	*/
+	class TraceSpan {
+		const char *name;
+		const char *category;
+		const char *countName = nullptr;
+		std::uint64_t count = 0;
+		std::uint64_t start = 0;
+		bool active;
+
+	public:
+		TraceSpan(const char *name, const char *category)
+			: name(name), category(category), active(Trace::IsEnabled())
+		{
+			if (active)
+				start = Trace::Now();
+		}
+
+		~TraceSpan() {
+			if (active)
+				Trace::Record(name, category, start, Trace::Now(), countName, count);
+		}
+
+		TraceSpan(const TraceSpan&) = delete;
+		TraceSpan& operator=(const TraceSpan&) = delete;
+
+		/**
+		Sets the count shown with the span.
+
+		\param name Name of the count, e.g. bytes or rows.
+		\param value Count.
+		*/
+		void SetCount(const char *name, std::uint64_t value) {
+			countName = name;
+			count = value;
+		}
+	};
+}
+
+#endif // TRACE_H
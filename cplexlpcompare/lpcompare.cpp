@@ -24,11 +24,45 @@
 // http://github.com/krk/
 
 #include <vector>
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <mutex>
+#include <set>
+#include <sstream>
 #include "LPModel.h"
-#include <boost/range/algorithm/set_algorithm.hpp>
+#include "LPCompare.h"
+#include "ThreadPool.h"
+#include "CompareServer.h"
+#include "LazyReader.h"
+#include "ManifestCompare.h"
+#include "ModelPatch.h"
+#include "Fingerprint.h"
+#include "StructuralCompare.h"
+#include "ColumnReport.h"
+#include "CompactModel.h"
+#include "DiffSummary.h"
+#include "ShardCompare.h"
+#include "CanonicalWriter.h"
+#include "MpsReader.h"
+#include "HwCounters.h"
+#include "Trace.h"
+#include "TaskGraph.h"
+#include "ModelAnalysis.h"
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
 #include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/file_descriptor.hpp>
+#include <boost/iostreams/stream.hpp>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#define fileno _fileno
+#endif
 
 #include "Constraint.h"
 #include "Term.h"
@@ -51,30 +85,84 @@
 #define STOP_TIMER_SEC() (0)
 #endif
 
+#define START_HW_PHASE(phase) lpcompare::HwCounters::BeginPhase(phase)
+#define STOP_HW_PHASE() lpcompare::HwCounters::EndPhase(cout)
+
 using std::cout;
 using std::endl;
 using lpcompare::LPModel;
+using lpcompare::SectionDiff;
 
 /**
 \file lpcompare.cpp
-Handles command line arguments and has the main method.
+Handles command line arguments and has the main method. Comparison itself is done by liblpcompare.
 */
 
 namespace po = boost::program_options;
 
 template <typename T>
-void printCounts(const std::string detail_name, std::vector<T> &vec, std::vector<T> &vecother);
+SectionDiff<T> printCounts(const std::string detail_name, std::vector<T> &vec, std::vector<T> &vecother, std::size_t matched = 0);
+
+template <typename T>
+SectionDiff<T> compareCounts(const std::string &detail_name, std::vector<T> &vec, std::vector<T> &vecother, std::size_t matched, std::ostream &out);
 
-void printStats(LPModel *model);
+void printStats(LPModel *model, std::ostream &out = cout);
 
 template <typename T>
-void dumpdiff_if_requested(const std::string &detail_name, const std::vector<T> &set1Except2, const std::vector<T> &set2Except1);
+void dumpdiff_if_requested(const std::string &detail_name, const SectionDiff<T> &diff, std::ostream &log = cout);
+
+lpcompare::CompareResult compare_task_graph(LPModel &model1, LPModel &model2, const lpcompare::LazyMatch &lazy_match);
+
+int compare_with_baseline();
+
+int compare_manifest();
+
+int compare_quick();
+
+int compare_structural();
+
+int compare_compact();
+
+int compare_sharded();
+
+std::string shell_quote(const std::string &argument);
+
+int run_worker(int argc, char *argv []);
+
+void write_patch_if_requested(const lpcompare::CompareResult &result);
+
+int run_serve(int argc, char *argv []);
 
+int run_request(int argc, char *argv []);
+
+int run_apply(int argc, char *argv []);
+
+int run_fingerprint(int argc, char *argv []);
+
+int run_compare_fp(int argc, char *argv []);
+
+int run_canonicalize(int argc, char *argv []);
+
+int run_analyze(int argc, char *argv []);
+
+void write_trace();
+
+bool is_lazy_requested();
+
+std::string program_path; /**< Path this program was started with, runs shard workers. */
 std::string first_filename;  /**< Filename of the first LP model. */
 std::string second_filename; /**< Filename of the second LP model. */
+std::string baseline_filename; /**< Filename of the baseline LP model, compared to every candidate. */
+std::vector<std::string> candidate_filenames; /**< Filenames of the candidate LP models. */
 
 po::variables_map vm; /**< Variable map for boost::program_options. */
 
+lpcompare::DumpOptions dump_options; /**< Format and compression of difference dumps. */
+
+lpcompare::NameGrouper name_grouper; /**< Groups differences by name with --summarize. */
+
+lpcompare::DiffLimit diff_limit; /**< Bounds differences collected per section with --max-diffs or --sample-diffs. */
+
 /**
 Parses program arguments using boost program_options.
 
@@ -86,14 +174,44 @@ void setup_options(int argc, char *argv []) {
 	po::positional_options_description p;
 	p.add("first", 1);
 	p.add("second", 1);
+	p.add("candidates", -1);
 
 	po::options_description desc("Usage");
 	desc.add_options()
 		("help", "show usage information")
-		("first", po::value<std::string>(&first_filename)->required(), "model 1 cplex lp file")
-		("second", po::value<std::string>(&second_filename)->required(), "model 2 cplex lp file")
+		("first", po::value<std::string>(&first_filename), "model 1 cplex lp file")
+		("second", po::value<std::string>(&second_filename), "model 2 cplex lp file")
 		("dump-prefix", po::value<std::string>()->default_value("diffdump"), "filename prefix for difference dumps")
 		("dump-diffs", po::value<bool>()->default_value(true), "filename prefix for difference dumps")
+		("dump-format", po::value<std::string>()->default_value("text"), "format of difference dumps: text, jsonl or binary")
+		("dump-compress", "compress difference dumps with zstd")
+		("dump-source", "write the original text of differing bounds and constraints to text and jsonl dumps, read again from the model files")
+		("baseline", po::value<std::string>(&baseline_filename), "baseline cplex lp file, compared to every candidate")
+		("candidates", po::value<std::vector<std::string>>(&candidate_filenames)->multitoken(), "candidate cplex lp files for --baseline")
+		("threads", po::value<unsigned>()->default_value(0), "worker threads, 0 for one per hardware thread")
+		("max-loaded", po::value<unsigned>()->default_value(0), "candidates held in memory at once, 0 for one per thread")
+		("manifest", po::value<std::string>(), "file listing pairs of cplex lp files to compare, one pair per line")
+		("memory-budget-mb", po::value<std::size_t>()->default_value(0), "estimated memory of pairs compared at once with --manifest, 0 for one pair per thread")
+		("patch-out", po::value<std::string>(), "write a patch turning the first model into the second")
+		("quick", "only check whether sections are equal, in one pass and constant memory")
+		("structural", "compare models regardless of row and column names")
+		("canonical", "compare constraints in canonical form, equal up to a positive or negative factor")
+		("column-report", po::value<std::string>(), "write the changes of every variable to a tab separated file")
+		("summarize", "print differences grouped by name, change kind and term count instead of dumping them")
+		("group-regex", po::value<std::string>(), "regex whose first capture groups names with --summarize, the prefix before the first index by default")
+		("compact", "hold constraints encoded with shared column and coefficient dictionaries, for models with very many nonzeros")
+		("shards", po::value<unsigned>(), "partition both models into N shards compared by worker processes")
+		("worker-command", po::value<std::string>(), "command running a shard worker, given the two shard files; lpcompare worker by default")
+		("shard-dir", po::value<std::string>(), "directory for shard files, shared with the workers; a temporary directory by default")
+		("lazy", "only parse bounds and constraints whose text does not occur in the other model")
+		("aligned", "read lazily, matching rows of models written in the same order in one pass; byte-identical files are not read")
+		("lookahead", po::value<std::size_t>()->default_value(1024), "rows searched ahead to resynchronize diverging models with --aligned")
+		("parse-threads", po::value<unsigned>()->default_value(0), "parse models on N threads while another thread reads them, 0 to read and parse on one thread")
+		("max-diffs", po::value<std::size_t>(), "collect and dump at most N differences per section and side, still counting all")
+		("sample-diffs", po::value<std::size_t>(), "collect and dump a uniform random sample of N differences per section and side")
+		("hw-counters", "count cycles, instructions, cache and branch misses and page faults of each phase with perf_event_open")
+		("trace", po::value<std::string>(), "write a timeline of reading, sorting, diffing and dumping on every thread to a Chrome trace event JSON file")
+		("task-graph", "read, sort, diff and dump sections as dependent tasks on --threads threads, the report is printed in the usual order")
 		;
 
 	try
@@ -108,13 +226,162 @@ void setup_options(int argc, char *argv []) {
 
 		po::notify(vm);
 	}
-	catch (po::required_option& e)
+	catch (po::error& e)
 	{
 		std::cerr << "Error: " << e.what() << std::endl << std::endl;
 
 		cout << desc << "\n";
 		exit(1);
 	}
+
+	if (!lpcompare::ParseDumpFormat(vm["dump-format"].as<std::string>(), dump_options.Format)) {
+		std::cerr << "Error: unknown dump format " << vm["dump-format"].as<std::string>() << std::endl << std::endl;
+		cout << desc << "\n";
+		exit(1);
+	}
+
+	dump_options.Compress = vm.count("dump-compress") > 0;
+
+	if (vm.count("dump-source")) {
+		dump_options.FirstSource = vm.count("baseline") ? baseline_filename : first_filename;
+		dump_options.SecondSource = second_filename;
+	}
+
+	if (vm.count("summarize")) {
+		if (vm.count("patch-out")) {
+			std::cerr << "Error: --summarize cannot be combined with --patch-out" << std::endl;
+			exit(1);
+		}
+
+		if (vm.count("group-regex")) {
+			try {
+				name_grouper = lpcompare::NameGrouper(vm["group-regex"].as<std::string>());
+			}
+			catch (const boost::regex_error &e) {
+				std::cerr << "Error: invalid --group-regex: " << e.what() << std::endl;
+				exit(1);
+			}
+		}
+	}
+
+	if (vm.count("patch-out") && (vm.count("baseline") || vm.count("manifest") || vm.count("quick") || vm.count("structural") || vm.count("canonical"))) {
+		std::cerr << "Error: --patch-out cannot be combined with --baseline, --manifest, --quick, --structural or --canonical" << std::endl;
+		exit(1);
+	}
+
+	if (vm.count("quick") || vm.count("structural")) {
+		const char *mode = vm.count("quick") ? "--quick" : "--structural";
+
+		if (vm.count("quick") && vm.count("structural")) {
+			std::cerr << "Error: --quick cannot be combined with --structural" << std::endl;
+			exit(1);
+		}
+
+		// neither mode collects differences, they only print counts.
+		for (auto option : { "column-report", "summarize", "lazy", "aligned", "max-diffs", "sample-diffs", "task-graph", "compact", "shards", "dump-source" }) {
+			if (vm.count(option)) {
+				std::cerr << "Error: " << mode << " cannot be combined with --" << option << std::endl;
+				exit(1);
+			}
+		}
+	}
+
+	if (vm.count("shards") && (vm.count("compact") || is_lazy_requested() || vm.count("column-report"))) {
+		std::cerr << "Error: --shards cannot be combined with --compact, --lazy, --aligned or --column-report" << std::endl;
+		exit(1);
+	}
+
+	if (vm.count("shards") && vm["shards"].as<unsigned>() == 0) {
+		std::cerr << "Error: --shards requires a positive count" << std::endl;
+		exit(1);
+	}
+
+	if (vm.count("compact") && (is_lazy_requested() || vm.count("column-report"))) {
+		std::cerr << "Error: --compact cannot be combined with --lazy, --aligned or --column-report" << std::endl;
+		exit(1);
+	}
+
+	if (is_lazy_requested() && vm.count("column-report")) {
+		std::cerr << "Error: --column-report needs every row, it cannot be combined with --lazy or --aligned" << std::endl;
+		exit(1);
+	}
+
+	if (vm.count("max-diffs") || vm.count("sample-diffs")) {
+		if (vm.count("max-diffs") && vm.count("sample-diffs")) {
+			std::cerr << "Error: --max-diffs cannot be combined with --sample-diffs" << std::endl;
+			exit(1);
+		}
+
+		if (vm.count("patch-out")) {
+			std::cerr << "Error: a patch needs every difference, --max-diffs and --sample-diffs cannot be combined with --patch-out" << std::endl;
+			exit(1);
+		}
+
+		diff_limit.Sample = vm.count("sample-diffs") > 0;
+		diff_limit.MaxDiffs = vm[diff_limit.Sample ? "sample-diffs" : "max-diffs"].as<std::size_t>();
+
+		if (diff_limit.MaxDiffs == 0) {
+			std::cerr << "Error: --max-diffs and --sample-diffs require a positive count" << std::endl;
+			exit(1);
+		}
+	}
+
+	if (dump_options.Compress && !lpcompare::AsyncFileWriter::CompressionAvailable()) {
+		std::cerr << "Error: zstd compression is not available in this build" << std::endl;
+		exit(1);
+	}
+
+	if (vm.count("trace")) {
+		lpcompare::Trace::Enable();
+		std::atexit(write_trace);
+	}
+
+	if (vm.count("hw-counters")) {
+		std::string error;
+		if (!lpcompare::HwCounters::Enable(error))
+			std::cerr << "Warning: hardware counters are not available: " << error << std::endl;
+	}
+
+	if (vm.count("baseline")) {
+		// positional arguments are all candidates in baseline mode.
+		std::vector<std::string> candidates;
+
+		if (!first_filename.empty())
+			candidates.push_back(first_filename);
+		if (!second_filename.empty())
+			candidates.push_back(second_filename);
+
+		candidates.insert(candidates.end(), candidate_filenames.begin(), candidate_filenames.end());
+		candidate_filenames.swap(candidates);
+
+		if (candidate_filenames.empty()) {
+			std::cerr << "Error: --baseline requires at least one candidate model" << std::endl << std::endl;
+			cout << desc << "\n";
+			exit(1);
+		}
+	}
+	else if (vm.count("manifest")) {
+		if (!first_filename.empty()) {
+			std::cerr << "Error: models are read from the manifest with --manifest" << std::endl << std::endl;
+			cout << desc << "\n";
+			exit(1);
+		}
+	}
+	else if (first_filename.empty() || second_filename.empty() || !candidate_filenames.empty()) {
+		std::cerr << "Error: two models are required, --baseline with candidate models, or --manifest" << std::endl << std::endl;
+		cout << desc << "\n";
+		exit(1);
+	}
+}
+
+/**
+Writes the trace requested with --trace, registered to run at exit so that every exit path writes it.
+*/
+void write_trace() {
+	auto filename = vm["trace"].as<std::string>();
+
+	if (lpcompare::Trace::Write(filename))
+		cout << "Trace written to " << filename << endl;
 }
 
 /**
@@ -125,7 +392,7 @@ Creates a filename to dump differences into.
 \return dump filename.
 */
 std::string get_dump_filename(std::string model, std::string detail) {
-	return vm["dump-prefix"].as<std::string>() + "-" + model + "-" + detail + ".log";
+	return lpcompare::GetDumpFilename(vm["dump-prefix"].as<std::string>(), model, detail);
 }
 
 /**
@@ -134,162 +401,1628 @@ Checks if diff dumps are requested.
 \return true if diff dumps are requested.
 */
 bool is_diffdumps_requested() {
-	return vm["dump-diffs"].as<bool>();
+	return vm["dump-diffs"].as<bool>() && vm.count("summarize") == 0;
+}
+
+/**
+Checks if models are read with a LazyReader.
+
+\return true if --lazy or --aligned is given.
+*/
+bool is_lazy_requested() {
+	return vm.count("lazy") > 0 || vm.count("aligned") > 0;
+}
+
+/**
+Checks if differences have to be collected, for dumps or for a patch.
+
+\return true if differences are collected.
+*/
+bool is_diffs_collected() {
+	return is_diffdumps_requested() || vm.count("patch-out") > 0;
+}
+
+/**
+Checks if constraints are read in canonical form.
+
+\return true if canonical constraints are requested.
+*/
+bool is_canonical_requested() {
+	return vm.count("canonical") > 0;
+}
+
+/**
+Gets the number of parser threads for reading a model.
+
+\return parser threads of a pipelined read, 0 to parse on the reading thread.
+*/
+unsigned get_parse_threads() {
+	return vm["parse-threads"].as<unsigned>();
 }
 
 int main(int argc, char *argv [])
 {
 	INIT_TIMER;
 
+	// stdout of a worker is its result, read by the coordinator.
+	if (argc > 1 && std::string(argv[1]) == "worker") {
+		return run_worker(argc - 1, argv + 1);
+	}
+
 	cout << "lpcompare: Compares two LP files created in cplex format and dumps differences to files." << endl;
 
+	if (argc > 1 && std::string(argv[1]) == "serve") {
+		return run_serve(argc - 1, argv + 1);
+	}
+
+	if (argc > 1 && std::string(argv[1]) == "request") {
+		return run_request(argc - 1, argv + 1);
+	}
+
+	if (argc > 1 && std::string(argv[1]) == "apply") {
+		return run_apply(argc - 1, argv + 1);
+	}
+
+	if (argc > 1 && std::string(argv[1]) == "fingerprint") {
+		return run_fingerprint(argc - 1, argv + 1);
+	}
+
+	if (argc > 1 && std::string(argv[1]) == "compare-fp") {
+		return run_compare_fp(argc - 1, argv + 1);
+	}
+
+	if (argc > 1 && std::string(argv[1]) == "canonicalize") {
+		return run_canonicalize(argc - 1, argv + 1);
+	}
+
+	if (argc > 1 && std::string(argv[1]) == "analyze") {
+		return run_analyze(argc - 1, argv + 1);
+	}
+
+	program_path = argv[0];
+
 	setup_options(argc, argv);
 
+	if (vm.count("baseline")) {
+		return compare_with_baseline();
+	}
+
+	if (vm.count("manifest")) {
+		return compare_manifest();
+	}
+
+	if (vm.count("quick")) {
+		return compare_quick();
+	}
+
+	if (vm.count("structural")) {
+		return compare_structural();
+	}
+
+	if (vm.count("compact")) {
+		return compare_compact();
+	}
+
+	if (vm.count("shards")) {
+		return compare_sharded();
+	}
+
 	LPModel* model1 = new LPModel();
 	LPModel* model2 = new LPModel();
+	model1->Canonical = is_canonical_requested();
+	model2->Canonical = is_canonical_requested();
+	model1->ParseThreads = get_parse_threads();
+	model2->ParseThreads = get_parse_threads();
 
-	START_TIMER;
-	cout << "Reading first model: " << first_filename << endl;
-	if (!model1->ReadModel(first_filename)) {
-		exit(1);
+	lpcompare::LazyMatch lazy_match;
+
+	if (is_lazy_requested()) {
+		START_TIMER;
+		START_HW_PHASE("read models lazily");
+		cout << "Reading models lazily: " << first_filename << " " << second_filename << endl;
+
+		lpcompare::LazyReader reader;
+		reader.Canonical = is_canonical_requested();
+		reader.Aligned = vm.count("aligned") > 0;
+		reader.Lookahead = vm["lookahead"].as<std::size_t>();
+
+		if (!reader.Read(first_filename, second_filename, *model1, *model2, lazy_match)) {
+			exit(1);
+		}
+
+		if (lazy_match.Identical) {
+			cout << " Models are byte-identical, all sections are equivalent." << endl;
+			STOP_HW_PHASE();
+			write_patch_if_requested(lpcompare::CompareResult());
+			return 0;
+		}
+
+		if (reader.Aligned) {
+			cout << " Bounds " << (lazy_match.BoundsAligned ? "aligned" : "not aligned, matched by hash")
+				<< ", constraints " << (lazy_match.ConstraintsAligned ? "aligned" : "not aligned, matched by hash") << endl;
+		}
+		cout << " Textually equal rows left unparsed: " << lazy_match.Bounds << " bounds, " << lazy_match.Constraints << " constraints" << endl;
+		cout << " Rows parsed: " << model1->Bounds.size() + model2->Bounds.size() << " bounds, "
+			<< model1->Constraints.size() + model2->Constraints.size() << " constraints" << endl;
+		auto models_read_sec = STOP_TIMER_SEC();
+		cout << " Models read in " << models_read_sec << " s" << endl;
+		STOP_HW_PHASE();
 	}
-	cout << " First model:" << endl;
-	printStats(model1);
-	auto first_model_read_sec = STOP_TIMER_SEC();
-	cout << " Model read in " << first_model_read_sec << " s" << endl;
+	else if (!vm.count("task-graph")) {
+		START_TIMER;
+		START_HW_PHASE("read first model");
+		cout << "Reading first model: " << first_filename << endl;
+		if (!model1->ReadModel(first_filename)) {
+			exit(1);
+		}
+		cout << " First model:" << endl;
+		printStats(model1);
+		auto first_model_read_sec = STOP_TIMER_SEC();
+		cout << " Model read in " << first_model_read_sec << " s" << endl;
+		STOP_HW_PHASE();
 
-	START_TIMER;
-	cout << "Reading second model: " << second_filename << endl;
-	if (!model2->ReadModel(second_filename)) {
-		exit(1);
+		START_TIMER;
+		START_HW_PHASE("read second model");
+		cout << "Reading second model: " << second_filename << endl;
+		if (!model2->ReadModel(second_filename)) {
+			exit(1);
+		}
+		cout << " Second Model:" << endl;
+		printStats(model2);
+		auto second_model_read_sec = STOP_TIMER_SEC();
+		cout << " Model read in " << second_model_read_sec << " s" << endl;
+		STOP_HW_PHASE();
 	}
-	cout << " Second Model:" << endl;
-	printStats(model2);
-	auto second_model_read_sec = STOP_TIMER_SEC();
-	cout << " Model read in " << second_model_read_sec << " s" << endl;
 
-	cout << endl;
+	lpcompare::CompareResult result;
 
-	printCounts("Generals", model1->Generals, model2->Generals);
-	printCounts("Binaries", model1->Binaries, model2->Binaries);
-	printCounts("SosVars", model1->SosVars, model2->SosVars);
+	if (vm.count("task-graph")) {
+		result = compare_task_graph(*model1, *model2, lazy_match);
+	}
+	else {
+		cout << endl;
 
-	START_TIMER;
-	printCounts("Bounds", model1->Bounds, model2->Bounds);
-	auto bounds_check_sec = STOP_TIMER_SEC();
-	cout << " Bounds check completed in " << bounds_check_sec << " s" << endl;
+		result.Generals = printCounts("Generals", model1->Generals, model2->Generals);
+		result.Binaries = printCounts("Binaries", model1->Binaries, model2->Binaries);
+		result.SosVars = printCounts("SosVars", model1->SosVars, model2->SosVars);
 
-	START_TIMER;
-	printCounts("Constraints", model1->Constraints, model2->Constraints);
-	auto cons_check_sec = STOP_TIMER_SEC();
-	cout << " Constraints check completed in " << cons_check_sec << " s" << endl;
+		START_TIMER;
+		START_HW_PHASE("bounds check");
+		result.Bounds = printCounts("Bounds", model1->Bounds, model2->Bounds, lazy_match.Bounds);
+		auto bounds_check_sec = STOP_TIMER_SEC();
+		cout << " Bounds check completed in " << bounds_check_sec << " s" << endl;
+		STOP_HW_PHASE();
+
+		START_TIMER;
+		START_HW_PHASE("constraints check");
+		result.Constraints = printCounts("Constraints", model1->Constraints, model2->Constraints, lazy_match.Constraints);
+		auto cons_check_sec = STOP_TIMER_SEC();
+		cout << " Constraints check completed in " << cons_check_sec << " s" << endl;
+		STOP_HW_PHASE();
+	}
+
+	if (vm.count("column-report")) {
+		START_TIMER;
+		START_HW_PHASE("column report");
+		lpcompare::ThreadPool pool(vm["threads"].as<unsigned>());
+		lpcompare::ColumnReport report(pool);
+		report.Build(*model1, *model2);
+
+		if (!report.Write(vm["column-report"].as<std::string>())) {
+			exit(1);
+		}
+
+		report.WriteSummary(cout);
+		auto column_report_sec = STOP_TIMER_SEC();
+		cout << " Column report written to " << vm["column-report"].as<std::string>() << " in " << column_report_sec << " s" << endl;
+		STOP_HW_PHASE();
+	}
+
+	write_patch_if_requested(result);
 
 	return 0;
 }
 
+/**
+Writes a patch turning the first model into the second if one is requested.
+
+\param result Differences of the models, collected.
+*/
+void write_patch_if_requested(const lpcompare::CompareResult &result) {
+
+	if (!vm.count("patch-out"))
+		return;
+
+	auto patch = lpcompare::ModelPatch::Create(result, cout);
+
+	if (!patch.Write(vm["patch-out"].as<std::string>())) {
+		exit(1);
+	}
+	cout << "Patch written to " << vm["patch-out"].as<std::string>() << endl;
+}
+
 /**
 Prints statistics for a model.
 
 \param model Model.
+\param out Stream to print to.
 */
-void printStats(LPModel *model) {
-	cout << "Binaries: " << model->Binaries.size() << endl;
-	cout << "Bounds: " << model->Bounds.size() << endl;
-	cout << "Constraints: " << model->Constraints.size() << endl;
-	cout << "Generals: " << model->Generals.size() << endl;
-	cout << "SosVars: " << model->SosVars.size() << endl;
+void printStats(LPModel *model, std::ostream &out) {
+	out << "Binaries: " << model->Binaries.size() << endl;
+	out << "Bounds: " << model->Bounds.size() << endl;
+	out << "Constraints: " << model->Constraints.size() << endl;
+	out << "Generals: " << model->Generals.size() << endl;
+	out << "SosVars: " << model->SosVars.size() << endl;
 }
 
 /**
 Dumps diffs to a file if dumping is requested.
 
-\param set1Except2 List of elements that are in the first model but not in the second model.
-\param set2Except1 List of elements that are in the second model but not in the first model.
+\param detail_name Given name of the detail.
+\param diff Differences of the detail.
+\param log Stream to report written files to.
 */
 template <typename T>
-void dumpdiff_if_requested(const std::string &detail_name, const std::vector<T> &set1Except2, const std::vector<T> &set2Except1) {
+void dumpdiff_if_requested(const std::string &detail_name, const SectionDiff<T> &diff, std::ostream &log) {
 
 	if (!is_diffdumps_requested())
 		return;
 
-	if (set1Except2.size() > 0) {
+	lpcompare::DumpSectionDiff(detail_name, diff, vm["dump-prefix"].as<std::string>(), log, dump_options);
+}
 
-		auto filename1e2 = get_dump_filename("firstEXCEPTsecond", detail_name);
-		std::ofstream out_file_1(filename1e2);
+/**
+Prints count of a given detail for both models, including differences.
 
-		if (!out_file_1) {
-			cout << "Cannot open or create file for writing: " << filename1e2;
-			return;
-		}
+\param detail_name Given name of the detail.
+\param vec List of elements that are in the first model.
+\param vecother List of elements that are in the second model.
+\param matched Equal elements of both models left out of vec and vecother by a lazy read.
+\return Differences of the detail.
+*/
+template <typename T>
+SectionDiff<T> printCounts(const std::string detail_name, std::vector<T> &vec, std::vector<T> &vecother, std::size_t matched)
+{
+	auto diff = compareCounts(detail_name, vec, vecother, matched, cout);
 
-		out_file_1 << "firstEXCEPTsecond " << detail_name << std::endl;
-		for (auto item : set1Except2) {
-			out_file_1 << item << std::endl;
-		}
+	dumpdiff_if_requested(detail_name, diff);
+
+	return diff;
+}
+
+/**
+Compares a detail of both models and writes its counts, without dumping differences.
+
+\param detail_name Given name of the detail.
+\param vec List of elements that are in the first model.
+\param vecother List of elements that are in the second model.
+\param matched Equal elements of both models left out of vec and vecother by a lazy read.
+\param out Stream to write counts and the summary to.
+\return Differences of the detail.
+*/
+template <typename T>
+SectionDiff<T> compareCounts(const std::string &detail_name, std::vector<T> &vec, std::vector<T> &vecother, std::size_t matched, std::ostream &out)
+{
+	if (vm.count("summarize")) {
+		lpcompare::SectionSummary<T> summary(name_grouper);
+		auto diff = lpcompare::CompareSection(vec, vecother, summary);
+		diff.FirstCount += matched;
+		diff.SecondCount += matched;
 
-		out_file_1.flush();
-		out_file_1.close();
+		lpcompare::WriteSectionCounts(detail_name, diff, out);
+		summary.Write(detail_name, out);
 
-		cout << "firstEXCEPTsecond diff written for " << detail_name << " to " << filename1e2 << std::endl;
+		return diff;
 	}
 
-	if (set2Except1.size() > 0) {
+	auto diff = is_diffs_collected()
+		? lpcompare::CompareSection(vec, vecother, diff_limit)
+		: lpcompare::CompareSection(vec, vecother, false);
+	diff.FirstCount += matched;
+	diff.SecondCount += matched;
 
-		auto filename2e1 = get_dump_filename("secondEXCEPTfirst", detail_name);
-		std::ofstream out_file_2(filename2e1);
+	lpcompare::WriteSectionCounts(detail_name, diff, out);
 
-		if (!out_file_2) {
-			cout << "Cannot open or create file for writing: " << filename2e1;
-			return;
-		}
+	return diff;
+}
 
-		out_file_2 << "secondEXCEPTfirst " << detail_name << std::endl;
-		for (auto item : set2Except1) {
-			out_file_2 << item << std::endl;
-		}
+/**
+A section compared by compare_task_graph. Its tasks write to Out, which is printed once the graph has run.
+*/
+template <typename T>
+struct SectionTasks {
+	std::string Name;
+	SectionDiff<T> Diff;
+	std::ostringstream Out;
+	std::chrono::high_resolution_clock::time_point SortStart[2];
+	std::chrono::high_resolution_clock::time_point End;
 
-		out_file_2.flush();
-		out_file_2.close();
+	explicit SectionTasks(const std::string &name) : Name(name) {}
 
-		cout << "secondEXCEPTfirst diff written for " << detail_name << " to " << filename2e1 << std::endl;
+	/**
+	\return seconds from the first sort of the section until its dumps were written.
+	*/
+	long long ElapsedSec() const {
+		auto start = std::min(SortStart[0], SortStart[1]);
+		return std::chrono::duration_cast<std::chrono::milliseconds>(End - start).count() / 1000;
 	}
-}
+};
 
 /**
-Prints count of a given detail for both models, including differences.
+Adds tasks sorting both sides of a section, diffing them and dumping the differences.
 
-\param detail_name Given name of the detail.
+\param graph Task graph.
+\param section Section state, written by the tasks.
 \param vec List of elements that are in the first model.
 \param vecother List of elements that are in the second model.
+\param matched Equal elements of both models left out of vec and vecother by a lazy read.
+\param read1 Task reading the first model.
+\param read2 Task reading the second model.
+\param read_failed Set when a model cannot be read, the tasks then do nothing.
 */
 template <typename T>
-void printCounts(const std::string detail_name, std::vector<T> &vec, std::vector<T> &vecother)
+void add_section_tasks(lpcompare::TaskGraph &graph, SectionTasks<T> &section, std::vector<T> &vec, std::vector<T> &vecother,
+	std::size_t matched, std::size_t read1, std::size_t read2, const std::atomic<bool> &read_failed)
+{
+	auto sort1 = graph.Add([&section, &vec, &read_failed]() {
+		if (read_failed)
+			return;
+		section.SortStart[0] = std::chrono::high_resolution_clock::now();
+		lpcompare::SortSection(vec);
+	}, { read1 });
+
+	auto sort2 = graph.Add([&section, &vecother, &read_failed]() {
+		if (read_failed)
+			return;
+		section.SortStart[1] = std::chrono::high_resolution_clock::now();
+		lpcompare::SortSection(vecother);
+	}, { read2 });
+
+	auto diff = graph.Add([&section, &vec, &vecother, matched, &read_failed]() {
+		if (read_failed)
+			return;
+		section.Diff = compareCounts(section.Name, vec, vecother, matched, section.Out);
+	}, { sort1, sort2 });
+
+	graph.Add([&section, &read_failed]() {
+		// a partly read model must not leave dumps behind.
+		if (read_failed)
+			return;
+		dumpdiff_if_requested(section.Name, section.Diff, section.Out);
+		section.End = std::chrono::high_resolution_clock::now();
+	}, { diff });
+}
+
+/**
+Adds a task reading a model, printing to a buffer.
+
+\param graph Task graph.
+\param model Model to read into.
+\param filename Filename of the model.
+\param title Model title, "first" or "second".
+\param out Buffer for the read report.
+\param failed Set when the model cannot be read.
+\return Id of the task.
+*/
+std::size_t add_read_task(lpcompare::TaskGraph &graph, LPModel &model, const std::string &filename, const std::string &title,
+	std::ostringstream &out, std::atomic<bool> &failed)
 {
-	cout << detail_name << " First Model: " << vec.size() << endl;
-	cout << detail_name << " Second Model: " << vecother.size() << endl;
+	return graph.Add([&model, &filename, title, &out, &failed]() {
+		INIT_TIMER;
+		out << "Reading " << title << " model: " << filename << endl;
+		if (!model.ReadModel(filename)) {
+			failed = true;
+			return;
+		}
+		out << (title == "first" ? " First model:" : " Second Model:") << endl;
+		printStats(&model, out);
+		auto model_read_sec = STOP_TIMER_SEC();
+		out << " Model read in " << model_read_sec << " s" << endl;
+	});
+}
 
-	std::sort(vec.begin(), vec.end());
-	assert(std::is_sorted(vec.begin(), vec.end()));
+/**
+Compares the models as a graph of tasks on a shared pool of --threads threads: both models are read,
+then both sides of every section are sorted, diffed and dumped, so that e.g. the bounds diff and
+its dumps overlap the constraints sort. Output of each task is buffered and printed in the order
+of the sequential comparison once every task has run.
 
-	std::sort(vecother.begin(), vecother.end());
-	assert(std::is_sorted(vecother.begin(), vecother.end()));
+\param model1 First model, read by the graph unless the models were read lazily.
+\param model2 Second model.
+\param lazy_match Equal rows left out of the models by a lazy read.
+\return Differences of the models.
+*/
+lpcompare::CompareResult compare_task_graph(LPModel &model1, LPModel &model2, const lpcompare::LazyMatch &lazy_match) {
 
-	std::vector<T> set1Except2;
-	std::set_difference(vec.begin(), vec.end(), vecother.begin(), vecother.end(), std::back_inserter(set1Except2));
+	INIT_TIMER;
+	START_HW_PHASE("task graph");
 
-	std::vector<T> set2Except1;
-	std::set_difference(vecother.begin(), vecother.end(), vec.begin(), vec.end(), std::back_inserter(set2Except1));
+	lpcompare::ThreadPool pool(vm["threads"].as<unsigned>());
+	lpcompare::TaskGraph graph(pool);
 
-	auto size1e2 = set1Except2.size();
-	auto size2e1 = set1Except2.size();
+	std::ostringstream read_out[2];
+	std::atomic<bool> read_failed(false);
+	std::size_t read1, read2;
 
-	if (size1e2 == 0 && size2e1 == 0) {
-		cout << detail_name << " are equivalent." << endl;
+	if (is_lazy_requested()) {
+		read1 = read2 = graph.Add([]() {});
 	}
 	else {
-		cout << detail_name << " First except Second: " << set1Except2.size() << endl;
-		cout << detail_name << " Second except First: " << set2Except1.size() << endl;
+		// Progress lines of two models read at once would interleave.
+		model1.ReportProgress = false;
+		model2.ReportProgress = false;
+		read1 = add_read_task(graph, model1, first_filename, "first", read_out[0], read_failed);
+		read2 = add_read_task(graph, model2, second_filename, "second", read_out[1], read_failed);
 	}
 
-	dumpdiff_if_requested(detail_name, set1Except2, set2Except1);
+	SectionTasks<std::string> generals("Generals");
+	SectionTasks<std::string> binaries("Binaries");
+	SectionTasks<std::string> sosvars("SosVars");
+	SectionTasks<lpcompare::Bound> bounds("Bounds");
+	SectionTasks<lpcompare::Constraint> constraints("Constraints");
+
+	add_section_tasks(graph, generals, model1.Generals, model2.Generals, 0, read1, read2, read_failed);
+	add_section_tasks(graph, binaries, model1.Binaries, model2.Binaries, 0, read1, read2, read_failed);
+	add_section_tasks(graph, sosvars, model1.SosVars, model2.SosVars, 0, read1, read2, read_failed);
+	add_section_tasks(graph, bounds, model1.Bounds, model2.Bounds, lazy_match.Bounds, read1, read2, read_failed);
+	add_section_tasks(graph, constraints, model1.Constraints, model2.Constraints, lazy_match.Constraints, read1, read2, read_failed);
+
+	graph.Run();
+
+	// The reader has reported why a model cannot be read.
+	if (read_failed) {
+		exit(1);
+	}
+
+	cout << read_out[0].str() << read_out[1].str();
+	cout << endl;
+	cout << generals.Out.str() << binaries.Out.str() << sosvars.Out.str();
+	cout << bounds.Out.str();
+	cout << " Bounds check completed in " << bounds.ElapsedSec() << " s" << endl;
+	cout << constraints.Out.str();
+	cout << " Constraints check completed in " << constraints.ElapsedSec() << " s" << endl;
+
+	auto task_graph_sec = STOP_TIMER_SEC();
+	cout << " Task graph completed in " << task_graph_sec << " s on " << pool.Size() << " threads" << endl;
+	STOP_HW_PHASE();
+
+	lpcompare::CompareResult result;
+	result.Generals = std::move(generals.Diff);
+	result.Binaries = std::move(binaries.Diff);
+	result.SosVars = std::move(sosvars.Diff);
+	result.Bounds = std::move(bounds.Diff);
+	result.Constraints = std::move(constraints.Diff);
+
+	return result;
+}
+
+/**
+Summarizes differing sections of a comparison on a single line.
+
+\param result Comparison result.
+\return Summary line.
+*/
+std::string summary_line(const lpcompare::CompareResult &result) {
+
+	if (result.AreEquivalent())
+		return "equivalent";
+
+	std::ostringstream line;
+	line << "differs";
+
+	auto append = [&line](const std::string &detail_name, std::size_t size1e2, std::size_t size2e1) {
+		if (size1e2 > 0 || size2e1 > 0)
+			line << ", " << detail_name << " -" << size1e2 << "/+" << size2e1;
+	};
+
+	append("Generals", result.Generals.FirstExceptSecondCount, result.Generals.SecondExceptFirstCount);
+	append("Binaries", result.Binaries.FirstExceptSecondCount, result.Binaries.SecondExceptFirstCount);
+	append("SosVars", result.SosVars.FirstExceptSecondCount, result.SosVars.SecondExceptFirstCount);
+	append("Bounds", result.Bounds.FirstExceptSecondCount, result.Bounds.SecondExceptFirstCount);
+	append("Constraints", result.Constraints.FirstExceptSecondCount, result.Constraints.SecondExceptFirstCount);
+
+	return line.str();
+}
+
+/**
+Creates a dump prefix for each candidate from its filename, made unique with an index if needed.
+
+\return dump prefixes in the order of candidate_filenames.
+*/
+std::vector<std::string> get_candidate_dump_prefixes() {
+
+	std::vector<std::string> prefixes;
+	std::set<std::string> used;
+
+	for (std::size_t i = 0; i < candidate_filenames.size(); i++) {
+		auto prefix = vm["dump-prefix"].as<std::string>() + "-" + boost::filesystem::path(candidate_filenames[i]).stem().string();
+
+		if (!used.insert(prefix).second) {
+			prefix += "-" + std::to_string(i + 1);
+			used.insert(prefix);
+		}
+
+		prefixes.push_back(prefix);
+	}
+
+	return prefixes;
+}
+
+/**
+Compares a section of the baseline to a candidate and writes its differences grouped by name,
+as with --summarize for two models.
+
+\param detail_name Given name of the detail.
+\param vec Sorted section of the baseline, only read.
+\param vecother Section of the candidate.
+\param out Stream to write the summary to.
+\return Differences of the detail, counted only.
+*/
+template <typename T>
+SectionDiff<T> summarize_candidate_section(const std::string &detail_name, std::vector<T> &vec, std::vector<T> &vecother, std::ostream &out)
+{
+	lpcompare::SectionSummary<T> summary(name_grouper);
+	auto diff = lpcompare::CompareSection(vec, vecother, summary);
+	summary.Write(detail_name, out);
+
+	return diff;
+}
+
+/**
+Compares the baseline model to every candidate model. The baseline is read and sorted once,
+candidates are read and compared on a thread pool with a bounded number of them in memory.
+Their reports are printed in the order of the candidates. With --summarize, the differences of every candidate are printed grouped by name after its line.
+
+\return exit code.
+*/
+int compare_with_baseline() {
+
+	INIT_TIMER;
+
+	LPModel baseline;
+	baseline.Canonical = is_canonical_requested();
+	baseline.ParseThreads = get_parse_threads();
+
+	START_TIMER;
+	cout << "Reading baseline model: " << baseline_filename << endl;
+	if (!baseline.ReadModel(baseline_filename)) {
+		exit(1);
+	}
+	cout << " Baseline model:" << endl;
+	printStats(&baseline);
+
+	// sorted sections are shared read-only between the comparisons.
+	baseline.Sort();
+	auto baseline_read_sec = STOP_TIMER_SEC();
+	cout << " Model read in " << baseline_read_sec << " s" << endl << endl;
+
+	auto threads = vm["threads"].as<unsigned>();
+	auto max_loaded = vm["max-loaded"].as<unsigned>();
+
+	lpcompare::ThreadPool pool(threads);
+	lpcompare::Semaphore loaded(max_loaded > 0 ? max_loaded : pool.Size());
+
+	auto prefixes = get_candidate_dump_prefixes();
+	std::mutex output_mutex;
+	std::size_t differing = 0;
+	std::vector<std::string> reports(candidate_filenames.size());
+	std::vector<bool> reported(candidate_filenames.size(), false);
+	std::size_t next_report = 0;
+
+	lpcompare::CompareOptions options;
+	options.CollectDiffs = is_diffdumps_requested();
+	options.Limit = diff_limit;
+
+	START_TIMER;
+	for (std::size_t i = 0; i < candidate_filenames.size(); i++) {
+		pool.Enqueue([&, i]() {
+
+			const auto &filename = candidate_filenames[i];
+			std::ostringstream messages;
+			std::string summary;
+			bool equivalent = false;
+
+			loaded.Acquire();
+
+			try {
+				LPModel candidate;
+				candidate.ReportProgress = false;
+				candidate.Canonical = is_canonical_requested();
+				candidate.ParseThreads = get_parse_threads();
+
+				// a missing file is reported in the candidate's line instead of by the reader.
+				if (!boost::filesystem::exists(filename)) {
+					summary = "cannot be read: file not found";
+				}
+				else if (!candidate.ReadModel(filename)) {
+					summary = "cannot be read";
+				}
+				else if (vm.count("summarize")) {
+					lpcompare::CompareResult result;
+					result.Generals = summarize_candidate_section("Generals", baseline.Generals, candidate.Generals, messages);
+					result.Binaries = summarize_candidate_section("Binaries", baseline.Binaries, candidate.Binaries, messages);
+					result.SosVars = summarize_candidate_section("SosVars", baseline.SosVars, candidate.SosVars, messages);
+					result.Bounds = summarize_candidate_section("Bounds", baseline.Bounds, candidate.Bounds, messages);
+					result.Constraints = summarize_candidate_section("Constraints", baseline.Constraints, candidate.Constraints, messages);
+
+					equivalent = result.AreEquivalent();
+					summary = summary_line(result);
+				}
+				else {
+					auto result = lpcompare::Compare(baseline, candidate, options);
+
+					equivalent = result.AreEquivalent();
+					summary = summary_line(result);
+
+					if (is_diffdumps_requested()) {
+						auto candidate_dump_options = dump_options;
+						if (!candidate_dump_options.FirstSource.empty())
+							candidate_dump_options.SecondSource = filename;
+
+						lpcompare::DumpSectionDiff("Generals", result.Generals, prefixes[i], messages, candidate_dump_options);
+						lpcompare::DumpSectionDiff("Binaries", result.Binaries, prefixes[i], messages, candidate_dump_options);
+						lpcompare::DumpSectionDiff("SosVars", result.SosVars, prefixes[i], messages, candidate_dump_options);
+						lpcompare::DumpSectionDiff("Bounds", result.Bounds, prefixes[i], messages, candidate_dump_options);
+						lpcompare::DumpSectionDiff("Constraints", result.Constraints, prefixes[i], messages, candidate_dump_options);
+					}
+				}
+			}
+			catch (std::exception &e) {
+				summary = std::string("cannot be compared: ") + e.what();
+			}
+
+			loaded.Release();
+
+			std::lock_guard<std::mutex> lock(output_mutex);
+			if (!equivalent)
+				differing++;
+
+			reports[i] = filename + ": " + summary + "\n" + messages.str();
+			reported[i] = true;
+
+			// a report is printed once the reports of all earlier candidates are.
+			while (next_report < reports.size() && reported[next_report]) {
+				cout << reports[next_report] << std::flush;
+				reports[next_report].clear();
+				next_report++;
+			}
+		});
+	}
+
+	pool.Wait();
+
+	cout << differing << " of " << candidate_filenames.size() << " candidates differ from the baseline." << endl;
+	auto candidates_sec = STOP_TIMER_SEC();
+	cout << " Candidates compared in " << candidates_sec << " s" << endl;
+
+	return 0;
+}
+
+/**
+Compares every pair of models listed in the manifest inside this process and prints a summary per pair.
+
+\return exit code.
+*/
+int compare_manifest() {
+
+	INIT_TIMER;
+
+	std::vector<lpcompare::ComparePair> pairs;
+
+	if (!lpcompare::ManifestCompare::ReadManifest(vm["manifest"].as<std::string>(), pairs)) {
+		exit(1);
+	}
+
+	if (is_diffdumps_requested()) {
+		for (std::size_t i = 0; i < pairs.size(); i++)
+			pairs[i].DumpPrefix = vm["dump-prefix"].as<std::string>() + "-" + std::to_string(i + 1);
+	}
+
+	cout << "Comparing " << pairs.size() << " pairs from " << vm["manifest"].as<std::string>() << endl;
+
+	START_TIMER;
+	lpcompare::ThreadPool pool(vm["threads"].as<unsigned>());
+	lpcompare::ManifestCompare manifest(pool, vm["memory-budget-mb"].as<std::size_t>() * 1024 * 1024, dump_options, diff_limit);
+	manifest.Canonical = is_canonical_requested();
+	manifest.DumpSource = vm.count("dump-source") > 0;
+	manifest.Run(pairs);
+	auto pairs_sec = STOP_TIMER_SEC();
+
+	std::size_t differing = 0;
+	std::size_t failed = 0;
+
+	cout << endl;
+	for (std::size_t i = 0; i < pairs.size(); i++) {
+		const auto &pair = pairs[i];
+
+		cout << "[" << i + 1 << "] " << pair.First << " " << pair.Second << ": ";
+
+		if (!pair.Error.empty()) {
+			failed++;
+			cout << "error, " << pair.Error;
+		}
+		else {
+			if (!pair.Result.AreEquivalent())
+				differing++;
+			cout << summary_line(pair.Result);
+		}
+
+		cout << " (" << pair.Seconds << " s)" << endl;
+	}
+
+	cout << differing << " of " << pairs.size() << " pairs differ, " << failed << " could not be compared." << endl;
+	cout << " Pairs compared in " << pairs_sec << " s" << endl;
+
+	return 0;
+}
+
+/**
+Prints whether a section is equal in both models from its fingerprints.
+
+\param detail_name Given name of the detail.
+\param first Fingerprint of the section in the first model.
+\param second Fingerprint of the section in the second model.
+\return true if the section is equal.
+*/
+bool printQuick(const std::string &detail_name, const lpcompare::MultisetHash &first, const lpcompare::MultisetHash &second) {
+
+	cout << detail_name << " First Model: " << first.Count << endl;
+	cout << detail_name << " Second Model: " << second.Count << endl;
+
+	if (first == second) {
+		cout << detail_name << " are equivalent." << endl;
+		return true;
+	}
+
+	cout << detail_name << " differ." << endl;
+	return false;
+}
+
+/**
+Checks whether the two models are equal by streaming each of them once through a FingerprintSink.
+Nothing but the fingerprints is kept in memory and no section is sorted.
+
+\return exit code, 0 if the models are equal, 2 if they differ.
+*/
+int compare_quick() {
+
+	INIT_TIMER;
+
+	lpcompare::FingerprintSink fingerprint1, fingerprint2;
+	bool read2 = false;
+
+	START_TIMER;
+	cout << "Reading models: " << first_filename << " " << second_filename << endl;
+
+	std::thread reader2([&]() {
+		LPModel reader;
+		reader.ReportProgress = false;
+		reader.Canonical = is_canonical_requested();
+		reader.ParseThreads = get_parse_threads();
+		read2 = reader.ReadModel(second_filename, fingerprint2);
+	});
+
+	LPModel reader1;
+	reader1.Canonical = is_canonical_requested();
+	reader1.ParseThreads = get_parse_threads();
+	bool read1 = reader1.ReadModel(first_filename, fingerprint1);
+
+	reader2.join();
+
+	if (!read1 || !read2) {
+		exit(1);
+	}
+
+	auto models_read_sec = STOP_TIMER_SEC();
+	cout << " Models read in " << models_read_sec << " s" << endl << endl;
+
+	bool equal = printQuick("Generals", fingerprint1.Generals, fingerprint2.Generals);
+	equal = printQuick("Binaries", fingerprint1.Binaries, fingerprint2.Binaries) && equal;
+	equal = printQuick("SosVars", fingerprint1.SosVars, fingerprint2.SosVars) && equal;
+	equal = printQuick("Bounds", fingerprint1.Bounds, fingerprint2.Bounds) && equal;
+	equal = printQuick("Constraints", fingerprint1.Constraints, fingerprint2.Constraints) && equal;
+
+	return equal ? 0 : 2;
+}
+
+/**
+Prints rows or columns of two models matched by structure.
+
+\param detail_name Given name of the detail.
+\param match Matching of the detail.
+*/
+void printStructuralMatch(const std::string &detail_name, const lpcompare::StructuralMatch &match) {
+
+	cout << detail_name << " matched: " << match.Matched << ", by neighbourhood only: " << match.MatchedLocally << ", renamed: " << match.Renamed << endl;
+
+	auto print_names = [&detail_name](const std::string &side, std::size_t count, const std::vector<std::string> &names) {
+		cout << detail_name << " " << side << ": " << count;
+		for (const auto &name : names)
+			cout << " " << (name.empty() ? "(unnamed)" : name);
+		if (count > names.size())
+			cout << " ...";
+		cout << endl;
+	};
+
+	print_names("First except Second", match.FirstExceptSecondCount, match.FirstExceptSecond);
+	print_names("Second except First", match.SecondExceptFirstCount, match.SecondExceptFirst);
+}
+
+/**
+Compares the two models regardless of row and column names.
+
+\return exit code, 0 if the models are structurally identical, 2 otherwise.
+*/
+int compare_structural() {
+
+	INIT_TIMER;
+
+	LPModel model1, model2;
+	model1.Canonical = is_canonical_requested();
+	model2.Canonical = is_canonical_requested();
+	model1.ParseThreads = get_parse_threads();
+	model2.ParseThreads = get_parse_threads();
+
+	START_TIMER;
+	cout << "Reading first model: " << first_filename << endl;
+	if (!model1.ReadModel(first_filename)) {
+		exit(1);
+	}
+	cout << "Reading second model: " << second_filename << endl;
+	if (!model2.ReadModel(second_filename)) {
+		exit(1);
+	}
+	auto models_read_sec = STOP_TIMER_SEC();
+	cout << " Models read in " << models_read_sec << " s" << endl << endl;
+
+	START_TIMER;
+	lpcompare::ThreadPool pool(vm["threads"].as<unsigned>());
+	lpcompare::StructuralCompare structural(pool);
+	auto result = structural.Compare(model1, model2);
+	auto structural_sec = STOP_TIMER_SEC();
+
+	cout << "Rows First Model: " << model1.Constraints.size() << endl;
+	cout << "Rows Second Model: " << model2.Constraints.size() << endl;
+	printStructuralMatch("Rows", result.Rows);
+	printStructuralMatch("Columns", result.Columns);
+
+	if (result.Identical)
+		cout << "Models are structurally identical up to renaming." << endl;
+	else
+		cout << "Models differ structurally." << endl;
+
+	cout << " Structural comparison completed in " << result.Rounds << " rounds, " << structural_sec << " s" << endl;
+
+	return result.Identical ? 0 : 2;
+}
+
+/**
+Reads a model into a CompactModel and prints its size.
+
+\param filename Filename of the LP model.
+\param model Model to read into.
+*/
+void read_compact(const std::string &filename, lpcompare::CompactModel &model) {
+
+	LPModel reader;
+	reader.Canonical = is_canonical_requested();
+	reader.ParseThreads = get_parse_threads();
+
+	if (!reader.ReadModel(filename, model)) {
+		exit(1);
+	}
+
+	cout << " Rows: " << model.RowCount() << ", nonzeros: " << model.NonzeroCount()
+		<< ", compact size: " << model.EstimateMemory() / (1024 * 1024) << " MB" << endl;
+}
+
+/**
+Compares two models held in CompactModel form. Constraints are compared on their encoded rows and
+only differing rows are decoded, for dumps, summaries or a patch.
+
+\return exit code, 0 when the comparison completes.
+*/
+int compare_compact() {
+
+	INIT_TIMER;
+
+	lpcompare::CompactDictionary dictionary;
+	lpcompare::CompactModel model1(dictionary), model2(dictionary);
+
+	START_TIMER;
+	cout << "Reading first model: " << first_filename << endl;
+	read_compact(first_filename, model1);
+	cout << "Reading second model: " << second_filename << endl;
+	read_compact(second_filename, model2);
+	cout << " Dictionary: " << dictionary.ColumnCount() << " columns, " << dictionary.CoefficientCount() << " coded values, "
+		<< dictionary.EstimateMemory() / (1024 * 1024) << " MB" << endl;
+	auto models_read_sec = STOP_TIMER_SEC();
+	cout << " Models read in " << models_read_sec << " s" << endl << endl;
+
+	lpcompare::CompareResult result;
+
+	result.Generals = printCounts("Generals", model1.Generals, model2.Generals);
+	result.Binaries = printCounts("Binaries", model1.Binaries, model2.Binaries);
+	result.SosVars = printCounts("SosVars", model1.SosVars, model2.SosVars);
+
+	START_TIMER;
+	result.Bounds = printCounts("Bounds", model1.Bounds, model2.Bounds);
+	auto bounds_check_sec = STOP_TIMER_SEC();
+	cout << " Bounds check completed in " << bounds_check_sec << " s" << endl;
+
+	START_TIMER;
+	if (vm.count("summarize")) {
+		lpcompare::SectionSummary<lpcompare::Constraint> summary(name_grouper);
+		result.Constraints = model1.CompareConstraints(model2, &summary);
+
+		lpcompare::WriteSectionCounts("Constraints", result.Constraints, cout);
+		summary.Write("Constraints", cout);
+	}
+	else if (is_diffs_collected()) {
+		SectionDiff<lpcompare::Constraint> collected;
+		lpcompare::LimitedCollector<lpcompare::Constraint> collector(collected, diff_limit);
+
+		result.Constraints = model1.CompareConstraints(model2, &collector);
+		result.Constraints.FirstExceptSecond.swap(collected.FirstExceptSecond);
+		result.Constraints.SecondExceptFirst.swap(collected.SecondExceptFirst);
+		lpcompare::SortSection(result.Constraints.FirstExceptSecond);
+		lpcompare::SortSection(result.Constraints.SecondExceptFirst);
+
+		lpcompare::WriteSectionCounts("Constraints", result.Constraints, cout);
+		dumpdiff_if_requested("Constraints", result.Constraints);
+	}
+	else {
+		result.Constraints = model1.CompareConstraints(model2, nullptr);
+		lpcompare::WriteSectionCounts("Constraints", result.Constraints, cout);
+	}
+	auto cons_check_sec = STOP_TIMER_SEC();
+	cout << " Constraints check completed in " << cons_check_sec << " s" << endl;
+
+	write_patch_if_requested(result);
+
+	return 0;
+}
+
+/**
+\class ShardSection
+Differences of a section merged from shard workers, collected for dumps and patches or summarized.
+*/
+template <typename T>
+struct ShardSection {
+	SectionDiff<T> collected;
+	lpcompare::LimitedCollector<T> collector;
+	lpcompare::SectionSummary<T> summary;
+
+	ShardSection() : collector(collected, diff_limit), summary(name_grouper) {}
+
+	/**
+	\return Sink for the differing elements returned by workers, nullptr if they are not needed.
+	*/
+	lpcompare::DiffSink<T> *Sink() {
+		if (vm.count("summarize"))
+			return &summary;
+		if (is_diffs_collected())
+			return &collector;
+		return nullptr;
+	}
+
+	/**
+	Prints the merged counts and summary of the section, or dumps its differences.
+
+	\param detail_name Given name of the detail.
+	\param diff Merged counts of the section, receives the collected elements.
+	*/
+	void Print(const std::string &detail_name, SectionDiff<T> &diff) {
+		diff.FirstExceptSecond.swap(collected.FirstExceptSecond);
+		diff.SecondExceptFirst.swap(collected.SecondExceptFirst);
+		lpcompare::SortSection(diff.FirstExceptSecond);
+		lpcompare::SortSection(diff.SecondExceptFirst);
+
+		lpcompare::WriteSectionCounts(detail_name, diff, cout);
+
+		if (vm.count("summarize"))
+			summary.Write(detail_name, cout);
+		else
+			dumpdiff_if_requested(detail_name, diff);
+	}
+};
+
+/**
+Compares two models in shards. Both models are partitioned by element hash into shard files, every
+pair of shard files is compared by a worker process and the results of the workers are merged.
+Workers run as child processes, at most --threads at once, and report over a pipe; a
+--worker-command can run them on other hosts that share the shard directory.
+
+\return exit code, 0 when the comparison completes.
+*/
+int compare_sharded() {
+
+	namespace fs = boost::filesystem;
+
+	INIT_TIMER;
+
+	auto shards = vm["shards"].as<unsigned>();
+	bool collect = vm.count("summarize") > 0 || is_diffs_collected();
+
+	std::string directory;
+	bool temporary = !vm.count("shard-dir");
+
+	if (temporary)
+		directory = (fs::temp_directory_path() / fs::unique_path("lpcompare-shards-%%%%-%%%%-%%%%")).string();
+	else
+		directory = vm["shard-dir"].as<std::string>();
+
+	boost::system::error_code error;
+	fs::create_directories(directory, error);
+
+	if (error) {
+		std::cerr << "Error: cannot create shard directory " << directory << ": " << error.message() << std::endl;
+		exit(1);
+	}
+
+	auto remove_shards = [&]() {
+		for (unsigned i = 0; i < shards; i++) {
+			fs::remove(lpcompare::ShardWriter::ShardFilename(directory, "first", i), error);
+			fs::remove(lpcompare::ShardWriter::ShardFilename(directory, "second", i), error);
+		}
+		if (temporary)
+			fs::remove(directory, error);
+	};
+
+	START_TIMER;
+	for (const auto &model : { std::make_pair(first_filename, std::string("first")), std::make_pair(second_filename, std::string("second")) }) {
+		cout << "Partitioning " << model.second << " model: " << model.first << endl;
+
+		LPModel reader;
+		reader.Canonical = is_canonical_requested();
+		reader.ParseThreads = get_parse_threads();
+
+		lpcompare::ShardWriter writer(directory, model.second, shards);
+
+		if (!writer.Good() || !reader.ReadModel(model.first, writer) || !writer.Close()) {
+			std::cerr << "Error: cannot write shards of " << model.first << " to " << directory << std::endl;
+			remove_shards();
+			exit(1);
+		}
+	}
+	auto partition_sec = STOP_TIMER_SEC();
+	cout << " Models partitioned into " << shards << " shards in " << partition_sec << " s" << endl << endl;
+
+	ShardSection<std::string> generals, binaries, sosvars;
+	ShardSection<lpcompare::Bound> bounds;
+	ShardSection<lpcompare::Constraint> constraints;
+
+	lpcompare::ShardSinks sinks;
+	sinks.Generals = generals.Sink();
+	sinks.Binaries = binaries.Sink();
+	sinks.SosVars = sosvars.Sink();
+	sinks.Bounds = bounds.Sink();
+	sinks.Constraints = constraints.Sink();
+
+	std::string command = vm.count("worker-command") ? vm["worker-command"].as<std::string>() : shell_quote(program_path) + " worker";
+	unsigned concurrent = vm["threads"].as<unsigned>();
+	if (concurrent == 0)
+		concurrent = lpcompare::ThreadPool::DefaultThreads();
+
+	std::vector<FILE*> workers(shards, nullptr);
+
+	auto launch = [&](unsigned shard) {
+		auto worker = command
+			+ " " + shell_quote(lpcompare::ShardWriter::ShardFilename(directory, "first", shard))
+			+ " " + shell_quote(lpcompare::ShardWriter::ShardFilename(directory, "second", shard))
+			+ (collect ? "" : " --counts-only");
+		workers[shard] = popen(worker.c_str(), "r");
+	};
+
+	START_TIMER;
+	for (unsigned i = 0; i < shards && i < concurrent; i++)
+		launch(i);
+
+	lpcompare::CompareResult result;
+
+	for (unsigned i = 0; i < shards; i++) {
+		bool merged = false;
+
+		if (workers[i] != nullptr) {
+			boost::iostreams::stream<boost::iostreams::file_descriptor_source> in(fileno(workers[i]), boost::iostreams::never_close_handle);
+			merged = lpcompare::ReadShardResult(in, result, sinks, std::cerr);
+			merged = pclose(workers[i]) == 0 && merged;
+		}
+
+		if (!merged) {
+			std::cerr << "Error: shard worker " << i << " failed" << std::endl;
+
+			// running workers still read the shard files.
+			for (unsigned j = i + 1; j < shards; j++) {
+				if (workers[j] != nullptr)
+					pclose(workers[j]);
+			}
+
+			remove_shards();
+			exit(1);
+		}
+
+		if (i + concurrent < shards)
+			launch(i + concurrent);
+	}
+	auto workers_sec = STOP_TIMER_SEC();
+
+	remove_shards();
+
+	generals.Print("Generals", result.Generals);
+	binaries.Print("Binaries", result.Binaries);
+	sosvars.Print("SosVars", result.SosVars);
+	bounds.Print("Bounds", result.Bounds);
+	constraints.Print("Constraints", result.Constraints);
+	cout << " Shards compared in " << workers_sec << " s" << endl;
+
+	write_patch_if_requested(result);
+
+	return 0;
+}
+
+/**
+Quotes an argument of a shell command so that the shell passes it on verbatim.
+
+\param argument Argument to quote.
+\return Quoted argument.
+*/
+std::string shell_quote(const std::string &argument) {
+#ifdef _WIN32
+	// cmd.exe does not expand inside double quotes, which cannot occur in Windows paths.
+	return "\"" + argument + "\"";
+#else
+	std::string quoted = "'";
+
+	for (char c : argument) {
+		if (c == '\'')
+			quoted += "'\\''";
+		else
+			quoted += c;
+	}
+
+	return quoted + "'";
+#endif
+}
+
+/**
+Parses arguments of a subcommand, printing usage on errors.
+
+\param argc argument count, starting with the subcommand.
+\param argv argument list, starting with the subcommand.
+\param desc Options of the subcommand.
+\param p Positional options of the subcommand.
+*/
+void setup_subcommand_options(int argc, char *argv [], const po::options_description &desc, const po::positional_options_description &p) {
+
+	try
+	{
+		po::store(po::command_line_parser(argc, argv).
+			options(desc).positional(p).run(), vm);
+
+		if (vm.count("help")) {
+			cout << desc << "\n";
+			exit(1);
+		}
+
+		po::notify(vm);
+	}
+	catch (po::error& e)
+	{
+		std::cerr << "Error: " << e.what() << std::endl << std::endl;
+
+		cout << desc << "\n";
+		exit(1);
+	}
+}
+
+/**
+Runs the comparison server: lpcompare serve [--socket path] [--cache-mb n] [--root dir] [--canonical].
+
+\return exit code.
+*/
+int run_serve(int argc, char *argv []) {
+
+	po::positional_options_description p;
+
+	po::options_description desc("Usage: lpcompare serve");
+	desc.add_options()
+		("help", "show usage information")
+		("socket", po::value<std::string>()->default_value("lpcompare.sock"), "unix domain socket to listen on")
+		("cache-mb", po::value<std::size_t>()->default_value(4096), "memory cap of the model cache in megabytes")
+		("threads", po::value<unsigned>()->default_value(0), "requests served at once, 0 for one per hardware thread")
+		("root", po::value<std::string>()->default_value("."), "directory that requested models and dump prefixes must be in")
+		("canonical", "compare constraints in canonical form, equal up to a positive or negative factor")
+		;
+
+	setup_subcommand_options(argc, argv, desc, p);
+
+	lpcompare::ModelCache cache(vm["cache-mb"].as<std::size_t>() * 1024 * 1024);
+	cache.Canonical = is_canonical_requested();
+	lpcompare::CompareServer server(cache, vm["threads"].as<unsigned>(), vm["root"].as<std::string>());
+
+	return server.Serve(vm["socket"].as<std::string>()) ? 0 : 1;
+}
+
+/**
+Sends a comparison request to a running server: lpcompare request first.lp second.lp [--socket path].
+
+\return exit code.
+*/
+int run_request(int argc, char *argv []) {
+
+	po::positional_options_description p;
+	p.add("first", 1);
+	p.add("second", 1);
+
+	po::options_description desc("Usage: lpcompare request");
+	desc.add_options()
+		("help", "show usage information")
+		("first", po::value<std::string>(&first_filename), "model 1 cplex lp file")
+		("second", po::value<std::string>(&second_filename), "model 2 cplex lp file")
+		("socket", po::value<std::string>()->default_value("lpcompare.sock"), "unix domain socket of the server")
+		("dump-prefix", po::value<std::string>(), "filename prefix for difference dumps written by the server")
+		("stats", "print model cache statistics of the server")
+		;
+
+	setup_subcommand_options(argc, argv, desc, p);
+
+	std::string request;
+
+	if (vm.count("stats")) {
+		request = "stats";
+	}
+	else if (!first_filename.empty() && !second_filename.empty()) {
+		// the server resolves paths relative to its own working directory.
+		request = "compare\t" + boost::filesystem::absolute(first_filename).string()
+			+ "\t" + boost::filesystem::absolute(second_filename).string();
+
+		if (vm.count("dump-prefix"))
+			request += "\t" + boost::filesystem::absolute(vm["dump-prefix"].as<std::string>()).string();
+	}
+	else {
+		std::cerr << "Error: two models are required" << std::endl << std::endl;
+		cout << desc << "\n";
+		exit(1);
+	}
+
+	return lpcompare::CompareServer::Request(vm["socket"].as<std::string>(), request, cout) ? 0 : 1;
+}
+
+/**
+Applies a patch written with --patch-out to a model: lpcompare apply base.lp patch out.lp.
+
+\return exit code.
+*/
+int run_apply(int argc, char *argv []) {
+
+	po::positional_options_description p;
+	p.add("base", 1);
+	p.add("patch", 1);
+	p.add("out", 1);
+
+	po::options_description desc("Usage: lpcompare apply");
+	desc.add_options()
+		("help", "show usage information")
+		("base", po::value<std::string>()->required(), "cplex lp file to patch")
+		("patch", po::value<std::string>()->required(), "patch file written with --patch-out")
+		("out", po::value<std::string>()->required(), "cplex lp file to write")
+		;
+
+	setup_subcommand_options(argc, argv, desc, p);
+
+	lpcompare::ModelPatch patch;
+
+	if (!patch.Read(vm["patch"].as<std::string>())) {
+		return 1;
+	}
+
+	if (!patch.Apply(vm["base"].as<std::string>(), vm["out"].as<std::string>(), cout)) {
+		return 1;
+	}
+
+	cout << "Patched model written to " << vm["out"].as<std::string>() << endl;
+
+	return 0;
+}
+
+/**
+Writes the fingerprint file of a model: lpcompare fingerprint model.lp [--out model.fp] [--buckets n] [--rows].
+
+\return exit code.
+*/
+int run_fingerprint(int argc, char *argv []) {
+
+	po::positional_options_description p;
+	p.add("model", 1);
+
+	po::options_description desc("Usage: lpcompare fingerprint");
+	desc.add_options()
+		("help", "show usage information")
+		("model", po::value<std::string>()->required(), "cplex lp file to fingerprint")
+		("out", po::value<std::string>(), "fingerprint file to write, model file with .fp extension by default")
+		("buckets", po::value<std::uint32_t>()->default_value(256), "hash buckets per section")
+		("rows", "keep the hash of every row to count differing rows")
+		;
+
+	setup_subcommand_options(argc, argv, desc, p);
+
+	INIT_TIMER;
+
+	auto model_filename = vm["model"].as<std::string>();
+	auto out_filename = vm.count("out") ? vm["out"].as<std::string>()
+		: boost::filesystem::path(model_filename).replace_extension(".fp").string();
+
+	lpcompare::ModelFingerprint fingerprint(vm["buckets"].as<std::uint32_t>(), vm.count("rows") > 0);
+
+	START_TIMER;
+	cout << "Reading model: " << model_filename << endl;
+
+	LPModel reader;
+	if (!reader.ReadModel(model_filename, fingerprint)) {
+		exit(1);
+	}
+	fingerprint.Finish();
+
+	auto model_read_sec = STOP_TIMER_SEC();
+	cout << " Model read in " << model_read_sec << " s" << endl;
+
+	if (!fingerprint.Write(out_filename)) {
+		exit(1);
+	}
+
+	cout << "Fingerprint written to " << out_filename << endl;
+
+	return 0;
+}
+
+/**
+Prints the differences of a section found from fingerprints.
+
+\param detail_name Given name of the detail.
+\param first Section of the first fingerprint.
+\param second Section of the second fingerprint.
+\param buckets Number of buckets per section.
+\return true if the section is equal.
+*/
+bool printFingerprintDiff(const std::string &detail_name, const lpcompare::SectionFingerprint &first, const lpcompare::SectionFingerprint &second, std::uint32_t buckets) {
+
+	cout << detail_name << " First Model: " << first.Total.Count << endl;
+	cout << detail_name << " Second Model: " << second.Total.Count << endl;
+
+	auto diff = lpcompare::ModelFingerprint::CompareSection(first, second);
+
+	if (diff.Equal) {
+		cout << detail_name << " are equivalent." << endl;
+		return true;
+	}
+
+	cout << detail_name << " differ in " << diff.Buckets.size() << " of " << buckets << " buckets:";
+
+	const std::size_t max_listed = 32;
+	for (std::size_t i = 0; i < diff.Buckets.size() && i < max_listed; i++)
+		cout << " " << diff.Buckets[i];
+	if (diff.Buckets.size() > max_listed)
+		cout << " ...";
+	cout << endl;
+
+	if (diff.RowsCompared) {
+		cout << detail_name << " First except Second: " << diff.FirstExceptSecondCount << endl;
+		cout << detail_name << " Second except First: " << diff.SecondExceptFirstCount << endl;
+	}
+
+	return false;
+}
+
+/**
+Compares two fingerprint files: lpcompare compare-fp first.fp second.fp.
+
+\return exit code, 0 if the models are equal, 2 if they differ.
+*/
+int run_compare_fp(int argc, char *argv []) {
+
+	po::positional_options_description p;
+	p.add("first", 1);
+	p.add("second", 1);
+
+	po::options_description desc("Usage: lpcompare compare-fp");
+	desc.add_options()
+		("help", "show usage information")
+		("first", po::value<std::string>(&first_filename)->required(), "fingerprint of model 1")
+		("second", po::value<std::string>(&second_filename)->required(), "fingerprint of model 2")
+		;
+
+	setup_subcommand_options(argc, argv, desc, p);
+
+	lpcompare::ModelFingerprint fingerprint1, fingerprint2;
+
+	if (!fingerprint1.Read(first_filename) || !fingerprint2.Read(second_filename)) {
+		exit(1);
+	}
+
+	if (fingerprint1.BucketCount() != fingerprint2.BucketCount()) {
+		std::cerr << "Error: fingerprints have different bucket counts, "
+			<< fingerprint1.BucketCount() << " and " << fingerprint2.BucketCount() << std::endl;
+		exit(1);
+	}
+
+	auto buckets = fingerprint1.BucketCount();
+
+	bool equal = printFingerprintDiff("Generals", fingerprint1.Generals, fingerprint2.Generals, buckets);
+	equal = printFingerprintDiff("Binaries", fingerprint1.Binaries, fingerprint2.Binaries, buckets) && equal;
+	equal = printFingerprintDiff("SosVars", fingerprint1.SosVars, fingerprint2.SosVars, buckets) && equal;
+	equal = printFingerprintDiff("Bounds", fingerprint1.Bounds, fingerprint2.Bounds, buckets) && equal;
+	equal = printFingerprintDiff("Constraints", fingerprint1.Constraints, fingerprint2.Constraints, buckets) && equal;
+
+	return equal ? 0 : 2;
+}
+
+/**
+Writes a model as a canonical LP file, sorted externally within a memory cap:
+lpcompare canonicalize in.lp out.lp [--memory-mb n] [--threads n] [--spill-dir dir] [--canonical].
+
+\return exit code.
+*/
+int run_canonicalize(int argc, char *argv []) {
+
+	po::positional_options_description p;
+	p.add("model", 1);
+	p.add("out", 1);
+
+	po::options_description desc("Usage: lpcompare canonicalize");
+	desc.add_options()
+		("help", "show usage information")
+		("model", po::value<std::string>()->required(), "cplex lp file to canonicalize")
+		("out", po::value<std::string>()->required(), "cplex lp file to write")
+		("memory-mb", po::value<std::size_t>()->default_value(1024), "estimated memory of elements sorted at once in megabytes, larger models are sorted in runs spilled to disk")
+		("threads", po::value<unsigned>()->default_value(0), "threads formatting and sorting runs, 0 for one per hardware thread")
+		("spill-dir", po::value<std::string>(), "directory for run files, the temporary directory by default")
+		("canonical", "also bring constraints to canonical form, equal up to a positive or negative factor")
+		;
+
+	setup_subcommand_options(argc, argv, desc, p);
+
+	if (vm["memory-mb"].as<std::size_t>() == 0) {
+		std::cerr << "Error: --memory-mb must be greater than 0" << std::endl;
+		return 1;
+	}
+
+	INIT_TIMER;
+
+	auto model_filename = vm["model"].as<std::string>();
+	auto out_filename = vm["out"].as<std::string>();
+
+	if (lpcompare::MpsReader::IsMpsFile(model_filename)) {
+		std::cerr << "Error: the objective of an MPS model is not read, canonicalize needs an LP file" << std::endl;
+		return 1;
+	}
+
+	lpcompare::CanonicalWriter writer(vm["memory-mb"].as<std::size_t>() * 1024 * 1024, vm["threads"].as<unsigned>(),
+		vm.count("spill-dir") ? vm["spill-dir"].as<std::string>() : "");
+
+	if (!LPModel::ReadObjective(model_filename, writer.Objective)) {
+		return 1;
+	}
+
+	START_TIMER;
+	cout << "Reading model: " << model_filename << endl;
+
+	LPModel reader;
+	reader.Canonical = vm.count("canonical") > 0;
+	if (!reader.ReadModel(model_filename, writer)) {
+		return 1;
+	}
+
+	if (!writer.Finish(out_filename)) {
+		return 1;
+	}
+
+	auto canonicalize_sec = STOP_TIMER_SEC();
+	cout << " Runs spilled: " << writer.RunCount() << endl;
+	cout << "Canonical model written to " << out_filename << " in " << canonicalize_sec << " s" << endl;
+
+	return 0;
+}
+
+/**
+Finds duplicate rows, parallel rows and duplicate bounds within a model: lpcompare analyze model.lp.
+
+\param argc argument count.
+\param argv argument list.
+\return 0 if none are found, 2 if any are found.
+*/
+int run_analyze(int argc, char *argv []) {
+
+	po::positional_options_description p;
+	p.add("model", 1);
+
+	po::options_description desc("Usage: lpcompare analyze");
+	desc.add_options()
+		("help", "show usage information")
+		("model", po::value<std::string>()->required(), "cplex lp or mps file to analyze")
+		("threads", po::value<unsigned>()->default_value(0), "threads hashing and grouping rows, 0 for one per hardware thread")
+		("parse-threads", po::value<unsigned>()->default_value(0), "parse the model on N threads while another thread reads it, 0 to read and parse on one thread")
+		("examples", po::value<std::size_t>()->default_value(3), "groups of each kind and elements per group to print")
+		("trace", po::value<std::string>(), "write a timeline of reading, hashing and grouping on every thread to a Chrome trace event JSON file")
+		;
+
+	setup_subcommand_options(argc, argv, desc, p);
+
+	if (vm.count("trace")) {
+		lpcompare::Trace::Enable();
+		std::atexit(write_trace);
+	}
+
+	INIT_TIMER;
+
+	auto model_filename = vm["model"].as<std::string>();
+
+	START_TIMER;
+	cout << "Reading model: " << model_filename << endl;
+
+	LPModel model;
+	model.ParseThreads = vm["parse-threads"].as<unsigned>();
+	if (!model.ReadModel(model_filename)) {
+		return 1;
+	}
+
+	printStats(&model);
+	auto model_read_sec = STOP_TIMER_SEC();
+	cout << " Model read in " << model_read_sec << " s" << endl;
+
+	START_TIMER;
+	lpcompare::ThreadPool pool(vm["threads"].as<unsigned>());
+	lpcompare::ModelAnalysis analysis(pool);
+	analysis.Analyze(model);
+
+	analysis.Write(model, vm["examples"].as<std::size_t>(), cout);
+	auto analyze_sec = STOP_TIMER_SEC();
+	cout << " Analysis completed in " << analyze_sec << " s" << endl;
+
+	return analysis.IsClean() ? 0 : 2;
+}
+
+/**
+Compares a pair of shard files for a sharded comparison and writes the result to stdout:
+lpcompare worker first.lp second.lp [--counts-only].
+
+\return exit code.
+*/
+int run_worker(int argc, char *argv []) {
+
+	po::positional_options_description p;
+	p.add("first", 1);
+	p.add("second", 1);
+
+	po::options_description desc("Usage: lpcompare worker");
+	desc.add_options()
+		("help", "show usage information")
+		("first", po::value<std::string>()->required(), "shard of the first model")
+		("second", po::value<std::string>()->required(), "shard of the second model")
+		("counts-only", "only count differences, do not return them")
+		;
+
+	setup_subcommand_options(argc, argv, desc, p);
+
+	LPModel first, second;
+	first.ReportProgress = false;
+	second.ReportProgress = false;
+
+	// stdout is the result, messages of the reader go to stderr.
+	auto result_buffer = cout.rdbuf(std::cerr.rdbuf());
+
+	if (!first.ReadModel(vm["first"].as<std::string>()) || !second.ReadModel(vm["second"].as<std::string>())) {
+		std::cerr << std::endl << "Error: cannot read shard files" << std::endl;
+		return 1;
+	}
+
+	lpcompare::CompareOptions options;
+	options.CollectDiffs = vm.count("counts-only") == 0;
+
+	auto result = lpcompare::Compare(first, second, options);
+
+	cout.rdbuf(result_buffer);
+	lpcompare::WriteShardResult(result, cout);
+
+	return cout.good() ? 0 : 1;
 }